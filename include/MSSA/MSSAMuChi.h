@@ -32,6 +32,8 @@
 
 #include "MSSA/MemRegion.h"
 
+#include <atomic>
+
 
 class MSSADEF;
 
@@ -44,7 +46,7 @@ public:
     typedef MSSADEF MSSADef;
 private:
     /// ver ID 0 is reserved
-    static Size_t totalVERNum;
+    static std::atomic<Size_t> totalVERNum;	///< versions are created by the parallel memory SSA workers too
     const MemRegion* mr;
     VERSION version;
     MRVERID vid;
@@ -45,7 +45,7 @@ typedef NodeID VERSION;
 class MemRegion {
 
 public:
-    typedef DdNode* Condition;
+    typedef CondExpr* Condition;
 private:
     /// region ID 0 is reserved
     static Size_t totalMRNum;
@@ -398,6 +398,12 @@ public:
     inline MRSet& getStoreMRSet(const StorePE* store) {
         return storesToMRsMap[store];
     }
+    inline bool hasLoadMRSet(const LoadPE* load) const {
+        return loadsToMRsMap.find(load)!=loadsToMRsMap.end();
+    }
+    inline bool hasStoreMRSet(const StorePE* store) const {
+        return storesToMRsMap.find(store)!=storesToMRsMap.end();
+    }
     inline bool hasRefMRSet(llvm::CallSite cs) {
         return callsiteToRefMRsMap.find(cs)!=callsiteToRefMRsMap.end();
     }
@@ -132,6 +132,9 @@ private:
     MemRegToVerStackMap mr2VerStackMap;
     MemRegToCounterMap mr2CounterMap;
 
+    /// A worker shares the memory regions and the statistics of its owner (see merge)
+    bool isWorker;
+
     /// The following three set are used for prune SSA phi insertion
     // (see algorithm in book Engineering A Compiler section 9.3)
     ///@{
@@ -278,6 +281,10 @@ public:
     /// Constructor
     MemSSA(BVDataPTAImpl* p);
 
+    /// Constructor of a worker building the memory SSA of some functions for owner,
+    /// so that disjoint sets of functions can be built in parallel
+    explicit MemSSA(MemSSA* owner);
+
     /// Destructor
     virtual ~MemSSA() {
         destroy();
@@ -297,6 +304,9 @@ public:
     /// We start from here
     virtual void buildMemSSA(const llvm::Function& fun,llvm::DominanceFrontier*, llvm::DominatorTree*);
 
+    /// Move the mus/chis/phis of a worker into this memory SSA, the worker is left empty
+    void merge(MemSSA& worker);
+
     /// Perform statistics
     void performStat();
 
@@ -88,6 +88,8 @@ public:
     typedef PAG::PAGEdgeSet PAGEdgeSet;
     typedef std::set<StoreSVFGNode*> StoreNodeSet;
     typedef std::map<const StorePE*,const StoreSVFGNode*> StorePEToSVFGNodeMap;
+    typedef CSRAdjacency<SVFGNode,SVFGEdge> SVFGCSR;
+    typedef SVFGCSR::Edge SVFGCSREdge;
 
 protected:
     NodeID totalSVFGNode;
@@ -107,6 +109,7 @@ protected:
     SVFGK kind;
     MemSSA* mssa;
     PointerAnalysis* pta;
+    SVFGCSR* csr;	///< CSR layout of the edges, built by freeze()
 
     /// Clean up memory
     void destroy();
@@ -138,6 +141,26 @@ public:
         mssa = NULL;
     }
 
+    /// Freeze the edges into a CSR layout whose records carry the call site ID
+    /// of call/ret edges, the layout is dropped (thawed) once a node or an edge changes.
+    /// The layout is a copy kept on top of the edge sets of the nodes, which the other
+    /// clients still use: freezing costs memory (two records of 24 bytes per edge and
+    /// 8 bytes per node on 64-bit hosts, see SVFGCSR::getMemUsage) for faster traversals.
+    //@{
+    void freeze();
+    inline void thaw() {
+        delete csr;
+        csr = NULL;
+    }
+    inline bool isFrozen() const {
+        return csr != NULL;
+    }
+    inline const SVFGCSR* getCSR() const {
+        assert(csr && "SVFG not frozen yet!");
+        return csr;
+    }
+    //@}
+
     /// Get SVFG kind
     inline SVFGK getKind() const {
         return kind;
@@ -182,6 +205,11 @@ public:
     }
     //@}
 
+    /// Get the call graph resolved by the pointer analysis
+    inline PTACallGraph* getPTACallGraph() const {
+        return pta->getPTACallGraph();
+    }
+
     /// Given a pagNode, return its definition site
     inline const SVFGNode* getDefSVFGNode(const PAGNode* pagNode) const {
         return getSVFGNode(getDef(pagNode));
@@ -274,12 +302,14 @@ public:
 protected:
     /// Remove a SVFG edge
     inline void removeSVFGEdge(SVFGEdge* edge) {
+        thaw();
         edge->getDstNode()->removeIncomingEdge(edge);
         edge->getSrcNode()->removeOutgoingEdge(edge);
         delete edge;
     }
     /// Remove a SVFGNode
     inline void removeSVFGNode(SVFGNode* node) {
+        thaw();
         removeGNode(node);
     }
 
@@ -382,6 +412,7 @@ protected:
 
     /// Add SVFG edge
     inline bool addSVFGEdge(SVFGEdge* edge) {
+        thaw();
         bool added1 = edge->getDstNode()->addIncomingEdge(edge);
         bool added2 = edge->getSrcNode()->addOutgoingEdge(edge);
         assert(added1 && added2 && "edge not added??");
@@ -453,6 +484,7 @@ protected:
 
     /// Add SVFG node
     virtual inline void addSVFGNode(SVFGNode* node) {
+        thaw();
         addGNode(node->getId(),node);
     }
     /// Add SVFG node for program statement
@@ -462,38 +494,38 @@ protected:
     /// Add Dummy SVFG node for null pointer definition
     /// To be noted for black hole pointer it has already has address edge connected
     inline void addNullPtrSVFGNode(const PAGNode* pagNode) {
-        NullPtrSVFGNode* sNode = new NullPtrSVFGNode(totalSVFGNode++,pagNode);
+        NullPtrSVFGNode* sNode = new (getArena()) NullPtrSVFGNode(totalSVFGNode++,pagNode);
         addSVFGNode(sNode);
         setDef(pagNode,sNode);
     }
     /// Add Address SVFG node
     inline void addAddrSVFGNode(const AddrPE* addr) {
-        AddrSVFGNode* sNode = new AddrSVFGNode(totalSVFGNode++,addr);
+        AddrSVFGNode* sNode = new (getArena()) AddrSVFGNode(totalSVFGNode++,addr);
         addStmtSVFGNode(sNode);
         setDef(addr->getDstNode(),sNode);
     }
     /// Add Copy SVFG node
     inline void addCopySVFGNode(const CopyPE* copy) {
-        CopySVFGNode* sNode = new CopySVFGNode(totalSVFGNode++,copy);
+        CopySVFGNode* sNode = new (getArena()) CopySVFGNode(totalSVFGNode++,copy);
         addStmtSVFGNode(sNode);
         setDef(copy->getDstNode(),sNode);
     }
     /// Add Gep SVFG node
     inline void addGepSVFGNode(const GepPE* gep) {
-        GepSVFGNode* sNode = new GepSVFGNode(totalSVFGNode++,gep);
+        GepSVFGNode* sNode = new (getArena()) GepSVFGNode(totalSVFGNode++,gep);
         addStmtSVFGNode(sNode);
         setDef(gep->getDstNode(),sNode);
     }
     /// Add Load SVFG node
     void addLoadSVFGNode(LoadPE* load) {
-        LoadSVFGNode* sNode = new LoadSVFGNode(totalSVFGNode++,load);
+        LoadSVFGNode* sNode = new (getArena()) LoadSVFGNode(totalSVFGNode++,load);
         addStmtSVFGNode(sNode);
         setDef(load->getDstNode(),sNode);
     }
     /// Add Store SVFG node,
     /// To be noted store does not create a new pointer, we do not set def for any PAG node
     void addStoreSVFGNode(StorePE* store) {
-        StoreSVFGNode* sNode = new StoreSVFGNode(totalSVFGNode++,store);
+        StoreSVFGNode* sNode = new (getArena()) StoreSVFGNode(totalSVFGNode++,store);
         assert(storePEToSVFGNodeMap.find(store)==storePEToSVFGNodeMap.end() && "should not insert twice!");
         storePEToSVFGNodeMap[store] = sNode;
         addStmtSVFGNode(sNode);
@@ -509,14 +541,14 @@ protected:
     /// To be noted that multiple actual parameters may have same value (PAGNode)
     /// So we need to make a pair <PAGNodeID,CallSiteID> to find the right SVFGParmNode
     inline void addActualParmSVFGNode(const PAGNode* aparm, llvm::CallSite cs) {
-        ActualParmSVFGNode* sNode = new ActualParmSVFGNode(totalSVFGNode++,aparm,cs);
+        ActualParmSVFGNode* sNode = new (getArena()) ActualParmSVFGNode(totalSVFGNode++,aparm,cs);
         addSVFGNode(sNode);
         PAGNodeToActualParmMap[std::make_pair(aparm->getId(),cs)] = sNode;
         /// do not set def here, this node is not a variable definition
     }
     /// Add formal parameter SVFG node
     inline void addFormalParmSVFGNode(const PAGNode* fparm, const llvm::Function* fun, CallPESet& callPEs) {
-        FormalParmSVFGNode* sNode = new FormalParmSVFGNode(totalSVFGNode++,fparm,fun);
+        FormalParmSVFGNode* sNode = new (getArena()) FormalParmSVFGNode(totalSVFGNode++,fparm,fun);
         addSVFGNode(sNode);
         for(CallPESet::const_iterator it = callPEs.begin(), eit=callPEs.end();
                 it!=eit; ++it)
@@ -529,7 +561,7 @@ protected:
     /// To be noted that here we assume returns of a procedure have already been unified into one
     /// Otherwise, we need to handle formalRet using <PAGNodeID,CallSiteID> pair to find FormalRetSVFG node same as handling actual parameters
     inline void addFormalRetSVFGNode(const PAGNode* ret, const llvm::Function* fun, RetPESet& retPEs) {
-        FormalRetSVFGNode* sNode = new FormalRetSVFGNode(totalSVFGNode++,ret,fun);
+        FormalRetSVFGNode* sNode = new (getArena()) FormalRetSVFGNode(totalSVFGNode++,ret,fun);
         addSVFGNode(sNode);
         for(RetPESet::const_iterator it = retPEs.begin(), eit=retPEs.end();
                 it!=eit; ++it)
@@ -540,14 +572,14 @@ protected:
     }
     /// Add callsite Receive SVFG node
     inline void addActualRetSVFGNode(const PAGNode* ret,llvm::CallSite cs) {
-        ActualRetSVFGNode* sNode = new ActualRetSVFGNode(totalSVFGNode++,ret,cs);
+        ActualRetSVFGNode* sNode = new (getArena()) ActualRetSVFGNode(totalSVFGNode++,ret,cs);
         addSVFGNode(sNode);
         setDef(ret,sNode);
         PAGNodeToActualRetMap[ret] = sNode;
     }
     /// Add llvm PHI SVFG node
     inline void addIntraPHISVFGNode(const PAGNode* phiResNode, PAG::PNodeBBPairList& oplist) {
-        IntraPHISVFGNode* sNode = new IntraPHISVFGNode(totalSVFGNode++,phiResNode);
+        IntraPHISVFGNode* sNode = new (getArena()) IntraPHISVFGNode(totalSVFGNode++,phiResNode);
         addSVFGNode(sNode);
         u32_t pos = 0;
         for(PAG::PNodeBBPairList::const_iterator it = oplist.begin(), eit=oplist.end(); it!=eit; ++it,++pos)
@@ -556,33 +588,33 @@ protected:
     }
     /// Add memory Function entry chi SVFG node
     inline void addFormalINSVFGNode(const MemSSA::ENTRYCHI* chi) {
-        FormalINSVFGNode* sNode = new FormalINSVFGNode(totalSVFGNode++,chi);
+        FormalINSVFGNode* sNode = new (getArena()) FormalINSVFGNode(totalSVFGNode++,chi);
         addSVFGNode(sNode);
         setDef(chi->getResVer(),sNode);
         funToFormalINMap[chi->getFunction()].set(sNode->getId());
     }
     /// Add memory Function return mu SVFG node
     inline void addFormalOUTSVFGNode(const MemSSA::RETMU* mu) {
-        FormalOUTSVFGNode* sNode = new FormalOUTSVFGNode(totalSVFGNode++,mu);
+        FormalOUTSVFGNode* sNode = new (getArena()) FormalOUTSVFGNode(totalSVFGNode++,mu);
         addSVFGNode(sNode);
         funToFormalOUTMap[mu->getFunction()].set(sNode->getId());
     }
     /// Add memory callsite mu SVFG node
     inline void addActualINSVFGNode(const MemSSA::CALLMU* mu) {
-        ActualINSVFGNode* sNode = new ActualINSVFGNode(totalSVFGNode++,mu, mu->getCallSite());
+        ActualINSVFGNode* sNode = new (getArena()) ActualINSVFGNode(totalSVFGNode++,mu, mu->getCallSite());
         addSVFGNode(sNode);
         callSiteToActualINMap[mu->getCallSite()].set(sNode->getId());
     }
     /// Add memory callsite chi SVFG node
     inline void addActualOUTSVFGNode(const MemSSA::CALLCHI* chi) {
-        ActualOUTSVFGNode* sNode = new ActualOUTSVFGNode(totalSVFGNode++,chi,chi->getCallSite());
+        ActualOUTSVFGNode* sNode = new (getArena()) ActualOUTSVFGNode(totalSVFGNode++,chi,chi->getCallSite());
         addSVFGNode(sNode);
         setDef(chi->getResVer(),sNode);
         callSiteToActualOUTMap[chi->getCallSite()].set(sNode->getId());
     }
     /// Add memory SSA PHI SVFG node
     inline void addIntraMSSAPHISVFGNode(const MemSSA::PHI* phi) {
-        IntraMSSAPHISVFGNode* sNode = new IntraMSSAPHISVFGNode(totalSVFGNode++,phi);
+        IntraMSSAPHISVFGNode* sNode = new (getArena()) IntraMSSAPHISVFGNode(totalSVFGNode++,phi);
         addSVFGNode(sNode);
         for(MemSSA::PHI::OPVers::const_iterator it = phi->opVerBegin(), eit=phi->opVerEnd(); it!=eit; ++it)
             sNode->setOpVer(it->first,it->second);
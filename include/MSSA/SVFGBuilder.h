@@ -58,6 +58,7 @@ public:
     typedef PointerAnalysis::CallEdgeMap CallEdgeMap;
     typedef PointerAnalysis::FunctionSet FunctionSet;
     typedef SVFG::SVFGEdgeSetTy SVFGEdgeSet;
+    typedef std::vector<llvm::Function*> FunctionList;
 
     /// Constructor
     SVFGBuilder(bool _SVFGWithIndCall = false): svfg(NULL), SVFGWithIndCall(_SVFGWithIndCall) {}
@@ -100,6 +101,8 @@ protected:
     virtual void releaseMemory(SVFG* graph);
     /// Update call graph using pre-analysis points-to results
     virtual void updateCallGraph(PointerAnalysis* pta);
+    /// Build the memory SSA of the functions in parallel (see -mssa-jobs)
+    void buildMemSSAInParallel(MemSSA& mssa, FunctionList& funs);
 
     /// SVFG Edges connected at indirect call/ret sites
     SVFGEdgeSet vfEdgesAtIndCallSite;
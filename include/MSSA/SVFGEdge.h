@@ -69,6 +69,15 @@ public:
     inline bool isRetVFGEdge() const {
         return getEdgeKind() == DirRet || getEdgeKind() == IndRet;
     }
+    /// Kind checks of the edge records of a frozen SVFG (see SVFG::freeze)
+    //@{
+    static inline bool isCallVFGEdgeKind(GEdgeKind k) {
+        return k == DirCall || k == IndCall;
+    }
+    static inline bool isRetVFGEdgeKind(GEdgeKind k) {
+        return k == DirRet || k == IndRet;
+    }
+    //@}
     inline bool isCallDirectVFGEdge() const {
         return getEdgeKind() == DirCall;
     }
@@ -268,14 +268,14 @@ private:
 
     /// Add inter PHI SVFG node for formal parameter
     inline InterPHISVFGNode* addInterPHIForFP(const FormalParmSVFGNode* fp) {
-        InterPHISVFGNode* sNode = new InterPHISVFGNode(totalSVFGNode++,fp);
+        InterPHISVFGNode* sNode = new (getArena()) InterPHISVFGNode(totalSVFGNode++,fp);
         addSVFGNode(sNode);
         resetDef(fp->getParam(),sNode);
         return sNode;
     }
     /// Add inter PHI SVFG node for actual return
     inline InterPHISVFGNode* addInterPHIForAR(const ActualRetSVFGNode* ar) {
-        InterPHISVFGNode* sNode = new InterPHISVFGNode(totalSVFGNode++,ar);
+        InterPHISVFGNode* sNode = new (getArena()) InterPHISVFGNode(totalSVFGNode++,ar);
         addSVFGNode(sNode);
         resetDef(ar->getRev(),sNode);
         return sNode;
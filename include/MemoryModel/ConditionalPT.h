@@ -142,6 +142,10 @@ public:
     inline void set(const Element& var) {
         elements.insert(var);
     }
+    /// Remove the element from set
+    inline void reset(const Element& var) {
+        elements.erase(var);
+    }
 
     /// Set size
     //@{
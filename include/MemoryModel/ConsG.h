@@ -259,7 +259,7 @@ public:
         NodeID gep =  pag->getGepObjNode(id,ls);
         /// Create a node when it is (1) not exist on graph and (2) not merged
         if(sccRepNode(gep)==gep && hasConstraintNode(gep)==false)
-            addConstraintNode(new ConstraintNode(gep),gep);
+            addConstraintNode(new (getArena()) ConstraintNode(gep),gep);
         return gep;
     }
     /// Get a field-insensitive node of a memory object
@@ -267,7 +267,7 @@ public:
         NodeID fi = pag->getFIObjNode(id);
         /// Create a node when it is (1) not exist on graph and (2) not merged
         if (sccRepNode(fi) == fi && hasConstraintNode(fi)==false)
-            addConstraintNode(new ConstraintNode(fi),fi);
+            addConstraintNode(new (getArena()) ConstraintNode(fi),fi);
         return fi;
     }
     //@}
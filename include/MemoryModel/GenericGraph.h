@@ -31,8 +31,11 @@
 #define GENERICGRAPH_H_
 
 #include "Util/BasicTypes.h"
+#include "Util/GraphArena.h"
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/STLExtras.h>			// for mapped_iter
+#include <algorithm>
+#include <vector>
 
 
 /*!
@@ -65,6 +68,22 @@ public:
     virtual ~GenericEdge() {
     }
 
+    /// Allocation, new (graph->getArena()) takes the object from the arena of its graph
+    //@{
+    static inline void* operator new(size_t size, GraphArena& arena) {
+        return arena.allocate(size);
+    }
+    static inline void* operator new(size_t size) {
+        return GraphArena::allocateUnowned(size);
+    }
+    static inline void operator delete(void* p, size_t size) {
+        GraphArena::deallocate(p, size);
+    }
+    /// only called if a constructor throws, the slot goes with the arena
+    static inline void operator delete(void*, GraphArena&) {
+    }
+    //@}
+
     ///  get methods of the components
     //@{
     inline NodeID getSrcID() const {
@@ -147,6 +166,22 @@ public:
             delete *it;
     }
 
+    /// Allocation, new (graph->getArena()) takes the object from the arena of its graph
+    //@{
+    static inline void* operator new(size_t size, GraphArena& arena) {
+        return arena.allocate(size);
+    }
+    static inline void* operator new(size_t size) {
+        return GraphArena::allocateUnowned(size);
+    }
+    static inline void operator delete(void* p, size_t size) {
+        GraphArena::deallocate(p, size);
+    }
+    /// only called if a constructor throws, the slot goes with the arena
+    static inline void operator delete(void*, GraphArena&) {
+    }
+    //@}
+
     /// Get ID
     inline NodeID getId() const {
         return id;
@@ -358,6 +393,11 @@ public:
         IDToNodeMap.erase(it);
     }
 
+    /// Arena of the nodes and edges, released after they are deleted
+    inline GraphArena& getArena() {
+        return arena;
+    }
+
     /// Get total number of node/edge
     inline Size_t getTotalNodeNum() const {
         return nodeNum;
@@ -374,6 +414,7 @@ public:
     }
 
 protected:
+    GraphArena arena;	///< nodes and edges of the graph, released once they are deleted
     IDToNodeMapTy IDToNodeMap; ///< node map
 
 public:
@@ -382,6 +423,108 @@ public:
 };
 
 
+/*!
+ * Read-only compressed sparse row (CSR) copy of the edges of a generic graph.
+ * The out (in) edges of node n are the records [outOffsets[n], outOffsets[n+1])
+ * of one flat array, grouped by edge kind. A record keeps the node at the other
+ * end and an attribute of the edge (e.g. the call site of an SVFG edge) inline,
+ * so that a traversal neither walks the std::set of edges nor dereferences them.
+ * The copy is stale once an edge is added or removed, the graph owning it has to drop it.
+ */
+template<class NodeTy,class EdgeTy>
+class CSRAdjacency {
+
+public:
+    typedef typename EdgeTy::GEdgeKind GEdgeKind;
+
+    /// Edge record
+    struct Edge {
+        EdgeTy* edge;	///< the edge on the graph
+        NodeTy* node;	///< dst node of an out edge, src node of an in edge
+        GEdgeKind kind;	///< edge kind
+        u32_t attr;		///< inline attribute of the edge
+    };
+    typedef const Edge* const_iterator;
+
+    /// Build the layout of graph, attr(edge) gives the attribute of an edge
+    template<class AttrFn>
+    CSRAdjacency(GenericGraph<NodeTy,EdgeTy>* graph, AttrFn attr) {
+        NodeID maxId = 0;
+        for (typename GenericGraph<NodeTy,EdgeTy>::iterator it = graph->begin(), eit = graph->end(); it != eit; ++it)
+            maxId = std::max(maxId, it->first);
+        outOffsets.assign(maxId + 2, 0);
+        inOffsets.assign(maxId + 2, 0);
+
+        /// count the edges of each node, then turn the counts into offsets
+        for (typename GenericGraph<NodeTy,EdgeTy>::iterator it = graph->begin(), eit = graph->end(); it != eit; ++it) {
+            outOffsets[it->first + 1] = it->second->getOutEdges().size();
+            inOffsets[it->first + 1] = it->second->getInEdges().size();
+        }
+        for (NodeID id = 1; id < outOffsets.size(); ++id) {
+            outOffsets[id] += outOffsets[id - 1];
+            inOffsets[id] += inOffsets[id - 1];
+        }
+        outEdges.resize(outOffsets.back());
+        inEdges.resize(inOffsets.back());
+
+        for (typename GenericGraph<NodeTy,EdgeTy>::iterator it = graph->begin(), eit = graph->end(); it != eit; ++it) {
+            fill(it->second->getOutEdges(), &outEdges[0] + outOffsets[it->first], true, attr);
+            fill(it->second->getInEdges(), &inEdges[0] + inOffsets[it->first], false, attr);
+        }
+    }
+
+    /// Edges of a node
+    //@{
+    inline const_iterator outBegin(NodeID id) const {
+        return outEdges.data() + outOffsets[id];
+    }
+    inline const_iterator outEnd(NodeID id) const {
+        return outEdges.data() + outOffsets[id + 1];
+    }
+    inline const_iterator inBegin(NodeID id) const {
+        return inEdges.data() + inOffsets[id];
+    }
+    inline const_iterator inEnd(NodeID id) const {
+        return inEdges.data() + inOffsets[id + 1];
+    }
+    //@}
+
+    /// Number of edge records, counted once per direction
+    inline Size_t getEdgeNum() const {
+        return outEdges.size();
+    }
+
+    /// Bytes taken by the layout
+    inline Size_t getMemUsage() const {
+        return (outOffsets.capacity() + inOffsets.capacity()) * sizeof(u32_t)
+               + (outEdges.capacity() + inEdges.capacity()) * sizeof(Edge);
+    }
+
+private:
+    /// Copy a set of edges to the records starting at rec, stable-sorted by kind
+    template<class EdgeSetTy, class AttrFn>
+    static void fill(const EdgeSetTy& edges, Edge* rec, bool out, AttrFn& attr) {
+        Edge* begin = rec;
+        for (typename EdgeSetTy::const_iterator it = edges.begin(), eit = edges.end(); it != eit; ++it, ++rec) {
+            EdgeTy* edge = *it;
+            rec->edge = edge;
+            rec->node = out ? edge->getDstNode() : edge->getSrcNode();
+            rec->kind = edge->getEdgeKind();
+            rec->attr = attr(edge);
+        }
+        std::stable_sort(begin, rec, lessKind);
+    }
+    static inline bool lessKind(const Edge& lhs, const Edge& rhs) {
+        return lhs.kind < rhs.kind;
+    }
+
+    std::vector<u32_t> outOffsets;	///< offsets of the out edges, indexed by node ID
+    std::vector<u32_t> inOffsets;	///< offsets of the in edges, indexed by node ID
+    std::vector<Edge> outEdges;		///< out edge records
+    std::vector<Edge> inEdges;		///< in edge records
+};
+
+
 /* !
  * GraphTraits specializations for generic graph algorithms.
  * Provide graph traits for tranversing from a node using standard graph traversals.
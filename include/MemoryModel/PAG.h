@@ -517,7 +517,7 @@ public:
     }
     /// Add a value (pointer) node
     inline NodeID addValNode(const llvm::Value* val, NodeID i) {
-        PAGNode *node = new ValPN(val,i);
+        PAGNode *node = new (getArena()) ValPN(val,i);
         return addValNode(val, node, i);
     }
     /// Add a memory obj node
@@ -528,12 +528,12 @@ public:
     }
     /// Add a unique return node for a procedure
     inline NodeID addRetNode(const llvm::Function* val, NodeID i) {
-        PAGNode *node = new RetPN(val,i);
+        PAGNode *node = new (getArena()) RetPN(val,i);
         return addRetNode(val, node, i);
     }
     /// Add a unique vararg node for a procedure
     inline NodeID addVarargNode(const llvm::Function* val, NodeID i) {
-        PAGNode *node = new VarArgPN(val,i);
+        PAGNode *node = new (getArena()) VarArgPN(val,i);
         return addNode(node,i);
     }
     /// Add a temp field value node, this method can only invoked by getGepValNode
@@ -550,17 +550,17 @@ public:
         return addDummyValNode(nodeNum);
     }
     inline NodeID addDummyValNode(NodeID i) {
-        return addValNode(NULL, new DummyValPN(i), i);
+        return addValNode(NULL, new (getArena()) DummyValPN(i), i);
     }
     inline NodeID addDummyObjNode() {
         const MemObj* mem = SymbolTableInfo::Symbolnfo()->createDummyObj(nodeNum);
-        return addObjNode(NULL, new DummyObjPN(nodeNum,mem), nodeNum);
+        return addObjNode(NULL, new (getArena()) DummyObjPN(nodeNum,mem), nodeNum);
     }
     inline NodeID addBlackholeObjNode() {
-        return addObjNode(NULL, new DummyObjPN(getBlackHoleNode(),getBlackHoleObj()), getBlackHoleNode());
+        return addObjNode(NULL, new (getArena()) DummyObjPN(getBlackHoleNode(),getBlackHoleObj()), getBlackHoleNode());
     }
     inline NodeID addConstantObjNode() {
-        return addObjNode(NULL, new DummyObjPN(getConstantNode(),getConstantObj()), getConstantNode());
+        return addObjNode(NULL, new (getArena()) DummyObjPN(getConstantNode(),getConstantObj()), getConstantNode());
     }
     inline NodeID addBlackholePtrNode() {
         return addDummyValNode(getBlkPtr());
@@ -402,6 +402,9 @@ public:
     typedef DiffPTData<NodeID,PointsTo,EdgeID> DiffPTDataTy;	/// Points-to data structure type
     typedef DFPTData<NodeID,PointsTo> DFPTDataTy;	/// Points-to data structure type
     typedef IncDFPTData<NodeID,PointsTo> IncDFPTDataTy;	/// Points-to data structure type
+    typedef HashConsPTData<NodeID,PointsTo> HashConsPTDataTy;	/// Points-to data structure type
+    typedef DensePTData<PointsTo> DensePTDataTy;	/// Points-to data structure type
+    typedef DenseDiffPTData<PointsTo,EdgeID> DenseDiffPTDataTy;	/// Points-to data structure type
 
     /// Constructor
     BVDataPTAImpl(PointerAnalysis::PTATY type);
@@ -415,14 +418,19 @@ public:
     inline void destroy() {
         delete ptD;
         ptD = NULL;
+        mapPtD = NULL;
     }
 
     /// Get points-to and reverse points-to
     ///@{
     virtual inline PointsTo& getPts(NodeID id) {
+        if (mapPtD)
+            return mapPtD->getMapPts(id);
         return ptD->getPts(id);
     }
     virtual inline PointsTo& getRevPts(NodeID nodeId) {
+        if (mapPtD)
+            return mapPtD->getMapRevPts(nodeId);
         return ptD->getRevPts(nodeId);
     }
     //@}
@@ -430,12 +438,25 @@ public:
     /// Expand FI objects
     void expandFIObjs(const PointsTo& pts, PointsTo& expandedPts);
 
+    /// Get the hash-consed points-to data for statistics, NULL if the sets are not shared
+    inline const HashConsPTDataTy* getHashConsPTDataTy() const {
+        return llvm::dyn_cast<HashConsPTDataTy>(ptD);
+    }
+
     /// Interface for analysis result storage on filesystem.
     //@{
     virtual void writeToFile(const std::string& filename);
     virtual bool readFromFile(const std::string& filename);
     //@}
 
+    /// Binary result cache stamped with a fingerprint of the module and the options.
+    /// The fingerprint is taken from the freshly built PAG, before solving.
+    //@{
+    u64_t getResultFingerprint() const;
+    void writeToBinaryFile(const std::string& filename, u64_t fingerprint);
+    bool readFromBinaryFile(const std::string& filename, u64_t fingerprint);
+    //@}
+
 protected:
 
     /// Update callgraph. This should be implemented by its subclass.
@@ -459,12 +480,18 @@ protected:
     /// To be noted that adding reverse pts might incur 10% total overhead during solving
     //@{
     virtual inline bool unionPts(NodeID id, const PointsTo& target) {
+        if (mapPtD)
+            return mapPtD->unionMapPts(id, target);
         return ptD->unionPts(id, target);
     }
     virtual inline bool unionPts(NodeID id, NodeID ptd) {
+        if (mapPtD)
+            return mapPtD->unionMapPts(id,ptd);
         return ptD->unionPts(id,ptd);
     }
     virtual inline bool addPts(NodeID id, NodeID ptd) {
+        if (mapPtD)
+            return mapPtD->addMapPts(id,ptd);
         return ptD->addPts(id,ptd);
     }
     //@}
@@ -480,6 +507,9 @@ protected:
 private:
     /// Points-to data
     PTDataTy* ptD;
+    /// ptD when its sets are in the maps of PTData (the default and the diff data),
+    /// they are then accessed without the virtual calls of the other data structures
+    PTDataTy* mapPtD;
 
 public:
     /// Interface expose to users of our pointer analysis, given Location infos
@@ -175,13 +175,13 @@ public:
     /// Override the methods defined in PTData.
     /// Union/add points-to without adding reverse points-to, used internally
     //@{
-    inline bool addPts(const Key &dstKey, const Key& srcKey) {
-        return addPts(this->getPts(dstKey),srcKey);
+    virtual inline bool addPts(const Key &dstKey, const Key& srcKey) {
+        return PTData<Key,Data>::addPts(this->getPts(dstKey),srcKey);
     }
-    inline bool unionPts(const Key& dstKey, const Key& srcKey) {
+    virtual inline bool unionPts(const Key& dstKey, const Key& srcKey) {
         return unionPts(this->getPts(dstKey),this->getPts(srcKey));
     }
-    inline bool unionPts(const Key& dstKey, const Data& srcData) {
+    virtual inline bool unionPts(const Key& dstKey, const Data& srcData) {
         return unionPts(this->getPts(dstKey),srcData);
     }
     //@}
@@ -34,6 +34,9 @@
 
 #include "MemoryModel/ConditionalPT.h"
 #include "Util/AnalysisUtil.h"
+#include <llvm/ADT/DenseMap.h>
+#include <deque>
+#include <unordered_map>
 
 /// Overloading operator << for dumping conditional variable
 //@{
@@ -66,6 +69,8 @@ public:
         DFPTD,
         IncDFPTD,
         DiffPTD,
+        HashConsPTD,
+        DensePTD,
         Default
     };
     /// Constructor
@@ -88,40 +93,73 @@ public:
     }
 
     /// Return Points-to map
-    inline const PtsMap& getPtsMap() const {
+    virtual inline const PtsMap& getPtsMap() const {
         return ptsMap;
     }
 
     // Get conditional points-to set of the pointer
-    inline Data& getPts(const Key& var) {
+    virtual inline Data& getPts(const Key& var) {
         return ptsMap[var];
     }
 
     // Get conditional reverse points-to set of the pointer
-    inline Data& getRevPts(const Key& var) {
+    virtual inline Data& getRevPts(const Key& var) {
         return revPtsMap[var];
     }
 
     /// Union/add points-to, used internally
     //@{
-    inline bool addPts(const Key &dstKey, const Key& srcKey) {
+    virtual inline bool addPts(const Key &dstKey, const Key& srcKey) {
         addSingleRevPts(getRevPts(srcKey),dstKey);
         return addPts(getPts(dstKey),srcKey);
     }
-    inline bool unionPts(const Key& dstKey, const Key& srcKey) {
+    virtual inline bool unionPts(const Key& dstKey, const Key& srcKey) {
         addRevPts(getPts(srcKey),dstKey);
         return unionPts(getPts(dstKey),getPts(srcKey));
     }
-    inline bool unionPts(const Key& dstKey, const Data& srcData) {
+    virtual inline bool unionPts(const Key& dstKey, const Data& srcData) {
         addRevPts(srcData,dstKey);
         return unionPts(getPts(dstKey),srcData);
     }
+    //@}
+
+    /// Remove a points-to target, the reverse points-to is kept
+    virtual inline bool removePts(const Key& dstKey, const Key& srcKey) {
+        Data& pts = getPts(dstKey);
+        if (!pts.test(srcKey))
+            return false;
+        pts.reset(srcKey);
+        return true;
+    }
+
+    /// Get/union/add points-to in the maps of this class, without virtual calls.
+    /// Only for a data structure whose sets are kept in these maps (see BVDataPTAImpl)
+    //@{
+    inline Data& getMapPts(const Key& var) {
+        return ptsMap[var];
+    }
+    inline Data& getMapRevPts(const Key& var) {
+        return revPtsMap[var];
+    }
+    inline bool addMapPts(const Key &dstKey, const Key& srcKey) {
+        addSingleRevPts(revPtsMap[srcKey],dstKey);
+        return addPts(ptsMap[dstKey],srcKey);
+    }
+    inline bool unionMapPts(const Key& dstKey, const Key& srcKey) {
+        Data& srcData = ptsMap[srcKey];
+        addMapRevPts(srcData,dstKey);
+        return unionPts(ptsMap[dstKey],srcData);
+    }
+    inline bool unionMapPts(const Key& dstKey, const Data& srcData) {
+        addMapRevPts(srcData,dstKey);
+        return unionPts(ptsMap[dstKey],srcData);
+    }
+    //@}
 
 protected:
     PtsMap ptsMap;
     PtsMap revPtsMap;
 
-private:
     /// Union/add points-to
     //@{
     inline bool unionPts(Data& dstData, const Data& srcData) {
@@ -137,8 +175,13 @@ private:
         for(iterator it = ptsData.begin(), eit = ptsData.end(); it!=eit; ++it)
             addSingleRevPts(getRevPts(*it),tgr);
     }
+    inline void addMapRevPts(const Data &ptsData, const Key& tgr) {
+        for(iterator it = ptsData.begin(), eit = ptsData.end(); it!=eit; ++it)
+            addSingleRevPts(revPtsMap[*it],tgr);
+    }
     //@}
 
+private:
     PTDataTY ptdTy;
 
 public:
@@ -184,11 +227,11 @@ public:
     ~DiffPTData() {}
 
     /// Get diff points to.
-    inline Data & getDiffPts(Key& var) {
+    virtual inline Data & getDiffPts(Key& var) {
         return diffPtsMap[var];
     }
     /// Get propagated points to.
-    inline Data & getPropaPts(Key& var) {
+    virtual inline Data & getPropaPts(Key& var) {
         return propaPtsMap[var];
     }
 
@@ -250,4 +293,381 @@ private:
     CahcePtsMap CacheMap;	///< points-to processed at load/store edge
 };
 
+/*!
+ * Points-to sets indexed by dense node IDs, the storage grows with the largest ID seen.
+ * A deque keeps the sets in place when it grows, so the references handed out stay
+ * valid as the ones into a std::map do. Accessing an ID already covered does not
+ * change the container, the keys are only recorded on demand for dumping.
+ */
+template<class Data>
+class DensePtsVec {
+public:
+    typedef std::map<const NodeID, Data> PtsMap;
+
+    /// Constructor, trackKeys records the accessed IDs for collect()
+    DensePtsVec(bool track = false): trackKeys(track) {
+    }
+
+    inline Data& operator[](NodeID id) {
+        if (id >= sets.size()) {
+            sets.resize(id + 1);
+            if (trackKeys)
+                keys.resize(id + 1, false);
+        }
+        if (trackKeys)
+            keys[id] = true;
+        return sets[id];
+    }
+
+    inline void clear() {
+        sets.clear();
+        keys.clear();
+    }
+
+    /// Copy the sets of the accessed IDs into a map
+    inline void collect(PtsMap& map) const {
+        map.clear();
+        for (NodeID id = 0; id < keys.size(); ++id) {
+            if (keys[id])
+                map[id] = sets[id];
+        }
+    }
+
+private:
+    std::deque<Data> sets;
+    std::vector<bool> keys;
+    bool trackKeys;
+};
+
+/*!
+ * Points-to data for node IDs backed by dense vectors (see -dense-pts)
+ * The reverse points-to sets are dense as well, the points-to map is only
+ * built when it is dumped or written.
+ */
+template<class Data>
+class DensePTData : public PTData<NodeID,Data> {
+public:
+    typedef typename PTData<NodeID,Data>::PtsMap PtsMap;
+    typedef typename PTData<NodeID,Data>::PTDataTY PTDataTy;
+
+    /// Constructor
+    DensePTData(PTDataTy ty = (PTData<NodeID,Data>::DensePTD)): PTData<NodeID,Data>(ty), densePts(true) {
+    }
+
+    /// Destructor
+    virtual ~DensePTData() {}
+
+    virtual void clear() {
+        PTData<NodeID,Data>::clear();
+        densePts.clear();
+        denseRevPts.clear();
+    }
+
+    virtual inline const PtsMap& getPtsMap() const {
+        densePts.collect(materializedMap);
+        return materializedMap;
+    }
+
+    virtual inline Data& getPts(const NodeID& var) {
+        return densePts[var];
+    }
+    virtual inline Data& getRevPts(const NodeID& var) {
+        return denseRevPts[var];
+    }
+
+    /// Methods for support type inquiry through isa, cast, and dyn_cast:
+    //@{
+    static inline bool classof(const DensePTData<Data> *) {
+        return true;
+    }
+    static inline bool classof(const PTData<NodeID,Data>* ptd) {
+        return ptd->getPTDTY() == PTData<NodeID,Data>::DensePTD;
+    }
+    //@}
+
+    virtual inline void dumpPTData() {
+        this->dumpPts(getPtsMap());
+    }
+
+private:
+    DensePtsVec<Data> densePts;
+    DensePtsVec<Data> denseRevPts;
+    mutable PtsMap materializedMap;
+};
+
+/*!
+ * Diff points-to data for node IDs backed by dense vectors (see -dense-pts)
+ * It is still a DiffPTD, the cached points-to of the edges is kept in the map.
+ */
+template<class Data, class CacheKey>
+class DenseDiffPTData : public DiffPTData<NodeID,Data,CacheKey> {
+public:
+    typedef typename PTData<NodeID,Data>::PtsMap PtsMap;
+
+    /// Constructor
+    DenseDiffPTData(): densePts(true) {
+    }
+
+    /// Destructor
+    virtual ~DenseDiffPTData() {}
+
+    virtual void clear() {
+        PTData<NodeID,Data>::clear();
+        densePts.clear();
+        denseRevPts.clear();
+        denseDiffPts.clear();
+        densePropaPts.clear();
+    }
+
+    virtual inline const PtsMap& getPtsMap() const {
+        densePts.collect(materializedMap);
+        return materializedMap;
+    }
+
+    virtual inline Data& getPts(const NodeID& var) {
+        return densePts[var];
+    }
+    virtual inline Data& getRevPts(const NodeID& var) {
+        return denseRevPts[var];
+    }
+    virtual inline Data& getDiffPts(NodeID& var) {
+        return denseDiffPts[var];
+    }
+    virtual inline Data& getPropaPts(NodeID& var) {
+        return densePropaPts[var];
+    }
+
+    virtual inline void dumpPTData() {
+        this->dumpPts(getPtsMap());
+    }
+
+private:
+    DensePtsVec<Data> densePts;
+    DensePtsVec<Data> denseRevPts;
+    DensePtsVec<Data> denseDiffPts;
+    DensePtsVec<Data> densePropaPts;
+    mutable PtsMap materializedMap;
+};
+
+/*!
+ * Hash-consed points-to data (see -hash-pts)
+ * Identical points-to sets are interned and shared by their keys: a key maps to the
+ * ID of an immutable set, an update gives the key the ID of the new set, and the
+ * unions of two IDs are memoized. The sets returned by getPts are shared and must
+ * not be changed in place, updates go through addPts/unionPts/removePts. Each set
+ * keeps the hash it was interned with, debug builds assert it on every use.
+ * The reverse points-to sets are not interned and kept in the base map.
+ */
+template<class Key, class Data>
+class HashConsPTData : public PTData<Key,Data> {
+public:
+    typedef typename PTData<Key,Data>::PtsMap PtsMap;
+    typedef typename PTData<Key,Data>::PTDataTY PTDataTy;
+    typedef typename Data::iterator iterator;
+    typedef u32_t PtsID;
+
+    /// Constructor
+    HashConsPTData(PTDataTy ty = (PTData<Key,Data>::HashConsPTD)): PTData<Key,Data>(ty) {
+        reset();
+    }
+
+    /// Destructor
+    virtual ~HashConsPTData() {}
+
+    /// Clear maps
+    virtual void clear() {
+        PTData<Key,Data>::clear();
+        reset();
+    }
+
+    /// Points-to map built from the interned sets, for dumping only
+    virtual inline const PtsMap& getPtsMap() const {
+        materializedMap.clear();
+        for (typename KeyToIDMap::const_iterator it = keyToID.begin(), eit = keyToID.end(); it != eit; ++it)
+            materializedMap[it->first] = getSet(it->second);
+        return materializedMap;
+    }
+
+    /// Get the shared points-to set of a key, read only.
+    /// The reference is only mutable for the PTData interface, a write through it
+    /// is caught by the assertion of getSet.
+    virtual inline Data& getPts(const Key& var) {
+        return const_cast<Data&>(getSet(keyToID[var]));
+    }
+
+    /// Union/add points-to, the reverse points-to is only updated when the set changes
+    //@{
+    virtual inline bool addPts(const Key &dstKey, const Key& srcKey) {
+        PtsID& dst = keyToID[dstKey];
+        if (getSet(dst).test(srcKey))
+            return false;
+        Data pts = getSet(dst);
+        pts.set(srcKey);
+        dst = intern(pts);
+        this->addSingleRevPts(this->getRevPts(srcKey),dstKey);
+        return true;
+    }
+    virtual inline bool unionPts(const Key& dstKey, const Key& srcKey) {
+        return unionID(dstKey, keyToID[srcKey]);
+    }
+    virtual inline bool unionPts(const Key& dstKey, const Data& srcData) {
+        /// a set got from getPts is already interned
+        typename SetToIDMap::const_iterator it = setToID.find(&srcData);
+        if (it != setToID.end())
+            return unionID(dstKey, it->second);
+
+        PtsID& dst = keyToID[dstKey];
+        Data pts = getSet(dst);
+        if ((pts |= srcData) == false)
+            return false;
+        dst = intern(pts);
+        this->addRevPts(srcData,dstKey);
+        return true;
+    }
+    //@}
+
+    virtual inline bool removePts(const Key& dstKey, const Key& srcKey) {
+        PtsID& dst = keyToID[dstKey];
+        if (!getSet(dst).test(srcKey))
+            return false;
+        Data pts = getSet(dst);
+        pts.reset(srcKey);
+        dst = intern(pts);
+        return true;
+    }
+
+    /// Statistics
+    //@{
+    inline u32_t getKeyNum() const {
+        return keyToID.size();
+    }
+    inline u32_t getPtsSetNum() const {
+        return ptsSets.size();
+    }
+    /// Targets stored in the interned sets
+    inline u32_t getSharedTargetNum() const {
+        u32_t num = 0;
+        for (typename std::deque<Data>::const_iterator it = ptsSets.begin(), eit = ptsSets.end(); it != eit; ++it)
+            num += it->count();
+        return num;
+    }
+    /// Targets the keys would store without sharing
+    inline u32_t getTotalTargetNum() const {
+        u32_t num = 0;
+        for (typename KeyToIDMap::const_iterator it = keyToID.begin(), eit = keyToID.end(); it != eit; ++it)
+            num += getSet(it->second).count();
+        return num;
+    }
+    inline u32_t getUnionLookups() const {
+        return unionLookups;
+    }
+    inline u32_t getUnionHits() const {
+        return unionHits;
+    }
+    //@}
+
+    /// Methods for support type inquiry through isa, cast, and dyn_cast:
+    //@{
+    static inline bool classof(const HashConsPTData<Key,Data> *) {
+        return true;
+    }
+    static inline bool classof(const PTData<Key,Data>* ptd) {
+        return ptd->getPTDTY() == PTData<Key,Data>::HashConsPTD;
+    }
+    //@}
+
+    virtual inline void dumpPTData() {
+        this->dumpPts(getPtsMap());
+    }
+
+private:
+    typedef llvm::DenseMap<Key, PtsID> KeyToIDMap;
+    typedef llvm::DenseMap<const Data*, PtsID> SetToIDMap;
+    typedef llvm::DenseMap<std::pair<PtsID, PtsID>, PtsID> UnionCache;
+    typedef std::unordered_map<size_t, llvm::SmallVector<PtsID, 1> > HashToIDsMap;
+
+    std::deque<Data> ptsSets;	///< interned sets indexed by their IDs, 0 is the empty set
+    std::vector<size_t> ptsHashes;	///< hash of each interned set when it was added
+    KeyToIDMap keyToID;
+    SetToIDMap setToID;			///< ID of an interned set from its address
+    HashToIDsMap hashToIDs;		///< IDs of the interned sets with the same hash
+    UnionCache unionCache;		///< union of two IDs, the smaller ID first
+    u32_t unionLookups;
+    u32_t unionHits;
+    mutable PtsMap materializedMap;
+
+    inline void reset() {
+        ptsSets.clear();
+        ptsHashes.clear();
+        keyToID.clear();
+        setToID.clear();
+        hashToIDs.clear();
+        unionCache.clear();
+        unionLookups = 0;
+        unionHits = 0;
+        intern(Data());
+    }
+
+    static inline size_t hashPts(const Data& pts) {
+        size_t h = pts.count();
+        for (iterator it = pts.begin(), eit = pts.end(); it != eit; ++it)
+            h = h * 31 + *it;
+        return h;
+    }
+
+    /// Get an interned set, it must not have been changed since it was added
+    inline const Data& getSet(PtsID id) const {
+        assert(hashPts(ptsSets[id]) == ptsHashes[id] && "interned points-to set changed in place!");
+        return ptsSets[id];
+    }
+
+    /// Get the ID of a set, the set is added if it is new
+    inline PtsID intern(const Data& pts) {
+        size_t hash = hashPts(pts);
+        llvm::SmallVector<PtsID, 1>& ids = hashToIDs[hash];
+        for (typename llvm::SmallVector<PtsID, 1>::const_iterator it = ids.begin(), eit = ids.end(); it != eit; ++it) {
+            if (getSet(*it) == pts)
+                return *it;
+        }
+        PtsID id = ptsSets.size();
+        ptsSets.push_back(pts);
+        ptsHashes.push_back(hash);
+        ids.push_back(id);
+        setToID[&ptsSets.back()] = id;
+        return id;
+    }
+
+    /// Memoized union of two interned sets
+    inline PtsID unionIDs(PtsID lhs, PtsID rhs) {
+        if (lhs == rhs || rhs == 0)
+            return lhs;
+        if (lhs == 0)
+            return rhs;
+
+        unionLookups++;
+        std::pair<PtsID, PtsID> key = lhs < rhs ? std::make_pair(lhs, rhs) : std::make_pair(rhs, lhs);
+        typename UnionCache::const_iterator it = unionCache.find(key);
+        if (it != unionCache.end()) {
+            unionHits++;
+            return it->second;
+        }
+
+        Data pts = getSet(lhs);
+        PtsID id = (pts |= getSet(rhs)) ? intern(pts) : lhs;
+        unionCache[key] = id;
+        return id;
+    }
+
+    /// Union an interned set into the set of a key
+    inline bool unionID(const Key& dstKey, PtsID src) {
+        PtsID& dst = keyToID[dstKey];
+        PtsID id = unionIDs(dst, src);
+        if (id == dst)
+            return false;
+        dst = id;
+        this->addRevPts(getSet(src),dstKey);
+        return true;
+    }
+};
+
 #endif /* POINTSTO_H_ */
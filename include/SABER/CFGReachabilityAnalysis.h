@@ -25,24 +25,42 @@
 
 using namespace llvm;
 
+/*
+ * Reachability index of one function, built eagerly and read-only afterwards,
+ * so that it can be queried from several threads.
+ *
+ * Basic blocks are condensed into strongly connected components, and the
+ * transitive closure of the condensed DAG is computed bottom-up with word-parallel
+ * bit-vector unions. Instructions are numbered inside their blocks, so that
+ * intra-block queries are a comparison of two ordinals.
+ */
 class CFGReachability {
 	typedef BitVector ReachableSet;
-	ReachableSet analyzed;
-	ReachableSet* reachable;
+
+	// SCCs reachable from an SCC by a non-empty path, indexed by SCC ID
+	std::vector<ReachableSet> sccReachable;
 
 	// ID mapping
-	std::vector<const BasicBlock *> IDtoBB;
-	std::unordered_map<const BasicBlock *, int> BBID;
+	std::unordered_map<const BasicBlock *, unsigned> BBToSCC;
+	std::unordered_map<const Instruction *, unsigned> InstOrdinal;
 
 public:
 	CFGReachability(const Function &F);
 	~CFGReachability();
 
-	/// Returns true if the block 'Dst' can be reached from block 'Src'.
-	bool isReachable(const BasicBlock *Src, const BasicBlock *Dst);
+	/// Returns true if the block 'Dst' can be reached from block 'Src' by a non-empty path.
+	bool isReachable(const BasicBlock *Src, const BasicBlock *Dst) const;
+
+	/// Returns true if 'Src' is not after 'Dst' in their basic block.
+	bool isReachableInBlock(const Instruction *Src, const Instruction *Dst) const;
+
+	/// Number of SCCs of the function
+	unsigned getSCCNum() const {
+		return sccReachable.size();
+	}
 
 private:
-	void mapReachability(const BasicBlock *Dst);
+	void buildIndex(const Function &F);
 };
 
 class CFGReachabilityAnalysis: public ModulePass {
@@ -57,6 +75,7 @@ public:
 
 	virtual ~CFGReachabilityAnalysis();
 
+	/// Build the reachability index of every function with a body
 	bool runOnModule(Module& M);
 
 	void getAnalysisUsage(AnalysisUsage &AU) const {
@@ -65,16 +84,16 @@ public:
 
 public:
 	/// Returns true if the block 'Dst' can be reached from block 'Src'.
-	bool isBBReachable(const BasicBlock *Src, const BasicBlock *Dst);
+	bool isBBReachable(const BasicBlock *Src, const BasicBlock *Dst) const;
 
 	/// Determine reachability within one basic block.
 	bool isReachableInBlock(const Instruction *Src, const Instruction *Dst) const;
 
 	// Check the reachability from any two instructions in the same function
-	bool isReachable(const Instruction *Src, const Instruction *Dst);
+	bool isReachable(const Instruction *Src, const Instruction *Dst) const;
 
 private:
-	CFGReachability* getReachabilityResultFor(const Function*);
+	const CFGReachability* getReachabilityResultFor(const Function*) const;
 };
 
 #endif /* ANALYSIS_CFG_CFGREACHABILITYANALYSIS_H */
@@ -133,19 +133,24 @@ protected:
         pushIntoWorklist(newItem);
     }
     //@}
+    /// Worklist of the current resolution, solvers running several resolutions
+    /// concurrently return the worklist of the resolution of the calling thread
+    virtual inline WorkList& getWorklist() {
+        return worklist;
+    }
     /// Worklist operations
     //@{
     inline DPIm popFromWorklist() {
-        return worklist.pop();
+        return getWorklist().pop();
     }
     inline bool pushIntoWorklist(DPIm& item) {
-        return worklist.push(item);
+        return getWorklist().push(item);
     }
     inline bool isWorklistEmpty() {
-        return worklist.empty();
+        return getWorklist().empty();
     }
     inline bool isInWorklist(DPIm& item) {
-        return worklist.find(item);
+        return getWorklist().find(item);
     }
     //@}
 
@@ -0,0 +1,110 @@
+//===- InterProcReachability.h -- Interprocedural CFG reachability------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * InterProcReachability.h
+ *
+ * Whether an instruction may execute after another one, across functions.
+ *
+ * The analysis combines the intra-procedural CFG reachability with the
+ * call graph resolved by the pointer analysis:
+ *  - the callee closure of every function (functions which may be entered once
+ *    the function is entered), computed over the SCCs of the call graph;
+ *  - per function, its call sites and the blocks returning to its callers.
+ *
+ * For a source instruction, a summary records the functions which may be
+ * entered after it (through the call sites reachable from it, in its function
+ * and, once it returns, in its transitive callers) and the call sites of the
+ * callers where the execution resumes. Queries are then answered from the
+ * summary without traversing the program.
+ */
+
+#ifndef INTERPROCREACHABILITY_H_
+#define INTERPROCREACHABILITY_H_
+
+#include "SABER/CFGReachabilityAnalysis.h"
+#include "Util/PTACallGraph.h"
+#include "Util/SCC.h"
+#include <llvm/ADT/BitVector.h>
+#include <mutex>
+
+class InterProcReachability {
+
+public:
+    typedef SCCDetection<PTACallGraph*> CallGraphSCC;
+    typedef llvm::BitVector FunctionBS;		///< functions indexed by their call graph node IDs
+    typedef std::vector<const llvm::Instruction*> InstVec;
+    typedef std::unordered_map<const llvm::Function*, InstVec> FunToInstsMap;
+    typedef std::unordered_map<const llvm::Function*, std::vector<const llvm::BasicBlock*> > FunToBBsMap;
+
+    /// Constructor
+    InterProcReachability(PTACallGraph* cg, const CFGReachabilityAnalysis* cfgr);
+
+    /// Destructor
+    ~InterProcReachability();
+
+    /// Whether dst may execute after src, the summary of src is built on the first query.
+    /// When both are in the same function, only the intra-procedural path is considered.
+    /// A call site resumed once the function of src returns is reachable itself.
+    bool isReachable(const llvm::Instruction* src, const llvm::Instruction* dst);
+
+    /// Number of summarized sources
+    inline u32_t getSummaryNum() {
+        std::lock_guard<std::mutex> lock(summaryMutex);
+        return summaries.size();
+    }
+
+private:
+    /// Instructions which may execute after a source
+    struct Summary {
+        FunctionBS entered;		///< functions entered after the source
+        FunToInstsMap resumed;	///< call sites of the (transitive) callers returned to
+    };
+    typedef std::unordered_map<const llvm::Instruction*, Summary*> InstToSummaryMap;
+
+    PTACallGraph* callgraph;
+    const CFGReachabilityAnalysis* CFGR;
+    CallGraphSCC* callGraphSCC;
+    std::vector<FunctionBS> calleeClosure;	///< callee closure indexed by SCC rep node IDs
+    FunToInstsMap funToCallSites;			///< call sites with resolved callees
+    FunToBBsMap funToExitBBs;				///< blocks returning to the callers
+    InstToSummaryMap summaries;
+    std::mutex summaryMutex;				///< summaries are built on demand by concurrent queries
+
+    /// Precompute the callee closure, the call sites and the exit blocks
+    void build();
+
+    /// Get (or build) the summary of src
+    const Summary* getSummary(const llvm::Instruction* src);
+
+    /// Functions entered through the call sites reachable from inst in its function
+    void enterCallees(const llvm::Instruction* inst, FunctionBS& entered) const;
+
+    /// Whether inst may reach a return of its function
+    bool mayReturn(const llvm::Instruction* inst) const;
+
+    inline NodeID getFunID(const llvm::Function* fun) const {
+        return callgraph->getCallGraphNode(fun)->getId();
+    }
+};
+
+#endif /* INTERPROCREACHABILITY_H_ */
@@ -10,7 +10,10 @@
 
 #include <stdbool.h>
 #include <time.h>
+#include <stdint.h>
 #include <string>
+#include <map>
+#include <vector>
 
 
 // This class the profiling methods
@@ -41,6 +44,18 @@ private:
 
 	property_t properties_to_track;
 
+	// named event counters, e.g., cache hits/misses of an analysis
+	std::map<std::string, uint64_t> counters;
+
+	// costs of named work items, e.g., the analysis of each source
+	struct cost_t {
+		std::string name;
+		double seconds;
+		uint64_t nodes;
+		uint64_t bdd_nodes;
+	};
+	std::vector<cost_t> costs;
+
 private:
 	// reset the corresponding property to the current value
 	void reset_memory();
@@ -63,6 +78,9 @@ private:
 	// Get the peak memory usage
 	int pick_peak_memory();
 
+	// Get the peak resident set size
+	int pick_peak_rss();
+
 	// Get the raw profiler info with name info_name
 	int pick_info(const char* info_name);
 
@@ -90,6 +108,30 @@ public:
 
 	// print the peak memory during the program execution
 	void print_peak_memory();
+
+	// print the peak resident set size during the program execution
+	void print_peak_rss();
+
+	// add "value" to the counter named "name"
+	void add_counter(const std::string& name, uint64_t value);
+
+	// print all the counters (in the order of their names)
+	void print_counters();
+
+	// record the costs of the work item named "name"
+	void add_cost(const std::string& name, double seconds, uint64_t nodes, uint64_t bdd_nodes);
+
+	// print the "n" most expensive work items (by time)
+	void print_top_costs(size_t n);
+
+	// drop the counters and costs, e.g., the ones a forked worker process inherits from its parent
+	void clear_records();
+
+	// append the counters and costs to "data", to be loaded by another process
+	void save_records(std::string& data) const;
+
+	// add the counters and costs saved in "data" to this profiler
+	void load_records(const std::string& data);
 };
 
 #endif /* PLATFORM_OS_PROFILER_H */
@@ -34,6 +34,7 @@
 #include "Util/WorkList.h"
 #include "MSSA/SVFG.h"
 #include "Util/DPItem.h"
+#include "SABER/SourceBudget.h"
 
 class ProgSlice {
 
@@ -49,7 +50,7 @@ public:
     /// Constructor
     ProgSlice(const SVFGNode* src, PathCondAllocator* pa, const SVFG* graph):
         root(src), partialReachable(false), fullReachable(false), reachGlob(false),
-        pathAllocator(pa), _curSVFGNode(NULL), finalCond(pa->getFalseCond()), svfg(graph) {
+        pathAllocator(pa), _curSVFGNode(NULL), finalCond(pa->getFalseCond()), svfg(graph), budget(NULL) {
     }
 
     /// Destructor
@@ -169,6 +170,15 @@ public:
     /// Annotate program according to final condition
     void annotatePaths();
 
+    /// Transfer the conditions used to report bugs (of the sinks and the final condition)
+    /// from the BDD manager of the calling worker thread to the main manager
+    void transferCondsToMain();
+
+    /// Budget of the source, guard computation stops once it is exhausted
+    inline void setBudget(SourceBudget* b) {
+        budget = b;
+    }
+
 private:
     inline const SVFG* getSVFG() const {
         return svfg;
@@ -254,6 +264,7 @@ private:
     const SVFGNode* _curSVFGNode;			///<  current svfg node during guard computation
     Condition* finalCond;					///<  final condition
     const SVFG* svfg;						///<  SVFG
+    SourceBudget* budget;					///<  budget of the source (may be NULL)
 };
 
 
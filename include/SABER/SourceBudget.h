@@ -0,0 +1,124 @@
+//===- SourceBudget.h -- Analysis budget of one source-----------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * SourceBudget.h
+ *
+ * Budget of the analysis of one source: wall time, visited SVFG nodes and
+ * BDD nodes created (see -src-time-budget, -src-node-budget, -src-bdd-budget).
+ * The searches call visit() on every node and stop once it returns false,
+ * the source is then reported as out of budget and the run moves on.
+ */
+
+#ifndef SOURCEBUDGET_H_
+#define SOURCEBUDGET_H_
+
+#include "Util/BasicTypes.h"
+#include <chrono>
+#include <mutex>
+#include <string>
+
+class SourceBudget {
+
+public:
+    enum ExhaustKind {
+        NotExhausted,
+        TimeExhausted,
+        NodeExhausted,
+        BddExhausted
+    };
+
+    /// Constructor, the limits are taken from the command line
+    SourceBudget();
+
+    /// Start the budget of a new source
+    void start();
+
+    /// Stop the clock when the source is finished or paused, the costs are frozen afterwards
+    void stop();
+
+    /// Continue a stopped source, e.g., when its analysis is resumed by another thread
+    void resume();
+
+    /// Lock held while the BDD nodes are read, when the BDD manager of the calling
+    /// thread may be changed by other threads (NULL: the manager is not shared)
+    inline void setBddLock(std::mutex* lock) {
+        bddLock = lock;
+    }
+
+    /// Count a visited node, return false if the budget is exhausted
+    inline bool visit() {
+        if (exhausted != NotExhausted)
+            return false;
+        ++visitedNodes;
+        if (maxNodes != 0 && visitedNodes > maxNodes) {
+            exhausted = NodeExhausted;
+            return false;
+        }
+        /// the clock and the BDD manager are checked every 256 nodes
+        if ((visitedNodes & 0xff) == 0)
+            return check();
+        return true;
+    }
+
+    inline bool isExhausted() const {
+        return exhausted != NotExhausted;
+    }
+    /// Which limit is exceeded
+    const char* getExhaustReason() const;
+
+    /// Costs of the source so far
+    //@{
+    double getElapsedTime() const;
+    inline u32_t getVisitedNodes() const {
+        return visitedNodes;
+    }
+    u32_t getBddNodes() const;
+    //@}
+
+    /// Record the costs of a source into the global profiler
+    void recordCost(const std::string& source) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double maxTime;			///< seconds, 0 for no limit
+    u32_t maxNodes;			///< 0 for no limit
+    u32_t maxBddNodes;		///< 0 for no limit
+
+    Clock::time_point startTime;	///< start of the running period
+    double elapsed;					///< time of the finished periods
+    u32_t visitedNodes;
+    u32_t startBddNodes;			///< BDD nodes at the start of the running period
+    u32_t bddNodes;					///< BDD nodes created in the finished periods
+    bool stopped;
+    ExhaustKind exhausted;
+    std::mutex* bddLock;			///< lock of a shared BDD manager, may be NULL
+
+    /// Check the time and the BDD limits
+    bool check();
+
+    /// Number of BDD nodes of the manager of the calling thread
+    u32_t readBddNodes() const;
+};
+
+#endif /* SOURCEBUDGET_H_ */
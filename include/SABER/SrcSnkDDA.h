@@ -36,10 +36,65 @@
 #include "SABER/SaberSVFGBuilder.h"
 #include "WPA/Andersen.h"
 #include <llvm/Support/Debug.h>
+#include <functional>
 #include <time.h>
 
 typedef CFLSolver<SVFG*,CxtDPItem> CFLSrcSnkSolver;
 
+/*!
+ * Pre-analysis of the source-sink checkers: the SVFG and the branch conditions.
+ * It does not depend on the checker, so that the checkers of one run can share it
+ * (see SrcSnkDDA::setSharedPreAnalysis).
+ */
+class SaberPreAnalysis {
+
+public:
+    /// Constructor
+    SaberPreAnalysis() : svfg(NULL), ptaCallGraph(NULL) {
+        pathCondAllocator = new PathCondAllocator();
+    }
+    /// Destructor
+    ~SaberPreAnalysis();
+
+    /// Build the pre-analysis, it is built only once
+    void build(llvm::Module& module);
+
+    inline bool isBuilt() const {
+        return svfg != NULL;
+    }
+    inline SVFG* getSVFG() const {
+        return svfg;
+    }
+    inline PathCondAllocator* getPathAllocator() const {
+        return pathCondAllocator;
+    }
+    /// Whether this svfg node may access global variable
+    inline bool isGlobalSVFGNode(const SVFGNode* node) const {
+        return memSSA.isGlobalSVFGNode(node);
+    }
+
+    /// The pre-analysis shared by the checkers
+    //@{
+    static SaberPreAnalysis* getSharedPreAnalysis() {
+        if(sharedPreAnalysis==NULL)
+            sharedPreAnalysis = new SaberPreAnalysis();
+        return sharedPreAnalysis;
+    }
+    static void releaseSharedPreAnalysis() {
+        if(sharedPreAnalysis)
+            delete sharedPreAnalysis;
+        sharedPreAnalysis = NULL;
+    }
+    //@}
+
+private:
+    SaberSVFGBuilder memSSA;
+    SVFG* svfg;
+    PTACallGraph* ptaCallGraph;
+    PathCondAllocator* pathCondAllocator;
+    static SaberPreAnalysis* sharedPreAnalysis;
+};
+
 /*!
  * General source-sink analysis, which serves as a base analysis to be extended for various clients
  */
@@ -53,35 +108,50 @@ public:
     typedef std::set<DPIm> DPImSet;							///< dpitem set
     typedef std::map<const SVFGNode*, DPImSet> SVFGNodeToDPItemsMap; 	///< map a SVFGNode to its visited dpitems
 
+    /*!
+     * State of the analysis of one source. The slices of different sources are
+     * traversed concurrently (see -slice-jobs), each thread on its own context.
+     */
+    struct SliceContext {
+        ProgSlice* slice;						///<  program slice of the source
+        SVFGNodeToDPItemsMap nodeToDPItemsMap;	///<  record forward visited dpitems
+        SVFGNodeSet visitedSet;					///<  record backward visited nodes
+        WorkList worklist;						///<  worklist of the CFL traversals
+        SourceBudget budget;					///<  budget of the source
+        bool solved;							///<  whether the guard computation is done
+        bool guarded;							///<  whether the guards are computed (not skipped)
+
+        SliceContext(ProgSlice* s) : slice(s), solved(false), guarded(false) {
+            slice->setBudget(&budget);
+        }
+        ~SliceContext() {
+            delete slice;
+        }
+    };
+
 private:
-    ProgSlice* _curSlice;		/// current program slice
     SVFGNodeSet sources;		/// source nodes
     SVFGNodeSet sinks;		/// source nodes
-    PathCondAllocator* pathCondAllocator;
-    SVFGNodeToDPItemsMap nodeToDPItemsMap;	///<  record forward visited dpitems
-    SVFGNodeSet visitedSet;	///<  record backward visited nodes
-    SaberSVFGBuilder memSSA;
-    SVFG* svfg;
-    PTACallGraph* ptaCallGraph;
+    SaberPreAnalysis* preAnalysis;	///< SVFG and branch conditions
+    bool ownPreAnalysis;			///< whether preAnalysis is owned by this checker
+    static bool sharePreAnalysis;	///< whether the checkers share one pre-analysis
+    static thread_local SliceContext* curContext;	///< context of the source analyzed by this thread
 public:
 
     /// Constructor
-    SrcSnkDDA() : _curSlice(NULL), svfg(NULL), ptaCallGraph(NULL) {
-        pathCondAllocator = new PathCondAllocator();
+    SrcSnkDDA() : preAnalysis(NULL), ownPreAnalysis(false) {
     }
     /// Destructor
     virtual ~SrcSnkDDA() {
-        if (svfg != NULL)
-            delete svfg;
-        svfg = NULL;
-
-        if (ptaCallGraph != NULL)
-            delete ptaCallGraph;
-        ptaCallGraph = NULL;
+        if (ownPreAnalysis)
+            delete preAnalysis;
+        preAnalysis = NULL;
+    }
 
-        if(pathCondAllocator)
-            delete pathCondAllocator;
-        pathCondAllocator = NULL;
+    /// Whether the checkers build their own pre-analysis (default) or share one,
+    /// e.g., when several checkers are run on the same module
+    static inline void setSharedPreAnalysis(bool share) {
+        sharePreAnalysis = share;
     }
 
     /// Start analysis here
@@ -90,10 +160,20 @@ public:
     /// Initialize analysis
     virtual void initialize(llvm::Module& module);
 
+    /// Analyze one source, it is the slice of the source by default
+    virtual void analyzeSource(const SVFGNode* src);
+
+    /// The phases of the analysis of a source on the current context: the CFL traversals
+    /// of its slice, the guard computation and the bug report. The traversals of different
+    /// sources may run concurrently, and so may the guard computations on per-thread BDD managers
+    //@{
+    void traverseSlice();
+    void solveSlice();
+    void checkSlice();
+    //@}
+
     /// Finalize analysis
-    virtual void finalize() {
-        dumpSlices();
-    }
+    virtual void finalize();
 
     /// Get SVFG
     inline const SVFG* getSVFG() const {
@@ -102,30 +182,40 @@ public:
 
     /// Whether this svfg node may access global variable
     inline bool isGlobalSVFGNode(const SVFGNode* node) const {
-        return memSSA.isGlobalSVFGNode(node);
+        return preAnalysis->isGlobalSVFGNode(node);
     }
     /// Slice operations
     //@{
-    void setCurSlice(const SVFGNode* src);
+    SliceContext* createContext(const SVFGNode* src);
 
+    inline void setCurContext(SliceContext* cxt) {
+        curContext = cxt;
+    }
+    inline SliceContext* getCurContext() const {
+        assert(curContext && "no source analyzed by this thread?");
+        return curContext;
+    }
     inline ProgSlice* getCurSlice() const {
-        return _curSlice;
+        return getCurContext()->slice;
+    }
+    inline SourceBudget& getCurBudget() const {
+        return getCurContext()->budget;
     }
     inline void addSinkToCurSlice(const SVFGNode* node) {
-        _curSlice->addToSinks(node);
+        getCurSlice()->addToSinks(node);
         addToCurForwardSlice(node);
     }
     inline bool isInCurForwardSlice(const SVFGNode* node) {
-        return _curSlice->inForwardSlice(node);
+        return getCurSlice()->inForwardSlice(node);
     }
     inline bool isInCurBackwardSlice(const SVFGNode* node) {
-        return _curSlice->inBackwardSlice(node);
+        return getCurSlice()->inBackwardSlice(node);
     }
     inline void addToCurForwardSlice(const SVFGNode* node) {
-        _curSlice->addToForwardSlice(node);
+        getCurSlice()->addToForwardSlice(node);
     }
     inline void addToCurBackwardSlice(const SVFGNode* node) {
-        _curSlice->addToBackwardSlice(node);
+        getCurSlice()->addToBackwardSlice(node);
     }
     //@}
 
@@ -172,7 +262,8 @@ public:
 
     /// Get path condition allocator
     PathCondAllocator* getPathAllocator() const {
-        return pathCondAllocator;
+        assert(preAnalysis && "pre-analysis not initialized?");
+        return preAnalysis->getPathAllocator();
     }
 
 protected:
@@ -181,7 +272,7 @@ protected:
         const SVFGNode* node = getNode(item.getCurNodeID());
         if(isSink(node)) {
             addSinkToCurSlice(node);
-            _curSlice->setPartialReachable();
+            getCurSlice()->setPartialReachable();
         }
         else
             addToCurForwardSlice(node);
@@ -193,13 +284,19 @@ protected:
             addToCurBackwardSlice(node);
         }
     }
+    /// Traverse the SVFG over its CSR layout (frozen by the pre-analysis) rather than the edge sets
+    //@{
+    virtual void forwardTraverse(DPIm& it);
+    virtual void backwardTraverse(DPIm& it);
+    //@}
     /// Propagate information forward by matching context
-    virtual void forwardpropagate(const DPIm& item, SVFGEdge* edge);
+    void forwardpropagate(const DPIm& item, const SVFG::SVFGCSREdge& rec);
     /// Propagate information backward without matching context, as forward analysis already did it
-    virtual void backwardpropagate(const DPIm& item, SVFGEdge* edge);
+    void backwardpropagate(const DPIm& item, const SVFG::SVFGCSREdge& rec);
     /// Whether has been visited or not, in order to avoid recursion on SVFG
     //@{
     inline bool forwardVisited(const SVFGNode* node, const DPIm& item) {
+        SVFGNodeToDPItemsMap& nodeToDPItemsMap = getCurContext()->nodeToDPItemsMap;
         SVFGNodeToDPItemsMap::iterator it = nodeToDPItemsMap.find(node);
         if(it!=nodeToDPItemsMap.end())
             return it->second.find(item)!=it->second.end();
@@ -207,19 +304,24 @@ protected:
             return false;
     }
     inline void addForwardVisited(const SVFGNode* node, const DPIm& item) {
-        nodeToDPItemsMap[node].insert(item);
+        getCurContext()->nodeToDPItemsMap[node].insert(item);
     }
     inline bool backwardVisited(const SVFGNode* node) {
+        SVFGNodeSet& visitedSet = getCurContext()->visitedSet;
         return visitedSet.find(node)!=visitedSet.end();
     }
     inline void addBackwardVisited(const SVFGNode* node) {
-        visitedSet.insert(node);
+        getCurContext()->visitedSet.insert(node);
     }
     inline void clearVisitedMap() {
-        nodeToDPItemsMap.clear();
-        visitedSet.clear();
+        getCurContext()->nodeToDPItemsMap.clear();
+        getCurContext()->visitedSet.clear();
     }
     //@}
+    /// The worklist of the source analyzed by this thread
+    virtual inline WorkList& getWorklist() {
+        return getCurContext()->worklist;
+    }
 
     /// Guarded reachability search
     //@{
@@ -233,12 +335,24 @@ protected:
     //@}
     /// Whether it is all path reachable from a source
     virtual bool isAllPathReachable() {
-        return _curSlice->isAllReachable();
+        return getCurSlice()->isAllReachable();
     }
     /// Whether it is some path reachable from a source
     virtual bool isSomePathReachable() {
-        return _curSlice->isPartialReachable();
+        return getCurSlice()->isPartialReachable();
     }
+    /// Analyze the sources, in forked worker processes if -shards is set.
+    /// func returns the number of bugs found from a source, the total number is returned.
+    /// The data func fills for a source is handed to replay, which runs in this process
+    /// in the source order once the source is analyzed (e.g. to print its reports)
+    //@{
+    typedef std::function<u32_t(const SVFGNode*, std::string&)> SourceFunc;
+    typedef std::function<void(const SVFGNode*, const std::string&)> ReplayFunc;
+    u32_t analyzeSources(const std::vector<const SVFGNode*>& srcs, SourceFunc func, ReplayFunc replay = ReplayFunc());
+    bool isSharded() const;
+    //@}
+    /// Analyze the sources with their slices traversed on the thread pool
+    void analyzeSourcesInParallel(const std::vector<const SVFGNode*>& srcs);
     /// Dump SVFG with annotated slice informaiton
     //@{
     void dumpSlices();
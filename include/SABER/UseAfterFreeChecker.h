@@ -32,7 +32,11 @@
 #include "SABER/SrcSnkDDA.h"
 #include "SABER/SaberCheckerAPI.h"
 #include "SABER/CFGReachabilityAnalysis.h"
+#include "SABER/InterProcReachability.h"
+#include "SABER/SourceBudget.h"
 #include "Util/PushPopCache.h"
+#include "Util/CxtStack.h"
+#include <mutex>
 
 /*!
  * Static Use After Free Detector
@@ -44,10 +48,11 @@ public:
     static char ID;
 
     /// Constructor
-    UseAfterFreeChecker(char id = ID): ModulePass(ID), CFGR(nullptr) {
+    UseAfterFreeChecker(char id = ID): ModulePass(ID), CFGR(nullptr), IPR(nullptr) {
     }
     /// Destructor
     virtual ~UseAfterFreeChecker() {
+        delete IPR;
     }
 
     /// We start from here
@@ -107,32 +112,132 @@ protected:
     //@}
 
 private:
+    typedef std::map<const SVFGNode*, PathCondAllocator::Condition*> SVFGNodeToCondMap;
+
+    /// Kinds of a sub-search summarized by a value-flow summary
+    enum SummaryKind {
+        BackwardSearch,
+        ForwardSearch,
+        TaggedForwardSearch
+    };
+
+    /// A sub-search is determined by its node, the previous node on the path,
+    /// the context stack normalized to call site IDs and its kind.
+    /// A forward sub-search also depends on the call site freeing the object
+    /// (the top of the backward context it starts from), which decides the
+    /// reachable uses, it is NULL for a backward sub-search.
+    struct SummaryKey {
+        const SVFGNode* Node;
+        const SVFGNode* Prev;
+        CxtStackID Ctx;
+        SummaryKind Kind;
+        const Instruction* FreeCS;
+
+        bool operator<(const SummaryKey& RHS) const {
+            if (Node != RHS.Node)
+                return Node < RHS.Node;
+            if (Prev != RHS.Prev)
+                return Prev < RHS.Prev;
+            if (Ctx != RHS.Ctx)
+                return Ctx < RHS.Ctx;
+            if (Kind != RHS.Kind)
+                return Kind < RHS.Kind;
+            return FreeCS < RHS.FreeCS;
+        }
+    };
+
+    /// A use site reachable from a sub-search, with the value-flow path leading to it
+    struct SummaryHit {
+        std::vector<const SVFGNode*> Suffix;
+        const Instruction* User;
+    };
+    typedef std::vector<SummaryHit> Summary;
+    typedef std::map<SummaryKey, Summary> SummaryMap;
+
+    /// A sub-search whose summary is being recorded
+    struct SummaryRecorder {
+        SummaryKey Key;
+        size_t Depth;		///< path length when the sub-search started
+        Summary Hits;
+        bool Overflow;		///< too many hits, the summary is not cached
+    };
+
+    /// Search state of one deallocation source.
+    /// Every source owns its own state so that sources can be searched
+    /// independently (and concurrently, see -uaf-jobs).
+    struct SearchState {
+        PushPopVector<const SVFGNode*> SVFGPath;	///< current value-flow path
+        CxtStackTrie CxtTrie;						///< interned context stacks of this source
+        SVFGNodeToCondMap svfgNodeToCondMap;		///< VF conditions during check()
+        std::vector<std::string> Reports;			///< bug reports found from this source
+        unsigned NumReports = 0;					///< number of bugs found from this source
+        SummaryMap Summaries;						///< value-flow summaries of finished sub-searches
+        std::vector<SummaryRecorder> Recorders;		///< sub-searches in progress
+        unsigned SummaryHits = 0;
+        unsigned SummaryMisses = 0;
+        SourceBudget Budget;						///< time and node budget of this source
+        std::string SourceName;						///< free site, for the cost statistics
+        std::string OutOfBudget;					///< reason the budget was exhausted, empty if it was not
+    };
+
     std::map<const SVFGNode*, const SVFGEdge*> SrcToCallEdgeMap;
 
     CFGReachabilityAnalysis* CFGR;
 
-    PushPopVector<const SVFGNode*> SVFGPath;
+    InterProcReachability* IPR;
+
+    /// Serialize the accesses to the BDD manager, which is not thread-safe
+    std::mutex CondMutex;
+
+    void searchSource(const SVFGNode*, SearchState&);
+
+    void flushReports(SearchState&);
 
-    void searchBackward(const SVFGNode*, const SVFGNode*, const SVFGEdge*, std::vector<const SVFGEdge*>);
+    void recordSource(SearchState&);
 
-    void searchForward(const SVFGNode*, const SVFGNode*, const SVFGEdge*, std::vector<const SVFGEdge*>, llvm::Instruction*, bool);
+    void printReports(SearchState&);
 
-    void push();
+    /// Reports of a source searched in a worker process (see -shards)
+    //@{
+    void packReports(const SearchState&, std::string&);
+
+    void unpackReports(SearchState&, const std::string&);
+    //@}
 
-    void pop();
+    void searchBackward(SearchState&, const SVFGNode*, const SVFGNode*, const SVFGEdge*, CxtStackID);
 
-    bool check(const Instruction*);
+    void searchForward(SearchState&, const SVFGNode*, const SVFGNode*, const SVFGEdge*, CxtStackID, llvm::Instruction*, bool);
+
+    /// Value-flow summaries (see -uaf-summary)
+    //@{
+    SummaryKey getSummaryKey(const SVFGNode*, const SVFGNode*, CxtStackID, SummaryKind, const Instruction*);
 
-    bool matchContextB(std::vector<const SVFGEdge*>& Ctx, SVFGEdge* Edge);
-    bool matchContextF(std::vector<const SVFGEdge*>& Ctx, SVFGEdge* Edge);
+    bool replaySummary(SearchState&, const SummaryKey&);
+
+    void beginSummary(SearchState&, const SummaryKey&);
+
+    void endSummary(SearchState&);
+    //@}
+
+    /// A use of the freed pointer is reached, check its path and report it
+    void visitUse(SearchState&, const Instruction*);
+
+    void push(SearchState&);
+
+    void pop(SearchState&);
+
+    bool check(SearchState&, const Instruction*);
+
+    bool matchContextB(CxtStackTrie& T, CxtStackID& Ctx, const SVFG::SVFGCSREdge& Rec);
+    bool matchContextF(CxtStackTrie& T, CxtStackID& Ctx, const SVFG::SVFGCSREdge& Rec);
 
     CallSiteID getCSID(const SVFGEdge*);
 
-    void reportBug(const Instruction*);
+    void reportBug(SearchState&, const Instruction*);
 
     bool reachable(const llvm::Instruction*, const llvm::Instruction*);
 
-    void printContextStack(std::vector<const SVFGEdge*>&);
+    void printContextStack(const CxtStackTrie&, CxtStackID);
 
     const llvm::BasicBlock* getSVFGNodeBB(const SVFGNode* N) const {
         const llvm::BasicBlock* B = N->getBB();
@@ -163,21 +268,19 @@ private:
 
     /// Get/set VF (value-flow) and CF (control-flow) conditions
     //@{
-    std::map<const SVFGNode*, PathCondAllocator::Condition*> svfgNodeToCondMap;
-
-    inline PathCondAllocator::Condition* getVFCond(const SVFGNode* node) const {
-        auto it = svfgNodeToCondMap.find(node);
-        if(it==svfgNodeToCondMap.end()) {
+    inline PathCondAllocator::Condition* getVFCond(const SearchState& S, const SVFGNode* node) const {
+        auto it = S.svfgNodeToCondMap.find(node);
+        if(it==S.svfgNodeToCondMap.end()) {
             return this->getPathAllocator()->getFalseCond();
         }
         return it->second;
     }
-    inline bool setVFCond(const SVFGNode* node, PathCondAllocator::Condition* cond) {
-        auto it = svfgNodeToCondMap.find(node);
-        if(it!=svfgNodeToCondMap.end() && it->second == cond)
+    inline bool setVFCond(SearchState& S, const SVFGNode* node, PathCondAllocator::Condition* cond) {
+        auto it = S.svfgNodeToCondMap.find(node);
+        if(it!=S.svfgNodeToCondMap.end() && it->second == cond)
             return false;
 
-        svfgNodeToCondMap[node] = cond;
+        S.svfgNodeToCondMap[node] = cond;
         return true;
     }
     //@}
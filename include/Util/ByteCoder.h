@@ -0,0 +1,72 @@
+//===- ByteCoder.h -- Packing values into byte strings-----------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * ByteCoder.h
+ *
+ * Pack integers and strings into a byte string and read them back, e.g. the
+ * data a worker process hands to its parent (see ProcessShards). The values
+ * are in the byte order of the host, the data is not meant to be stored.
+ */
+
+#ifndef BYTECODER_H_
+#define BYTECODER_H_
+
+#include "Util/BasicTypes.h"
+#include <cstring>
+#include <string>
+
+class ByteCoder {
+
+public:
+    /// Append a field to data
+    //@{
+    static inline void putU64(std::string& data, u64_t value) {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    static inline void putString(std::string& data, const std::string& str) {
+        putU64(data, str.size());
+        data.append(str);
+    }
+    //@}
+
+    /// Read the field at pos and move pos past it, return false at the end of the data
+    //@{
+    static inline bool getU64(const std::string& data, size_t& pos, u64_t& value) {
+        if (data.size() - pos < sizeof(value))
+            return false;
+        memcpy(&value, data.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+    static inline bool getString(const std::string& data, size_t& pos, std::string& str) {
+        u64_t size;
+        if (!getU64(data, pos, size) || data.size() - pos < size)
+            return false;
+        str.assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+    //@}
+};
+
+#endif /* BYTECODER_H_ */
@@ -34,47 +34,136 @@
 #include "Util/BasicTypes.h"
 #include "CUDD/cuddInt.h"
 
+/// Opaque handle of a condition, its representation is owned by the manager which created it
+class CondExpr;
+
+/**
+ * Interface of the condition managers (see -cond-backend).
+ * Conditions of a manager are only used with that manager, and are
+ * moved between managers of the same backend by transfer().
+ */
+class CondManager {
+public:
+    /// Create the manager of the backend selected by -cond-backend
+    static CondManager* createCondManager();
+
+    CondManager() : andLimitHits(0), orLimitHits(0) {
+    }
+    virtual ~CondManager() {
+    }
+
+    /// Create new condition of the variable with index i
+    virtual CondExpr* createNewCond(unsigned i) = 0;
+    /// Create the variables of the indices below num (in the index order), without conditions for them
+    virtual void reserveVars(unsigned num) = 0;
+    /// Get existing condition
+    virtual CondExpr* getCond(unsigned i) const = 0;
+    /// Copy a condition of another manager of the same backend into this one, the variables are matched by their indices
+    virtual CondExpr* transfer(const CondManager* from, CondExpr* cond) = 0;
+
+    virtual CondExpr* getTrueCond() const = 0;
+    virtual CondExpr* getFalseCond() const = 0;
+
+    /// Operations on conditions.
+    //@{
+    virtual CondExpr* AND(CondExpr* lhs, CondExpr* rhs) = 0;
+    virtual CondExpr* OR(CondExpr* lhs, CondExpr* rhs) = 0;
+    virtual CondExpr* NEG(CondExpr* lhs) = 0;
+    //@}
+
+    /// Increase reference counting to keep the condition alive
+    virtual void retain(CondExpr* cond) = 0;
+    virtual void markForRelease(CondExpr* cond) = 0;
+
+    /// Indices of the variables a condition depends on
+    virtual void support(CondExpr* cond, NodeBS &support) const = 0;
+    virtual std::string dumpStr(CondExpr* cond) const = 0;
+    virtual void printDbg(CondExpr* cond) {
+        llvm::outs() << dumpStr(cond) << "\n";
+    }
+
+    /// Statistics
+    //@{
+    virtual u32_t getMemUsage() = 0;
+    virtual u32_t getCondNumber() = 0;
+    virtual u32_t getMaxLiveCondNumber() = 0;
+    /// Number of nodes (cubes) created, cheap to read
+    virtual u32_t getNodeNumber() = 0;
+    /// Number of AND/OR operations whose result exceeded the size limit (an operand is dropped)
+    inline u32_t getAndLimitHits() const {
+        return andLimitHits;
+    }
+    inline u32_t getOrLimitHits() const {
+        return orLimitHits;
+    }
+    /// Dynamic reordering statistics, only BDDs are reordered
+    virtual u32_t getReorderingNum() {
+        return 0;
+    }
+    /// Time spent in reordering (milliseconds)
+    virtual long getReorderingTime() {
+        return 0;
+    }
+    /// Live nodes removed by the reorderings
+    virtual u64_t getReorderedNodes() const {
+        return 0;
+    }
+    //@}
+
+protected:
+    u32_t andLimitHits;			///< AND operations exceeding the size limit
+    u32_t orLimitHits;			///< OR operations exceeding the size limit
+};
+
 /**
  * Using Cudd as conditions.
  */
-class BddCondManager {
+class BddCondManager : public CondManager {
 public:
     typedef std::map<unsigned,DdNode*> IndexToDDNodeMap;
 
-    /// Constructor
-    BddCondManager() {
-        m_bdd_mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
-    }
+    /// Constructor, dynamic reordering is enabled by -bdd-reorder
+    BddCondManager();
 
     /// Destructor
-    ~BddCondManager() {
-        delete m_bdd_mgr;
-    }
+    ~BddCondManager();
     /// Create new BDD condition
-    inline DdNode* createNewCond(unsigned i) {
+    inline CondExpr* createNewCond(unsigned i) {
         assert(indexToDDNodeMap.find(i)==indexToDDNodeMap.end() && "This should be fresh index to create new BDD");
         DdNode* d = Cudd_bddIthVar(m_bdd_mgr, i);
         indexToDDNodeMap[i] = d;
-        return  d;
+        return toCond(d);
+    }
+    /// Create the variables of the indices below num (in the index order), without conditions for them
+    inline void reserveVars(unsigned num) {
+        if (num > BddVarNum())
+            Cudd_bddIthVar(m_bdd_mgr, num - 1);
     }
     /// Get existing BDD condition
-    inline DdNode* getCond(unsigned i) const {
+    inline CondExpr* getCond(unsigned i) const {
         IndexToDDNodeMap::const_iterator it = indexToDDNodeMap.find(i);
         assert(it!=indexToDDNodeMap.end() && "condition not found!");
-        return it->second;
+        return toCond(it->second);
+    }
+    /// Copy a condition of another manager into this one, the variables are matched by their indices
+    inline CondExpr* transfer(const CondManager* from, CondExpr* cond) {
+        DdNode* d = Cudd_bddTransfer(static_cast<const BddCondManager*>(from)->m_bdd_mgr, m_bdd_mgr, toDd(cond));
+        assert(d && "BDD transfer out of memory?");
+        Cudd_Ref(d);
+        return toCond(d);
     }
     inline unsigned BddVarNum() {
         return Cudd_ReadSize(m_bdd_mgr);
     }
 
-    inline DdNode* getTrueCond() const {
-        return BddOne();
+    inline CondExpr* getTrueCond() const {
+        return toCond(BddOne());
     }
-    inline DdNode* getFalseCond() const {
-        return BddZero();
+    inline CondExpr* getFalseCond() const {
+        return toCond(BddZero());
     }
 
-    inline u32_t getBDDMemUsage() {
+    inline u32_t getMemUsage() {
         return Cudd_ReadMemoryInUse(m_bdd_mgr);
     }
     inline u32_t getCondNumber() {
@@ -83,16 +172,42 @@ public:
     inline u32_t getMaxLiveCondNumber() {
         return Cudd_ReadPeakLiveNodeCount(m_bdd_mgr);
     }
-    inline void markForRelease(DdNode* cond) {
-        Cudd_RecursiveDeref(m_bdd_mgr,cond);
+    /// Dynamic reordering statistics
+    //@{
+    inline u32_t getReorderingNum() {
+        return Cudd_ReadReorderings(m_bdd_mgr);
+    }
+    inline long getReorderingTime() {
+        return Cudd_ReadReorderingTime(m_bdd_mgr);
+    }
+    inline u64_t getReorderedNodes() const {
+        return reorderedNodes;
+    }
+    /// Called by the reordering hooks of CUDD
+    void beforeReordering();
+    void afterReordering();
+    //@}
+    /// Number of nodes in the unique table (including dead ones), cheap to read
+    inline u32_t getNodeNumber() {
+        return Cudd_ReadKeys(m_bdd_mgr);
+    }
+    inline void markForRelease(CondExpr* cond) {
+        Cudd_RecursiveDeref(m_bdd_mgr,toDd(cond));
+    }
+    /// Increase reference counting to keep the bdd alive
+    inline void retain(CondExpr* cond) {
+        Cudd_Ref(toDd(cond));
     }
     /// Operations on conditions.
     //@{
-    DdNode* AND(DdNode* lhs, DdNode* rhs);
-    DdNode* OR(DdNode* lhs, DdNode* rhs);
-    DdNode* NEG(DdNode* lhs);
+    CondExpr* AND(CondExpr* lhs, CondExpr* rhs);
+    CondExpr* OR(CondExpr* lhs, CondExpr* rhs);
+    CondExpr* NEG(CondExpr* lhs);
     //@}
 
+    inline void support(CondExpr* cond, NodeBS &support) const {
+        BddSupport(toDd(cond), support);
+    }
     /**
      * Utilities for dumping conditions. These methods use global functions from CUDD
      * package and they can be removed outside this class scope to be used by others.
@@ -101,15 +216,24 @@ public:
     void BddSupportStep( DdNode * f,  NodeBS &support) const;
     void BddSupport( DdNode * f,  NodeBS &support) const;
     void dump(DdNode* lhs, llvm::raw_ostream & O = llvm::outs());
-    std::string dumpStr(DdNode* lhs) const;
+    std::string dumpStr(CondExpr* lhs) const;
     /// print minterms and debug information for the Ddnode
     inline void printMinterms(DdNode* d) {
         Cudd_PrintMinterm(m_bdd_mgr,d);
     }
-    inline void printDbg(DdNode* d) {
-        Cudd_PrintDebug(m_bdd_mgr,d,0,3);
+    inline void printDbg(CondExpr* d) {
+        Cudd_PrintDebug(m_bdd_mgr,toDd(d),0,3);
     }
 private:
+    /// A BDD condition is the DdNode itself
+    //@{
+    static inline DdNode* toDd(CondExpr* cond) {
+        return reinterpret_cast<DdNode*>(cond);
+    }
+    static inline CondExpr* toCond(DdNode* d) {
+        return reinterpret_cast<CondExpr*>(d);
+    }
+    //@}
     inline DdNode* BddOne() const	{
         return Cudd_ReadOne(m_bdd_mgr);
     }
@@ -117,8 +241,131 @@ private:
         return Cudd_ReadLogicZero(m_bdd_mgr);
     }
 
+    inline u32_t getLiveNodeNumber() {
+        return Cudd_ReadKeys(m_bdd_mgr) - Cudd_ReadDead(m_bdd_mgr);
+    }
+
     DdManager *m_bdd_mgr;
     IndexToDDNodeMap indexToDDNodeMap;
+    u32_t liveBeforeReordering;	///< live nodes when the current reordering started
+    u64_t reorderedNodes;		///< live nodes removed by the reorderings
+};
+
+/**
+ * Cheap conditions for triage runs: a condition is a bounded disjunction of cubes,
+ * each cube is a conjunction of branch variables stored as two sparse bit vectors.
+ *
+ * The representation is not canonical, so it is coarser than BDDs: subsumed cubes
+ * are removed and two cubes differing only in the polarity of one variable are merged,
+ * which finds the common tautologies (e.g., c | !c). A condition growing beyond
+ * -max-cubes saturates to true (OR, NEG) or drops the rhs (AND), as BDDs do with -maxbddsize.
+ * Conditions are hash-consed, so equal cube sets are the same handle, and live until
+ * the manager is destroyed.
+ */
+class CubeCondManager : public CondManager {
+public:
+    /// A conjunction of literals
+    struct Cube {
+        NodeBS pos;		///< variables of the positive literals
+        NodeBS neg;		///< variables of the negative literals
+
+        bool operator< (const Cube& rhs) const;
+        inline bool operator== (const Cube& rhs) const {
+            return pos == rhs.pos && neg == rhs.neg;
+        }
+        /// Whether the literals of this cube are all in rhs (rhs implies this cube)
+        inline bool subsumes(const Cube& rhs) const {
+            return rhs.pos.contains(pos) && rhs.neg.contains(neg);
+        }
+    };
+    typedef std::vector<Cube> CubeVec;	///< sorted cubes of a condition, empty for false
+    typedef std::set<CubeVec> CubeVecSet;
+    typedef std::map<unsigned, CondExpr*> IndexToCondMap;
+
+    /// Constructor, the size limit is taken from -max-cubes
+    CubeCondManager();
+
+    /// Destructor
+    ~CubeCondManager();
+
+    CondExpr* createNewCond(unsigned i);
+    inline void reserveVars(unsigned num) {
+        if (num > varNum)
+            varNum = num;
+    }
+    inline CondExpr* getCond(unsigned i) const {
+        IndexToCondMap::const_iterator it = indexToCondMap.find(i);
+        assert(it!=indexToCondMap.end() && "condition not found!");
+        return it->second;
+    }
+    inline CondExpr* transfer(const CondManager* from, CondExpr* cond) {
+        return getOrAddCond(getCubes(cond));
+    }
+
+    inline CondExpr* getTrueCond() const {
+        return trueCond;
+    }
+    inline CondExpr* getFalseCond() const {
+        return falseCond;
+    }
+
+    /// Operations on conditions.
+    //@{
+    CondExpr* AND(CondExpr* lhs, CondExpr* rhs);
+    CondExpr* OR(CondExpr* lhs, CondExpr* rhs);
+    CondExpr* NEG(CondExpr* lhs);
+    //@}
+
+    /// Conditions are kept until the manager is destroyed
+    //@{
+    inline void retain(CondExpr* cond) {
+    }
+    inline void markForRelease(CondExpr* cond) {
+    }
+    //@}
+
+    void support(CondExpr* cond, NodeBS &support) const;
+    std::string dumpStr(CondExpr* cond) const;
+
+    /// Statistics
+    //@{
+    inline u32_t getMemUsage() {
+        return cubeNum * sizeof(Cube) + conds.size() * sizeof(CubeVec);
+    }
+    inline u32_t getCondNumber() {
+        return conds.size();
+    }
+    inline u32_t getMaxLiveCondNumber() {
+        return conds.size();
+    }
+    inline u32_t getNodeNumber() {
+        return cubeNum;
+    }
+    //@}
+
+private:
+    /// A cube condition is its hash-consed cube vector
+    //@{
+    static inline const CubeVec& getCubes(CondExpr* cond) {
+        return *reinterpret_cast<const CubeVec*>(cond);
+    }
+    static inline CondExpr* toCond(const CubeVec& cubes) {
+        return reinterpret_cast<CondExpr*>(const_cast<CubeVec*>(&cubes));
+    }
+    //@}
+    /// Get the unique condition of cubes, which are simplified first
+    CondExpr* getOrAddCond(const CubeVec& cubes);
+    /// Remove the subsumed cubes and merge the cubes resolving on one variable
+    static void simplify(CubeVec& cubes);
+    static bool resolve(const Cube& a, const Cube& b, Cube& merged);
+
+    CubeVecSet conds;			///< unique table of the conditions
+    IndexToCondMap indexToCondMap;
+    CondExpr* trueCond;
+    CondExpr* falseCond;
+    unsigned varNum;
+    u32_t maxCubes;				///< maximum number of cubes of a condition
+    u32_t cubeNum;				///< cubes of all the conditions
 };
 
 #endif /* BITVECTORCOND_H_ */
@@ -0,0 +1,176 @@
+//===- CxtStack.h -- Interned call string contexts----------------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * CxtStack.h
+ *
+ * Hash-consed call string contexts. A context stack is identified by a
+ * CxtStackID, which is a node of a parent-pointer trie. Each trie node holds
+ * the top element of the stack (a call site ID and whether it is a call or a
+ * return) and points to the stack below it. Identical stacks share one ID,
+ * so push/pop are O(1) and stacks are compared and hashed by their IDs.
+ */
+
+#ifndef CXTSTACK_H_
+#define CXTSTACK_H_
+
+#include "Util/BasicTypes.h"
+#include <llvm/ADT/DenseMap.h>
+#include <assert.h>
+
+typedef u32_t CxtStackID;
+
+class CxtStackTrie {
+
+public:
+    /// The empty stack, it is both "all calls" and "all returns"
+    static const CxtStackID EmptyStack = 0;
+
+    /// Constructor
+    CxtStackTrie() {
+        reset();
+    }
+    /// Destructor
+    ~CxtStackTrie() {
+    }
+
+    /// Push a call (or a return) at callsite csId on top of stack s
+    inline CxtStackID push(CxtStackID s, CallSiteID csId, bool isCall = true) {
+        u32_t elem = (csId << 1) | (isCall ? 1 : 0);
+        ChildKey key(s, elem);
+        ChildMap::const_iterator it = children.find(key);
+        if(it != children.end())
+            return it->second;
+
+        const TrieNode& parent = getTrieNode(s);
+        TrieNode node;
+        node.parent = s;
+        node.elem = elem;
+        node.depth = parent.depth + 1;
+        node.allCalls = parent.allCalls && isCall;
+        node.allRets = parent.allRets && !isCall;
+
+        CxtStackID id = nodes.size();
+        nodes.push_back(node);
+        children[key] = id;
+        return id;
+    }
+    /// Pop the top element of stack s
+    inline CxtStackID pop(CxtStackID s) const {
+        assert(!empty(s) && "pop an empty context stack?");
+        return getTrieNode(s).parent;
+    }
+    /// Callsite ID on top of stack s
+    inline CallSiteID top(CxtStackID s) const {
+        assert(!empty(s) && "empty context stack has no top?");
+        return getTrieNode(s).elem >> 1;
+    }
+    /// Whether the top of stack s is a call (otherwise a return)
+    inline bool isTopCall(CxtStackID s) const {
+        assert(!empty(s) && "empty context stack has no top?");
+        return getTrieNode(s).elem & 1;
+    }
+    inline bool empty(CxtStackID s) const {
+        return s == EmptyStack;
+    }
+    inline u32_t size(CxtStackID s) const {
+        return getTrieNode(s).depth;
+    }
+    /// Whether all the elements on stack s are calls/returns
+    //@{
+    inline bool isAllCalls(CxtStackID s) const {
+        return getTrieNode(s).allCalls;
+    }
+    inline bool isAllRets(CxtStackID s) const {
+        return getTrieNode(s).allRets;
+    }
+    //@}
+    /// Whether stack s contains callsite csId
+    inline bool contains(CxtStackID s, CallSiteID csId) const {
+        for(; !empty(s); s = pop(s)) {
+            if(top(s) == csId)
+                return true;
+        }
+        return false;
+    }
+    /// Callsite IDs of stack s from bottom to top
+    inline void getCallSites(CxtStackID s, CallStrCxt& cxt) const {
+        cxt.resize(size(s));
+        for(u32_t i = size(s); i > 0; --i, s = pop(s))
+            cxt[i - 1] = top(s);
+    }
+    /// Drop the bottom (oldest) element of stack s, used when a context exceeds its length limit
+    inline CxtStackID dropBottom(CxtStackID s) {
+        assert(!empty(s) && "drop the bottom of an empty context stack?");
+        std::vector<u32_t> elems;
+        for(; !empty(s); s = pop(s))
+            elems.push_back(getTrieNode(s).elem);
+
+        CxtStackID res = EmptyStack;
+        for(u32_t i = elems.size() - 1; i > 0; --i)
+            res = push(res, elems[i - 1] >> 1, elems[i - 1] & 1);
+        return res;
+    }
+
+    /// Number of interned stacks
+    inline u32_t getStackNum() const {
+        return nodes.size();
+    }
+    /// Release all the stacks, IDs handed out before are invalidated.
+    /// The storage is kept for the stacks of the next client (e.g. the next slice)
+    inline void reset() {
+        nodes.clear();
+        children.clear();
+        TrieNode root;
+        root.parent = EmptyStack;
+        root.elem = 0;
+        root.depth = 0;
+        root.allCalls = true;
+        root.allRets = true;
+        nodes.push_back(root);
+    }
+
+private:
+    /// (stack, pushed element) hashed to the resulting stack, so that a push is
+    /// one hash lookup (the pair hash mixes both halves, a packed u64_t key would
+    /// be hashed on its low half only)
+    typedef std::pair<CxtStackID, u32_t> ChildKey;
+    typedef llvm::DenseMap<ChildKey, CxtStackID> ChildMap;
+
+    struct TrieNode {
+        CxtStackID parent;	///< stack below the top element
+        u32_t elem;			///< top element, (callsite ID << 1) | isCall
+        u32_t depth;		///< stack size
+        bool allCalls;		///< all elements are calls
+        bool allRets;		///< all elements are returns
+    };
+
+    inline const TrieNode& getTrieNode(CxtStackID s) const {
+        assert(s < nodes.size() && "not an interned context stack?");
+        return nodes[s];
+    }
+
+    std::vector<TrieNode> nodes;	///< trie nodes indexed by CxtStackID
+    ChildMap children;				///< (stack, pushed element) to the resulting stack
+};
+
+#endif /* CXTSTACK_H_ */
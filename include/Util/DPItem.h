@@ -31,6 +31,7 @@
 #define DPITEM_H_
 
 #include "Util/PathCondAllocator.h"
+#include "Util/CxtStack.h"
 #include "MemoryModel/ConditionalPT.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>    // std::sort
@@ -160,25 +161,29 @@ public:
 
 /*!
  * Context Condition
+ * The call string is interned in a per-thread CxtStackTrie, so that copying,
+ * pushing, popping and comparing contexts do not touch the call string itself.
+ * A context should only be used by the thread which creates it.
  */
 class ContextCond {
 public:
-    typedef CallStrCxt::const_iterator const_iterator;
     /// Constructor
-    ContextCond():concreteCxt(true) {
+    ContextCond():context(CxtStackTrie::EmptyStack), concreteCxt(true) {
     }
     /// Copy Constructor
-    ContextCond(const ContextCond& cond): context(cond.getContexts()), concreteCxt(cond.isConcreteCxt()) {
+    ContextCond(const ContextCond& cond): context(cond.getCxtStack()), concreteCxt(cond.isConcreteCxt()) {
     }
     /// Destructor
     virtual ~ContextCond() {
     }
-    /// Get context
-    inline const CallStrCxt& getContexts() const {
-        return context;
+    /// Get context (callsites from the bottom to the top of the stack)
+    inline CallStrCxt getContexts() const {
+        CallStrCxt cxt;
+        getCxtTrie().getCallSites(context, cxt);
+        return cxt;
     }
-    /// Get context
-    inline CallStrCxt& getContexts() {
+    /// Get the interned context stack
+    inline CxtStackID getCxtStack() const {
         return context;
     }
     /// Whether it is an concrete context
@@ -191,11 +196,11 @@ public:
     }
     /// Whether contains callstring cxt
     inline bool containCallStr(NodeID cxt) const {
-        return std::find(context.begin(),context.end(),cxt) != context.end();
+        return getCxtTrie().contains(context, cxt);
     }
     /// Get context size
     inline u32_t cxtSize() const {
-        return context.size();
+        return getCxtTrie().size(context);
     }
     /// set max context limit
     static inline void setMaxCxtLen(u32_t max) {
@@ -206,21 +211,31 @@ public:
         return maximumCxtLen;
     }
 
+    /// The trie interning the contexts of the current thread
+    static inline CxtStackTrie& getCxtTrie() {
+        static thread_local CxtStackTrie trie;
+        return trie;
+    }
+    /// Release the contexts of the current thread, called when a client (e.g. the
+    /// traversal of a slice) is done, no context of this thread may be used afterwards
+    static inline void resetCxtTrie() {
+        getCxtTrie().reset();
+    }
+
     /// Push context
     inline virtual bool pushContext(NodeID ctx) {
+        CxtStackTrie& trie = getCxtTrie();
+        if(trie.size(context) < maximumCxtLen) {
+            context = trie.push(context, ctx);
 
-        if(context.size() < maximumCxtLen) {
-            context.push_back(ctx);
-
-            if(context.size() > maximumCxt)
-                maximumCxt = context.size();
+            if(trie.size(context) > maximumCxt)
+                maximumCxt = trie.size(context);
             return true;
         }
         else { /// handle out of context limit case
-            if(!context.empty()) {
+            if(!trie.empty(context)) {
                 setNonConcreteCxt();
-                context.erase(context.begin());
-                context.push_back(ctx);
+                context = trie.push(trie.dropBottom(context), ctx);
             }
             return false;
         }
@@ -228,64 +243,58 @@ public:
 
     /// Match context
     inline virtual bool matchContext(NodeID ctx) {
+        CxtStackTrie& trie = getCxtTrie();
         /// if context is empty, then it is the unbalanced parentheses match
-        if(context.empty())
+        if(trie.empty(context))
             return true;
         /// otherwise, we perform balanced parentheses matching
-        else if(context.back() == ctx) {
-            context.pop_back();
+        else if(trie.top(context) == ctx) {
+            context = trie.pop(context);
             return true;
         }
         return false;
     }
 
     /// Enable compare operator to avoid duplicated item insertion in map or set
-    /// to be noted that two vectors can also overload operator()
+    /// interned contexts are ordered by their IDs
     inline bool operator< (const ContextCond& rhs) const {
         return context < rhs.context;
     }
     /// Overloading operator[]
     inline NodeID operator[] (const u32_t index) const {
-        assert(index < context.size());
-        return context[index];
+        assert(index < cxtSize());
+        return getContexts()[index];
     }
     /// Overloading operator=
     inline ContextCond& operator= (const ContextCond& rhs) {
         if(*this!=rhs) {
-            context = rhs.getContexts();
+            context = rhs.getCxtStack();
             concreteCxt = rhs.isConcreteCxt();
         }
         return *this;
     }
     /// Overloading operator==
     inline bool operator== (const ContextCond& rhs) const {
-        return (context == rhs.getContexts());
+        return (context == rhs.getCxtStack());
     }
     /// Overloading operator!=
     inline bool operator!= (const ContextCond& rhs) const {
         return !(*this==rhs);
     }
-    /// Begin iterators
-    inline const_iterator begin() const {
-        return context.begin();
-    }
-    /// End iterators
-    inline const_iterator end() const {
-        return context.end();
-    }
     /// Dump context condition
     inline std::string toString() const {
         std::string str;
         llvm::raw_string_ostream rawstr(str);
         rawstr << "[:";
-        for(CallStrCxt::const_iterator it = context.begin(), eit = context.end(); it!=eit; ++it) {
+        CallStrCxt cxt = getContexts();
+        for(CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it!=eit; ++it) {
             rawstr << *it << " ";
         }
         rawstr << " ]";
         return rawstr.str();
     }
 protected:
-    CallStrCxt context;
+    CxtStackID context;
 private:
     static u32_t maximumCxtLen;
     bool concreteCxt;
@@ -481,7 +490,7 @@ public:
     }
     /// Overloading operator==
     inline bool operator== (const VFPathCond& rhs) const {
-        return (context == rhs.getContexts() && path == rhs.getPaths());
+        return (context == rhs.getCxtStack() && path == rhs.getPaths());
     }
     /// Overloading operator!=
     inline bool operator!= (const VFPathCond& rhs) const {
@@ -501,7 +510,8 @@ public:
         std::string str;
         llvm::raw_string_ostream rawstr(str);
         rawstr << "[:";
-        for(CallStrCxt::const_iterator it = context.begin(), eit = context.end(); it!=eit; ++it) {
+        CallStrCxt cxt = getContexts();
+        for(CallStrCxt::const_iterator it = cxt.begin(), eit = cxt.end(); it!=eit; ++it) {
             rawstr << *it << " ";
         }
         rawstr << " | ";
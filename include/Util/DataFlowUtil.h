@@ -180,6 +180,8 @@ public:
         if(it==funToPDTMap.end()) {
             llvm::PostDominatorTree* postDT = new llvm::PostDominatorTree();
             postDT->runOnFunction(*fun);
+            /// numbered upfront, so that the dominance queries do not update the tree
+            postDT->DT->updateDFSNumbers();
             funToPDTMap[fun] = postDT;
             return postDT;
         }
@@ -194,6 +196,7 @@ public:
         if(it==funToDTMap.end()) {
             llvm::DominatorTree* dt = new llvm::DominatorTree();
             dt->recalculate(*fun);
+            dt->updateDFSNumbers();
             funToDTMap[fun] = dt;
             return dt;
         }
@@ -0,0 +1,143 @@
+//===- GraphArena.h -- Slab allocator of graph nodes and edges---------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * GraphArena.h
+ */
+
+#ifndef GRAPHARENA_H_
+#define GRAPHARENA_H_
+
+#include <assert.h>
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+
+/*!
+ * Arena of the nodes and edges of a graph (see GenericGraph).
+ *
+ * Objects are bump-allocated from slabs, one chain of slabs per size class,
+ * so that the objects of a hot node/edge class sit next to each other.
+ * A deleted object goes to the free list of its size class and the slabs
+ * are released in bulk with the arena, i.e. when the graph is destroyed.
+ *
+ * Every object has a one-word header naming its arena, objects allocated
+ * by a plain new (no arena, or too large) have a NULL one and live on the heap.
+ * An arena is not thread-safe, a graph is built and edited by one thread.
+ */
+class GraphArena {
+
+public:
+    /// Constructor
+    GraphArena();
+
+    /// Destructor, release all the slabs
+    ~GraphArena();
+
+    /// Allocate an object of size bytes from this arena
+    void* allocate(size_t size);
+
+    /// Allocate an object of size bytes owned by no arena
+    static inline void* allocateUnowned(size_t size) {
+        Header* header = static_cast<Header*>(std::malloc(HeaderSize + size));
+        assert(header && "out of memory");
+        header->arena = NULL;
+        return header + 1;
+    }
+
+    /// Release an object of size bytes allocated by allocate or allocateUnowned
+    static inline void deallocate(void* p, size_t size) {
+        if (p == NULL)
+            return;
+        Header* header = static_cast<Header*>(p) - 1;
+        if (header->arena)
+            header->arena->recycle(header, size);
+        else
+            std::free(header);
+    }
+
+    /// Statistics
+    //@{
+    inline size_t getSlabBytes() const {
+        return slabBytes;
+    }
+    inline size_t getAllocatedNum() const {
+        return allocatedNum;
+    }
+    inline size_t getRecycledNum() const {
+        return recycledNum;
+    }
+    //@}
+
+private:
+    /// Header of an object
+    struct Header {
+        GraphArena* arena;
+    };
+    /// A free slot links to the next one of its size class
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+    /// Bump pointer and free list of a size class
+    struct SizeClass {
+        char* cur;
+        char* end;
+        FreeSlot* freeList;
+        size_t nextSlabSize;
+    };
+
+    static const size_t HeaderSize = sizeof(Header);
+    static const size_t Alignment = sizeof(void*);
+    static const size_t MaxObjectSize = 512;	///< larger objects are allocated on the heap
+    static const size_t MinSlabSize = 4096;
+    static const size_t MaxSlabSize = 1 << 20;
+
+    /// Size class of an object of size bytes
+    static inline size_t getSizeClass(size_t size) {
+        return (size + Alignment - 1) / Alignment;
+    }
+
+    /// Put the slot of an object back to the free list of its size class
+    inline void recycle(Header* header, size_t size) {
+        assert(size <= MaxObjectSize && "object not allocated from the arena");
+        FreeSlot* slot = reinterpret_cast<FreeSlot*>(header);
+        SizeClass& sc = classes[getSizeClass(size)];
+        slot->next = sc.freeList;
+        sc.freeList = slot;
+        recycledNum++;
+    }
+
+    /// Add a slab to a size class
+    void grow(SizeClass& sc, size_t slotSize);
+
+    SizeClass classes[MaxObjectSize / Alignment + 1];
+    std::vector<void*> slabs;
+    size_t slabBytes;		///< bytes of all the slabs
+    size_t allocatedNum;	///< objects allocated from the arena
+    size_t recycledNum;		///< objects whose slots were put back to a free list
+    bool enabled;			///< false with -graph-arena=false, objects then live on the heap
+
+    GraphArena(const GraphArena&);	///< not copyable
+    void operator=(const GraphArena&);
+};
+
+#endif /* GRAPHARENA_H_ */
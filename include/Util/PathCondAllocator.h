@@ -34,16 +34,23 @@
 #include "Util/Conditions.h"
 #include "Util/WorkList.h"
 #include "Util/DataFlowUtil.h"
+#include <mutex>
 
 /**
  * PathCondAllocator allocates conditions for each basic block of a certain CFG.
+ *
+ * The conditions are BDDs by default, or cheaper cube sets (see -cond-backend).
+ * CUDD is not thread-safe, so a thread computing guards concurrently with others
+ * attaches a worker state (see attachWorker) with its own condition manager. The branch
+ * conditions are transferred to the worker manager with the same variable indices,
+ * and the results are transferred back to the main manager for bug reporting.
  */
 class PathCondAllocator {
 
 public:
     static u32_t totalCondNum;
 
-    typedef DdNode Condition;
+    typedef CondExpr Condition;
     typedef std::map<u32_t,Condition*> CondPosMap;		///< map a branch to its Condition
     typedef std::map<const llvm::BasicBlock*, CondPosMap > BBCondMap;	// map bb to a Condition
     typedef std::map<const Condition*, const llvm::TerminatorInst* > CondToTermInstMap;	// map a condition to its branch instruction
@@ -51,10 +58,37 @@ public:
     typedef std::map<const llvm::Function*,  BasicBlockSet> FunToExitBBsMap;  ///< map a function to all its basic blocks calling program exit
     typedef std::map<const llvm::BasicBlock*, Condition*> BBToCondMap;	///< map a basic block to its condition during control-flow guard computation
     typedef FIFOWorkList<const llvm::BasicBlock*> CFWorkList;	///< worklist for control-flow guard computation
+    typedef std::pair<const llvm::BasicBlock*, const llvm::BasicBlock*> BBPair;
+    typedef std::pair<BBPair, const llvm::Value*> GuardKey;	///< (srcBB, dstBB, curEvalVal) of an intra-procedural guard
+    typedef std::list<GuardKey> GuardLRUList;	///< cached guards from the most to the least recently used
+    typedef std::map<GuardKey, std::pair<Condition*, GuardLRUList::iterator> > GuardCacheMap;
+    typedef std::set<const llvm::Function*> FunctionSet;
+    typedef std::map<const llvm::Function*, u32_t> FunToCondIndexMap;	///< map a function to the index of its first condition
+
+    /*!
+     * Conditions of one BDD manager: the branch conditions, the control-flow conditions
+     * of the guard under computation and the memoized guards
+     */
+    struct CondState {
+        CondManager* condMgr;				///< condition manager of the conditions below
+        BBCondMap bbConds;					///< map basic block to its successors/predecessors branch conditions
+        FunctionSet condFuns;				///< functions whose branch conditions are in bbConds
+        BBToCondMap bbToCondMap;			///< map a basic block to its path condition starting from root
+        const llvm::Value* curEvalVal;		///< current llvm value to evaluate branch condition when computing guards
+        GuardCacheMap guardCache;			///< memoized intra-procedural guards
+        GuardLRUList guardLRU;				///< recency order of the memoized guards
+        u32_t guardCacheHits;				///< number of guards found in the cache
+        u32_t guardCacheMisses;				///< number of guards computed
+        u32_t guardCacheEvictions;			///< number of guards evicted from the cache
+
+        CondState(CondManager* mgr): condMgr(mgr), curEvalVal(NULL),
+            guardCacheHits(0), guardCacheMisses(0), guardCacheEvictions(0) {
+        }
+    };
+    typedef std::vector<CondState*> CondStateVec;
 
     /// Constructor
-    PathCondAllocator() {
-        getBddCondManager();
+    PathCondAllocator(): mainState(getMainCondManager()) {
     }
     /// Destructor
     virtual ~PathCondAllocator() {
@@ -71,7 +105,7 @@ public:
     /// Statistics
     //@{
     static inline u32_t getMemUsage() {
-        return getBddCondManager()->getBDDMemUsage();
+        return getBddCondManager()->getMemUsage();
     }
     static inline u32_t getCondNum() {
         return getBddCondManager()->getCondNumber();
@@ -79,11 +113,30 @@ public:
     static inline u32_t getMaxLiveCondNumber() {
         return getBddCondManager()->getMaxLiveCondNumber();
     }
+    static inline u32_t getBddNodeNum() {
+        return getBddCondManager()->getNodeNumber();
+    }
     //@}
 
-    /// Perform path allocation
+    /// Perform path allocation. The condition indices of every function are reserved here,
+    /// the conditions of a function are allocated when a guard computation enters it (see -lazy-cond)
     void allocate(const llvm::Module& module);
 
+    /// Per-thread BDD managers
+    //@{
+    /// Let the calling thread compute conditions on a worker manager until detachWorker,
+    /// the worker states are reused by the next threads attaching to this allocator
+    void attachWorker();
+    void detachWorker();
+    /// Transfer a condition of the calling thread to the main manager (identity on the main thread)
+    Condition* transferToMain(Condition* cond);
+    /// The main manager is used by worker threads when they transfer their results,
+    /// the main thread holds this lock while it uses the main manager concurrently with workers
+    static inline std::mutex& getMainCondMutex() {
+        return mainCondMutex;
+    }
+    //@}
+
     /// Get llvm conditional expression
     inline const llvm::TerminatorInst* getCondInst(const Condition* cond) const {
         CondToTermInstMap::const_iterator it = condToInstMap.find(cond);
@@ -91,56 +144,59 @@ public:
         return it->second;
     }
 
-    /// Get dominators
+    /// Get dominators, the control-flow info is built on demand by concurrent threads
     inline llvm::DominatorTree* getDT(const llvm::Function* fun) {
+        std::lock_guard<std::mutex> lock(cfInfoMutex);
         return cfInfoBuilder.getDT(fun);
     }
     /// Get Postdominators
     inline llvm::PostDominatorTree* getPostDT(const llvm::Function* fun) {
+        std::lock_guard<std::mutex> lock(cfInfoMutex);
         return cfInfoBuilder.getPostDT(fun);
     }
     /// Get LoopInfo
     PTALoopInfo* getLoopInfo(const llvm::Function* f) {
+        std::lock_guard<std::mutex> lock(cfInfoMutex);
         return cfInfoBuilder.getLoopInfo(f);
     }
 
     /// Condition operations
     //@{
     inline Condition* condAnd(Condition* lhs, Condition* rhs) {
-        return bddCondMgr->AND(lhs,rhs);
+        return getState().condMgr->AND(lhs,rhs);
     }
     inline Condition* condOr(Condition* lhs, Condition* rhs) {
-        return bddCondMgr->OR(lhs,rhs);
+        return getState().condMgr->OR(lhs,rhs);
     }
     inline Condition* condNeg(Condition* cond) {
-        return bddCondMgr->NEG(cond);
+        return getState().condMgr->NEG(cond);
     }
     inline Condition* getTrueCond() const {
-        return bddCondMgr->getTrueCond();
+        return getState().condMgr->getTrueCond();
     }
     inline Condition* getFalseCond() const {
-        return bddCondMgr->getFalseCond();
+        return getState().condMgr->getFalseCond();
     }
     /// Given an index, get its condition
     inline Condition* getCond(u32_t i) const {
-        return bddCondMgr->getCond(i);
+        return getState().condMgr->getCond(i);
     }
     /// Iterator every element of the bdd
     inline NodeBS exactCondElem(Condition* cond) {
         NodeBS elems;
-        bddCondMgr->BddSupport(cond,elems);
+        getState().condMgr->support(cond,elems);
         return elems;
     }
     /// Decrease reference counting for the bdd
     inline void markForRelease(Condition* cond) {
-        bddCondMgr->markForRelease(cond);
+        getState().condMgr->markForRelease(cond);
     }
     /// Print debug information for this condition
     inline void printDbg(Condition* cond) {
-        bddCondMgr->printDbg(cond);
+        getState().condMgr->printDbg(cond);
     }
     inline std::string dumpCond(Condition* cond) const {
-        return bddCondMgr->dumpStr(cond);
+        return getState().condMgr->dumpStr(cond);
     }
     //@}
 
@@ -155,25 +211,52 @@ public:
     virtual Condition* getPHIComplementCond(const llvm::BasicBlock* BB1, const llvm::BasicBlock* BB2, const llvm::BasicBlock* BB0);
 
     inline void clearCFCond() {
-        bbToCondMap.clear();
+        getState().bbToCondMap.clear();
     }
     /// Set current value for branch condition evaluation
     inline void setCurEvalVal(const llvm::Value* val) {
-        curEvalVal = val;
+        getState().curEvalVal = val;
     }
     /// Get current value for branch condition evaluation
     inline const llvm::Value* getCurEvalVal() const {
-        return curEvalVal;
+        return getState().curEvalVal;
     }
     //@}
 
     /// Print out the path condition information
     void printPathCond();
 
+    /// Guard cache statistics (of the main and the worker states)
+    void printGuardCacheStat();
+
+    /// Size limit and reordering statistics of the BDD managers (the main and the worker ones)
+    void printBddManagerStat();
+
 private:
 
-    /// Allocate path condition for every basic block
-    virtual void allocateForBB(const llvm::BasicBlock& bb);
+    /// Allocate path condition for every basic block, index is the next condition index of its function
+    virtual void allocateForBB(const llvm::BasicBlock& bb, u32_t& index);
+
+    /// Allocate the branch conditions of a function in the state of the calling thread if not yet
+    void allocateForFunction(const llvm::Function* fun);
+    /// Allocate the branch conditions of a function in the main state if not yet
+    void allocateMainConds(const llvm::Function* fun);
+    /// Number of conditions of a basic block, log2 of its successor number
+    u32_t getCondNumOfBB(const llvm::BasicBlock& bb) const;
+
+    /// Basic blocks of a function in the order their conditions are allocated (see -cond-order),
+    /// the variables of a function are contiguous in all orders
+    void getBBsInCondOrder(const llvm::Function& fun, std::vector<const llvm::BasicBlock*>& bbs);
+
+    /// Compute an intra-procedural guard by a control-flow traversal starting from src
+    Condition* computeIntraVFGGuard(const llvm::BasicBlock* src, const llvm::BasicBlock* dst);
+
+    /// Guard cache operations, cached guards are referenced so that they stay alive across queries
+    //@{
+    bool lookupGuard(const GuardKey& key, Condition*& cond);
+    void insertGuard(const GuardKey& key, Condition* cond);
+    void releaseGuardCache();
+    //@}
 
     /// Get/Set a branch condition, and its terminator instruction
     //@{
@@ -222,6 +305,7 @@ private:
     /// Get/Set control-flow conditions
     //@{
     inline bool setCFCond(const llvm::BasicBlock* bb, Condition* cond) {
+        BBToCondMap& bbToCondMap = getState().bbToCondMap;
         BBToCondMap::iterator it = bbToCondMap.find(bb);
         if(it!=bbToCondMap.end() && it->second == cond)
             return false;
@@ -230,6 +314,7 @@ private:
         return true;
     }
     inline Condition* getCFCond(const llvm::BasicBlock* bb) const {
+        const BBToCondMap& bbToCondMap = getState().bbToCondMap;
         BBToCondMap::const_iterator it = bbToCondMap.find(bb);
         if(it==bbToCondMap.end()) {
             return getFalseCond();
@@ -238,32 +323,58 @@ private:
     }
     //@}
 
-    /// Allocate a new condition
-    inline Condition* newCond(const llvm::TerminatorInst* inst) {
-        Condition* cond = bddCondMgr->createNewCond(totalCondNum++);
+    /// Allocate a new condition with its reserved index
+    inline Condition* newCond(const llvm::TerminatorInst* inst, u32_t index) {
+        Condition* cond = mainState.condMgr->createNewCond(index);
         assert(condToInstMap.find(cond)==condToInstMap.end() && "this should be a fresh condition");
         condToInstMap[cond] = inst;
         return cond;
     }
     /// Used internally, not supposed to be exposed to other classes
-    static BddCondManager* getBddCondManager() {
+    //@{
+    static CondManager* getMainCondManager() {
         if(bddCondMgr==NULL)
-            bddCondMgr = new BddCondManager();
+            bddCondMgr = CondManager::createCondManager();
         return bddCondMgr;
     }
+    /// The manager of the calling thread
+    static CondManager* getBddCondManager() {
+        if(workerState)
+            return workerState->condMgr;
+        return getMainCondManager();
+    }
+    //@}
+
+    /// Conditions of the calling thread
+    //@{
+    inline CondState& getState() {
+        return workerState ? *workerState : mainState;
+    }
+    inline const CondState& getState() const {
+        return workerState ? *workerState : mainState;
+    }
+    //@}
+
+    /// Create a worker state with the branch conditions of the main state
+    CondState* createWorkerState();
 
     /// Release memory
     void destroy();
 
     CondToTermInstMap condToInstMap;		///< map a condition to its corresponding llvm instruction
     PTACFInfoBuilder cfInfoBuilder;		    ///< map a function to its loop info
+    std::mutex cfInfoMutex;					///< guard of cfInfoBuilder
     FunToExitBBsMap funToExitBBsMap;		///< map a function to all its basic blocks calling program exit
-    BBToCondMap bbToCondMap;				///< map a basic block to its path condition starting from root
-    const llvm::Value* curEvalVal;			///< current llvm value to evaluate branch condition when computing guards
+    FunToCondIndexMap funToCondIndexMap;	///< condition indices reserved for every function
+    CondStateVec workerStates;				///< all the worker states
+    CondStateVec idleWorkerStates;			///< worker states not attached to a thread
+    std::mutex workerMutex;					///< guard of the worker states
 
 protected:
-    static BddCondManager* bddCondMgr;		///< bbd manager
-    BBCondMap bbConds;						///< map basic block to its successors/predecessors branch conditions
+    static CondManager* bddCondMgr;		///< condition manager of the main state
+    static std::mutex mainCondMutex;		///< guard of the main manager when workers are attached
+    static thread_local CondState* workerState;	///< worker state attached to the calling thread
+    CondState mainState;					///< conditions of the main manager
 
 };
 
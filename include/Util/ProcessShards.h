@@ -0,0 +1,116 @@
+//===- ProcessShards.h -- Sharding work items over forked processes----------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * ProcessShards.h
+ *
+ * Run work items in forked worker processes. The items are dealt round-robin
+ * to the shards, and every shard runs in its own child process, which shares
+ * the memory of the parent copy-on-write (e.g., the SVFG and the BDD manager),
+ * so that components which are not thread-safe can still use every core.
+ *
+ * A child reports its progress through a small file. If it crashes or an item
+ * runs out of time (see the timeout), the item in flight is recorded as failed
+ * and a new child continues the shard from the next item. The standard output
+ * and error of the children are captured and replayed by the parent in the shard
+ * order. The data an item hands back (e.g. its reports or statistics) is kept by
+ * the parent per item, so that it can be used in the item order.
+ */
+
+#ifndef PROCESSSHARDS_H_
+#define PROCESSSHARDS_H_
+
+#include "Util/BasicTypes.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+class ProcessShards {
+
+public:
+    /// Run one item in a child process, the returned values are summed up by the parent
+    /// and the data filled by the item is handed to the parent (see getItemData)
+    typedef std::function<u64_t(u32_t, std::string&)> ItemFunc;
+
+    /// Statistics of one shard
+    struct ShardStat {
+        u32_t itemNum = 0;			///< items of this shard
+        u32_t doneNum = 0;			///< items finished
+        u32_t processNum = 0;		///< child processes forked
+        u64_t result = 0;			///< sum of the values returned by the finished items
+        std::vector<u32_t> timedOutItems;
+        std::vector<u32_t> crashedItems;
+        std::string out;			///< captured standard output
+        std::string err;			///< captured standard error
+    };
+
+    /// Constructor, timeout is the time limit in seconds of one item (0: no limit)
+    ProcessShards(u32_t shards, u32_t timeout) : shardNum(shards), timeLimit(timeout) {
+    }
+
+    /// Run items [0, itemNum) and return the sum of their results
+    u64_t run(u32_t itemNum, ItemFunc func);
+
+    /// Replay the captured outputs and print the shard statistics
+    void printResults() const;
+
+    inline const std::vector<ShardStat>& getShardStats() const {
+        return stats;
+    }
+
+    /// Data handed back by an item, empty if the item did not finish
+    inline const std::string& getItemData(u32_t item) const {
+        return itemData[item];
+    }
+
+private:
+    /// Progress of a child, written after each item
+    struct Progress {
+        u32_t current;		///< position of the item in flight
+        u32_t next;			///< position of the first unfinished item
+        u64_t result;		///< sum of the results of the finished items
+    };
+
+    /// A child process running a shard from a position
+    struct ChildRun {
+        u32_t shard;
+        std::string outFile;
+        std::string errFile;
+        std::string progFile;
+        std::string dataFile;	///< data of the finished items, (position, size, data) records
+    };
+
+    u32_t shardNum;
+    u32_t timeLimit;
+    std::vector<ShardStat> stats;
+    std::vector<std::vector<u32_t> > shardItems;	///< items of each shard
+    std::vector<u32_t> shardNext;					///< position of the next item to run in each shard
+    std::vector<std::string> itemData;				///< data handed back by each item
+
+    /// Fork a child running the shard from its next position, return its pid
+    int startChild(u32_t shard, ItemFunc& func, ChildRun& child);
+
+    /// Collect the results of a terminated child
+    void collectChild(const ChildRun& child, int status);
+};
+
+#endif /* PROCESSSHARDS_H_ */
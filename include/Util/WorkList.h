@@ -37,17 +37,229 @@
 #define WORKLIST_H_
 
 #include <assert.h>
+#include <algorithm>
 #include <cstdlib>
+#include <stdint.h>
 #include <vector>
 #include <deque>
 #include <set>
+#include <type_traits>
+
+/**
+ * Membership sets of the worklists, each with find/insert/erase/clear.
+ * WorkListSetTraits picks one from the element type:
+ *   dense unsigned IDs (e.g. NodeID)   DenseIDSet, one bit per ID
+ *   pointers                           PointerHashSet, open addressing
+ *   anything else                      OrderedSet, a std::set
+ */
+template<class Data>
+class OrderedSet {
+public:
+    inline bool find(const Data& data) const {
+        return dataSet.find(data) != dataSet.end();
+    }
+    inline bool insert(const Data& data) {
+        return dataSet.insert(data).second;
+    }
+    inline void erase(const Data& data) {
+        dataSet.erase(data);
+    }
+    inline void clear() {
+        dataSet.clear();
+    }
+
+private:
+    std::set<Data> dataSet;
+};
+
+template<class Data>
+class DenseIDSet {
+    typedef uint64_t Word;
+    static const unsigned WordBits = 64;
+public:
+    inline bool find(Data data) const {
+        size_t w = data / WordBits;
+        return w < words.size() && (words[w] & mask(data));
+    }
+    inline bool insert(Data data) {
+        size_t w = data / WordBits;
+        if (w >= words.size())
+            words.resize(std::max(w + 1, words.size() * 2), 0);
+        if (words[w] & mask(data))
+            return false;
+        words[w] |= mask(data);
+        return true;
+    }
+    inline void erase(Data data) {
+        size_t w = data / WordBits;
+        if (w < words.size())
+            words[w] &= ~mask(data);
+    }
+    /// Keep the words allocated, the same IDs are likely to come back
+    inline void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+private:
+    static inline Word mask(Data data) {
+        return (Word)1 << (data % WordBits);
+    }
+    std::vector<Word> words;
+};
+
+template<class Data>
+class PointerHashSet {
+public:
+    PointerHashSet(): num(0), hasNull(false) {}
+
+    inline bool find(Data data) const {
+        if (data == NULL)
+            return hasNull;
+        if (slots.empty())
+            return false;
+        return slots[lookup(data)] == data;
+    }
+    inline bool insert(Data data) {
+        if (data == NULL) {
+            bool inserted = !hasNull;
+            hasNull = true;
+            return inserted;
+        }
+        /// keep the load factor under 3/4
+        if ((num + 1) * 4 > slots.size() * 3)
+            rehash(slots.empty() ? 64 : slots.size() * 2);
+        size_t i = lookup(data);
+        if (slots[i] == data)
+            return false;
+        slots[i] = data;
+        num++;
+        return true;
+    }
+    /// Backward-shift deletion, so that no tombstones are needed
+    inline void erase(Data data) {
+        if (data == NULL) {
+            hasNull = false;
+            return;
+        }
+        if (slots.empty())
+            return;
+        size_t i = lookup(data);
+        if (slots[i] != data)
+            return;
+        size_t m = slots.size() - 1;
+        for (size_t j = (i + 1) & m; slots[j] != NULL; j = (j + 1) & m) {
+            size_t home = hash(slots[j]) & m;
+            /// move slots[j] into the hole if its home is not in (i, j]
+            if (((j - home) & m) >= ((j - i) & m)) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i] = NULL;
+        num--;
+    }
+    inline void clear() {
+        std::fill(slots.begin(), slots.end(), (Data)NULL);
+        num = 0;
+        hasNull = false;
+    }
+
+private:
+    /// Fibonacci hashing, nodes allocated next to each other spread over the table
+    static inline size_t hash(Data data) {
+        uint64_t h = (uint64_t)(uintptr_t)data * 0x9E3779B97F4A7C15ULL;
+        return (size_t)(h ^ (h >> 32));
+    }
+    /// The slot holding data, or the empty slot where it would go
+    inline size_t lookup(Data data) const {
+        size_t m = slots.size() - 1;
+        size_t i = hash(data) & m;
+        while (slots[i] != NULL && slots[i] != data)
+            i = (i + 1) & m;
+        return i;
+    }
+    void rehash(size_t size) {
+        std::vector<Data> old(size, (Data)NULL);
+        old.swap(slots);
+        for (typename std::vector<Data>::const_iterator it = old.begin(), eit = old.end(); it != eit; ++it) {
+            if (*it != NULL)
+                slots[lookup(*it)] = *it;
+        }
+    }
+
+    std::vector<Data> slots;	///< power-of-two table with linear probing, NULL for empty
+    size_t num;
+    bool hasNull;
+};
+
+template<class Data, class Enable = void>
+struct WorkListSetTraits {
+    typedef OrderedSet<Data> SetTy;
+};
+
+template<class Data>
+struct WorkListSetTraits<Data, typename std::enable_if<std::is_integral<Data>::value && std::is_unsigned<Data>::value>::type> {
+    typedef DenseIDSet<Data> SetTy;
+};
+
+template<class Data>
+struct WorkListSetTraits<Data*> {
+    typedef PointerHashSet<Data*> SetTy;
+};
+
+/**
+ * FIFO queue of scalars on a power-of-two ring buffer, which grows when it
+ * is full and, unlike std::deque, does not allocate and free blocks as it moves.
+ */
+template<class Data>
+class RingQueue {
+public:
+    RingQueue(): head(0), num(0) {}
+
+    inline bool empty() const {
+        return num == 0;
+    }
+    inline size_t size() const {
+        return num;
+    }
+    inline void push_back(const Data& data) {
+        if (num == buf.size())
+            grow();
+        buf[(head + num) & (buf.size() - 1)] = data;
+        num++;
+    }
+    inline const Data& front() const {
+        return buf[head];
+    }
+    inline void pop_front() {
+        head = (head + 1) & (buf.size() - 1);
+        num--;
+    }
+    inline void clear() {
+        head = 0;
+        num = 0;
+    }
+
+private:
+    void grow() {
+        std::vector<Data> newBuf(buf.empty() ? 64 : buf.size() * 2);
+        for (size_t i = 0; i < num; ++i)
+            newBuf[i] = buf[(head + i) & (buf.size() - 1)];
+        buf.swap(newBuf);
+        head = 0;
+    }
+
+    std::vector<Data> buf;
+    size_t head;
+    size_t num;
+};
 
 /**
  * Worlist with "first come first go" order.
  * New nodes pushed at back and popped from front.
- * Elements in the list are unique as they're recorded by std::set.
+ * Elements in the list are unique as they're recorded by the membership set.
  */
-template<class Data>
+template<class Data, class DataSet = typename WorkListSetTraits<Data>::SetTy>
 class List {
     class ListNode {
     public:
@@ -62,7 +274,6 @@ class List {
         ListNode* next;
     };
 
-    typedef std::set<Data> DataSet;
     typedef ListNode Node;
 
 public:
@@ -78,11 +289,11 @@ public:
     }
 
     inline bool find(Data data) const {
-        return (nodeSet.find(data) == nodeSet.end() ? false : true);
+        return nodeSet.find(data);
     }
 
     void push(Data data) {
-        if (nodeSet.find(data) == nodeSet.end()) {
+        if (nodeSet.insert(data)) {
             Node* new_node = new Node(data);
             if (head == NULL)
                 head = new_node;// the list is empty
@@ -117,12 +328,13 @@ private:
 /**
  * Worlist with "first in first out" order.
  * New nodes will be pushed at back and popped from front.
- * Elements in the list are unique as they're recorded by std::set.
+ * Elements in the list are unique as they're recorded by the membership set.
  */
-template<class Data>
+template<class Data, class DataSet = typename WorkListSetTraits<Data>::SetTy>
 class FIFOWorkList {
-    typedef std::set<Data> DataSet;
-    typedef std::deque<Data> DataDeque;
+    /// ring buffer for IDs and pointers, std::deque for items that are not default-constructible
+    typedef typename std::conditional<std::is_scalar<Data>::value,
+            RingQueue<Data>, std::deque<Data> >::type DataQueue;
 public:
     FIFOWorkList() {}
 
@@ -133,16 +345,15 @@ public:
     }
 
     inline bool find(Data data) const {
-        return (data_set.find(data) == data_set.end() ? false : true);
+        return data_set.find(data);
     }
 
     /**
      * Push a data into the work list.
      */
     inline bool push(Data data) {
-        if (data_set.find(data) == data_set.end()) {
+        if (data_set.insert(data)) {
             data_list.push_back(data);
-            data_set.insert(data);
             return true;
         }
         else
@@ -150,7 +361,7 @@ public:
     }
 
     /**
-     * Pop a data from the END of work list.
+     * Pop a data from the FRONT of work list.
      */
     inline Data pop() {
         assert(!empty() && "work list is empty");
@@ -170,17 +381,16 @@ public:
 
 private:
     DataSet data_set;	///< store all data in the work list.
-    DataDeque data_list;	///< work list using std::vector.
+    DataQueue data_list;	///< work list using a ring buffer or std::deque.
 };
 
 /**
  * Worlist with "first in last out" order.
  * New nodes will be pushed at back and popped from back.
- * Elements in the list are unique as they're recorded by std::set.
+ * Elements in the list are unique as they're recorded by the membership set.
  */
-template<class Data>
+template<class Data, class DataSet = typename WorkListSetTraits<Data>::SetTy>
 class FILOWorkList {
-    typedef std::set<Data> DataSet;
     typedef std::vector<Data> DataVector;
 public:
     FILOWorkList() {}
@@ -192,16 +402,15 @@ public:
     }
 
     inline bool find(Data data) const {
-        return (data_set.find(data) == data_set.end() ? false : true);
+        return data_set.find(data);
     }
 
     /**
      * Push a data into the work list.
      */
     inline bool push(Data data) {
-        if (data_set.find(data) == data_set.end()) {
+        if (data_set.insert(data)) {
             data_list.push_back(data);
-            data_set.insert(data);
             return true;
         }
         else
@@ -36,6 +36,8 @@
 #include "MemoryModel/ConsG.h"
 #include <llvm/PassAnalysisSupport.h>	// analysis usage
 #include <llvm/Support/Debug.h>		// DEBUG TYPE
+#include <deque>
+#include <future>
 
 class PTAType;
 /*!
@@ -70,11 +72,16 @@ public:
     static double timeOfProcessCopyGep;
     static double timeOfProcessLoadStore;
     static double timeOfUpdateCallGraph;
+    static Size_t numOfOfflineMergedNodes;
+    static Size_t numOfOfflineRemovedEdges;
+    static Size_t numOfHCDMerges;
+    static Size_t numOfIndCallPtrUpdates;
+    static double timeOfOfflineReduction;
     //@}
 
     /// Constructor
     Andersen(PTATY type = Andersen_WPA)
-        :  BVDataPTAImpl(type), consCG(NULL)
+        :  BVDataPTAImpl(type), consCG(NULL), readFromCache(false)
     {
         reanalyze = false;
     }
@@ -91,6 +98,11 @@ public:
     /// Andersen analysis
     void analyze(llvm::Module& module);
 
+    /// Whether the results were loaded from the -ander-cache file instead of solved
+    inline bool isReadFromCache() const {
+        return readFromCache;
+    }
+
     /// Initialize analysis
     virtual inline void initialize(llvm::Module& module) {
         resetData();
@@ -167,6 +179,12 @@ protected:
     //@{
     void processAllAddr();
 
+    /// Offline reduction of the constraint graph (see OfflineConsG)
+    void reduceConstraintGraph();
+
+    /// Merge the objects pointed to by a node into its offline cycle (hybrid cycle detection)
+    void mergeHCDCycle(NodeID nodeId);
+
     virtual bool processLoad(NodeID node, const ConstraintEdge* load);
 
     virtual bool processStore(NodeID node, const ConstraintEdge* load);
@@ -178,6 +196,8 @@ protected:
     virtual void processGep(NodeID node, const GepCGEdge* edge);
 
     virtual void processGepPts(PointsTo& pts, const GepCGEdge* edge);
+
+    void computeGepPts(PointsTo& pts, const GepCGEdge* edge, PointsTo& tmpDstPts);
     //@}
 
     /// Add copy edge on constraint graph
@@ -188,6 +208,9 @@ protected:
     /// Update call graph for the input indirect callsites
     virtual bool updateCallGraph(const CallSiteToFunPtrMap& callsites);
 
+    /// Resolve only the callsites whose function (or vtable) pointer gained objects since the last round
+    virtual void onTheFlyCallGraphSolve(const CallSiteToFunPtrMap& callsites, CallEdgeMap& newEdges,llvm::CallGraph* callgraph = NULL);
+
     /// Merge sub node to its rep
     virtual void mergeNodeToRep(NodeID nodeId,NodeID newRepId);
 
@@ -211,6 +234,21 @@ protected:
     /// Constraint Graph
     ConstraintGraph* consCG;
 
+    /// Pointers whose pointed-to objects are in a cycle with a node, found offline
+    ConstraintGraph::NodeToRepMap hcdTargets;
+
+    /// Results loaded from the binary cache
+    bool readFromCache;
+
+    /// Pointers of the indirect callsites, with the points-to set they were last resolved with
+    //@{
+    typedef llvm::DenseMap<NodeID, PointsTo> NodeToPTSMap;
+    typedef llvm::DenseMap<NodeID, std::vector<llvm::CallSite> > NodeToCallSitesMap;
+    NodeToPTSMap resolvedFunPtrPts;	/// non-virtual callsites, by their function pointer
+    NodeToPTSMap resolvedVtblPts;	/// virtual callsites, by their vtable pointer
+    NodeToCallSitesMap vtblToCallSites;
+    //@}
+
     /// Sanitize pts for field insensitive objects
     void sanitizePts() {
         for(ConstraintGraph::iterator it = consCG->begin(), eit = consCG->end(); it!=eit; ++it) {
@@ -287,6 +325,24 @@ private:
 
     static AndersenWaveDiff* diffWave; // static instance
 
+    /// A copy/gep union of the parallel propagation (see -ander-threads), run by the shard of its destination.
+    /// The unions of a shard run in the serial order, so their results are the serial ones.
+    struct PtsUnion {
+        NodeID dst;
+        PointsTo* dstPts;
+        const PointsTo* srcPts;
+        PointsTo gepPts;	///< points-to computed for a gep edge, srcPts points to it
+        bool changed;
+    };
+    typedef std::deque<PtsUnion> PtsUnionQueue;
+    typedef std::vector<PtsUnion*> PtsUnionBatch;
+
+    u32_t shardNum;									///< 0 for the serial propagation
+    PtsUnionQueue unions;							///< unions since the last flush in the serial order
+    std::vector<PtsUnionBatch> batches;				///< unions not submitted yet, per shard
+    std::vector<std::shared_future<void> > shardJobs;	///< last submitted job of each shard
+    std::vector<NodeBS> pendingDsts;				///< destinations of the unions not waited for, per shard
+
     PointsTo & getCachePts(const ConstraintEdge* edge) {
         EdgeID edgeId = edge->getEdgeID();
         return getDiffPTDataTy()->getCachePts(edgeId);
@@ -318,7 +374,7 @@ private:
     //@}
 
 public:
-    AndersenWaveDiff(PTATY type = AndersenWaveDiff_WPA): AndersenWave(type) {}
+    AndersenWaveDiff(PTATY type = AndersenWaveDiff_WPA);
 
     /// Create an singleton instance directly instead of invoking llvm pass manager
     static AndersenWaveDiff* createAndersenWaveDiff(llvm::Module& module) {
@@ -345,8 +401,29 @@ public:
     virtual bool updateCallGraph(const CallSiteToFunPtrMap& callsites);
 
 protected:
+    /// Flush the parallel unions before the load/store edges are processed
+    virtual void solve();
+
+    virtual void processNode(NodeID nodeId);
+
     virtual void mergeNodeToRep(NodeID nodeId,NodeID newRepId);
 
+    /// Parallel propagation of the copy/gep edges
+    //@{
+    inline bool isParallel() const {
+        return shardNum > 0;
+    }
+    /// Run the union into dst on its shard, the source points-to must not change until the next flush
+    PtsUnion& addUnion(NodeID dst, const PointsTo* srcPts);
+    void scheduleUnion(PtsUnion& u);
+    void submitShard(u32_t shard);
+    void waitShard(u32_t shard);
+    /// Wait for the unions into the points-to of id
+    void waitForPts(NodeID id);
+    /// Wait for all the unions, then update the reverse points-to and the worklist in the serial order
+    void flushUnions();
+    //@}
+
     virtual inline bool addCopyEdge(NodeID src, NodeID dst) {
         if (Andersen::addCopyEdge(src, dst)) {
             if (unionPts(sccRepNode(dst), sccRepNode(src)))
@@ -0,0 +1,149 @@
+//===- OfflineConsG.h -- Offline reduction of the constraint graph------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * OfflineConsG.h
+ *
+ * Offline analysis of the constraint graph before Andersen's solving (see -ander-hvn).
+ *
+ * The offline graph has a node for every constraint node and a ref node *p for
+ * every pointer p dereferenced by a load or a store. Its edges are the copy and
+ * gep edges, *p -> q for a load q = *p and q -> *p for a store *p = q.
+ *
+ * Its SCCs are found first: the nodes of an SCC are in a cycle whatever the
+ * points-to sets are, and an SCC through a ref node *p gives the hybrid cycle
+ * detection pair p -> SCC, i.e., every object pointed to by p joins the cycle.
+ *
+ * Then the SCCs are labeled in the topological order (hash-based value numbering):
+ *  - an SCC with an indirect node (an object, a ref node, a node receiving edges
+ *    from the on-the-fly call graph) or with a gep edge inside gets a fresh label;
+ *  - otherwise its label is given by the set of labels flowing into it, the label
+ *    of each object whose address it takes, the labels of its copy predecessors
+ *    and, for a gep predecessor, a label per (predecessor label, offset).
+ * Nodes with the same label are pointer-equivalent and can be merged. A node
+ * labeled 0 has nothing flowing into it and is left alone.
+ */
+
+#ifndef OFFLINECONSG_H_
+#define OFFLINECONSG_H_
+
+#include "MemoryModel/ConsG.h"
+#include <map>
+#include <vector>
+
+class OfflineConsG {
+
+public:
+    typedef std::vector<NodeID> NodeVec;
+    typedef std::vector<NodeVec> NodeGroups;
+    typedef ConstraintGraph::NodeToRepMap NodeToRepMap;
+
+    /// Constructor
+    OfflineConsG(ConstraintGraph* g, PAG* p) : consCG(g), pag(p), nodeNum(0), labelNum(0) {
+    }
+
+    /// Build the offline graph, find its SCCs and label them
+    void compute();
+
+    /// Groups of constraint nodes to be merged, sorted by IDs, the first node of a group is its rep
+    inline const NodeGroups& getMergeGroups() const {
+        return mergeGroups;
+    }
+
+    /// Pointers whose pointed-to objects are in a cycle with a node (hybrid cycle detection)
+    inline const NodeToRepMap& getHCDTargets() const {
+        return hcdTargets;
+    }
+
+    /// Statistics
+    //@{
+    inline u32_t getSCCNum() const {
+        return sccs.size();
+    }
+    inline u32_t getLabelNum() const {
+        return labelNum;
+    }
+    //@}
+
+private:
+    /// An offline edge, gep is NULL for copy, load and store edges
+    struct OffEdge {
+        u32_t dst;
+        const GepCGEdge* gep;
+        OffEdge(u32_t d, const GepCGEdge* g) : dst(d), gep(g) {
+        }
+    };
+    typedef std::vector<OffEdge> OffEdgeVec;
+    typedef std::vector<u32_t> LabelVec;
+
+    ConstraintGraph* consCG;
+    PAG* pag;
+    u32_t nodeNum;					///< the ref node of p is indexed nodeNum + p
+    u32_t labelNum;					///< labels handed out, 0 excluded
+
+    std::vector<OffEdgeVec> succs;	///< offline edges indexed by their sources
+    std::vector<bool> present;		///< offline nodes in the graph
+    std::vector<bool> indirect;		///< offline nodes getting a fresh label
+
+    std::vector<u32_t> sccOf;		///< SCC of every offline node
+    std::vector<LabelVec> sccs;		///< offline nodes of the SCCs, in reverse topological order
+    LabelVec labels;				///< label of every offline node
+
+    llvm::DenseMap<NodeID, u32_t> addrLabels;				///< label of &o for an object o
+    std::map<LabelVec, u32_t> setLabels;					///< label of a set of incoming labels
+    std::map<std::pair<u32_t, LocationSet>, u32_t> gepLabels;	///< label of a normal gep of a label
+    llvm::DenseMap<u32_t, u32_t> variantGepLabels;			///< label of a variant gep of a label
+
+    NodeGroups mergeGroups;
+    NodeToRepMap hcdTargets;
+
+    inline u32_t refNode(NodeID id) const {
+        return nodeNum + id;
+    }
+    inline bool isRefNode(u32_t n) const {
+        return n >= nodeNum;
+    }
+    inline u32_t newLabel() {
+        return ++labelNum;
+    }
+
+    /// Build the offline graph and mark the indirect nodes
+    void buildGraph();
+    void markIndirectNodes();
+
+    /// Tarjan's SCC detection over the offline graph
+    void findSCCs();
+
+    /// Whether a gep edge is inside an SCC, the SCC is then a positive weight cycle
+    bool hasGepInside(u32_t scc) const;
+
+    /// Label the SCCs in the topological order
+    void labelSCCs();
+
+    /// Label flowing into the destination of a gep edge from a source labeled srcLabel
+    u32_t getGepLabel(u32_t srcLabel, const GepCGEdge* gep);
+
+    /// Collect the merge groups and the hybrid cycle detection pairs
+    void collectResults();
+};
+
+#endif /* OFFLINECONSG_H_ */
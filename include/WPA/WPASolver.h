@@ -31,8 +31,188 @@
 #ifndef GRAPHSOLVER_H_
 #define GRAPHSOLVER_H_
 
+#include "Util/BasicTypes.h"
 #include "Util/WorkList.h"
 #include <llvm/ADT/GraphTraits.h>
+#include <llvm/Support/CommandLine.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+/*!
+ * Worklist of the solvers with a pluggable order
+ *   FIFO       first in first out (default)
+ *   LIFO       last in first out
+ *   LRF        least recently fired node first, a node fires when it is processed
+ *   TOPO       lowest topological rank first, the ranks are re-sorted after each SCC detection
+ *   TWOPHASE   nodes pushed during a phase wait for the next phase, each phase in topological order
+ */
+class WPAWorkList {
+public:
+    enum Policy {
+        FIFO_WL,
+        LIFO_WL,
+        LRF_WL,
+        TOPO_WL,
+        TWOPHASE_WL
+    };
+
+    /// Values of the command line options choosing a policy (-ander-wl, -fs-wl)
+    static inline llvm::cl::ValuesClass<int> getPolicyValues() {
+        return llvm::cl::values(
+                   clEnumValN(FIFO_WL, "fifo", "First in first out"),
+                   clEnumValN(LIFO_WL, "lifo", "Last in first out"),
+                   clEnumValN(LRF_WL, "lrf", "Least recently fired node first"),
+                   clEnumValN(TOPO_WL, "topo", "Topological order, re-sorted after each SCC detection"),
+                   clEnumValN(TWOPHASE_WL, "2phase", "Phases in topological order, nodes pushed during a phase wait for the next one"),
+                   clEnumValEnd);
+    }
+
+    WPAWorkList(): policy(FIFO_WL), clock(0) {}
+
+    inline Policy getPolicy() const {
+        return policy;
+    }
+    /// Set the order, the nodes already in the worklist are kept
+    inline void setPolicy(Policy p) {
+        std::vector<NodeID> ids;
+        while (!empty())
+            ids.push_back(pop());
+        policy = p;
+        for (std::vector<NodeID>::const_iterator it = ids.begin(), eit = ids.end(); it != eit; ++it)
+            push(*it);
+    }
+    /// Whether the policy uses the topological ranks of setRanks()
+    inline bool isRanked() const {
+        return policy == TOPO_WL || policy == TWOPHASE_WL;
+    }
+
+    inline bool empty() const {
+        switch (policy) {
+        case FIFO_WL:
+            return fifo.empty();
+        case LIFO_WL:
+            return lifo.empty();
+        default:
+            return heap.empty() && nextPhase.empty();
+        }
+    }
+
+    inline bool find(NodeID id) const {
+        switch (policy) {
+        case FIFO_WL:
+            return fifo.find(id);
+        case LIFO_WL:
+            return lifo.find(id);
+        default:
+            return inList.find(id);
+        }
+    }
+
+    inline bool push(NodeID id) {
+        switch (policy) {
+        case FIFO_WL:
+            return fifo.push(id);
+        case LIFO_WL:
+            return lifo.push(id);
+        default:
+            if (!inList.insert(id))
+                return false;
+            if (policy == TWOPHASE_WL)
+                nextPhase.push_back(id);
+            else
+                pushHeap(id);
+            return true;
+        }
+    }
+
+    /// Pop the next node, which fires it
+    inline NodeID pop() {
+        assert(!empty() && "work list is empty");
+        NodeID id;
+        switch (policy) {
+        case FIFO_WL:
+            id = fifo.pop();
+            break;
+        case LIFO_WL:
+            id = lifo.pop();
+            break;
+        default:
+            /// start the next phase
+            if (heap.empty()) {
+                for (std::vector<NodeID>::const_iterator it = nextPhase.begin(), eit = nextPhase.end(); it != eit; ++it)
+                    pushHeap(*it);
+                nextPhase.clear();
+            }
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Item>());
+            id = heap.back().second;
+            heap.pop_back();
+            inList.erase(id);
+            break;
+        }
+        fired(id);
+        return id;
+    }
+
+    inline void clear() {
+        fifo.clear();
+        lifo.clear();
+        heap.clear();
+        nextPhase.clear();
+        inList.clear();
+    }
+
+    /// Record that a node was processed, for LRF
+    inline void fired(NodeID id) {
+        if (policy != LRF_WL)
+            return;
+        if (id >= lastFired.size())
+            lastFired.resize(std::max<size_t>(id + 1, lastFired.size() * 2), 0);
+        lastFired[id] = ++clock;
+    }
+
+    /// Rank the nodes by their order in topoStack (top first) and re-sort the worklist
+    inline void setRanks(const NodeStack& topoStack) {
+        if (!isRanked())
+            return;
+        std::fill(ranks.begin(), ranks.end(), std::numeric_limits<u32_t>::max());
+        NodeStack stack(topoStack);
+        for (u32_t rank = 0; !stack.empty(); ++rank) {
+            NodeID id = stack.top();
+            stack.pop();
+            if (id >= ranks.size())
+                ranks.resize(std::max<size_t>(id + 1, ranks.size() * 2), std::numeric_limits<u32_t>::max());
+            ranks[id] = rank;
+        }
+        for (std::vector<Item>::iterator it = heap.begin(), eit = heap.end(); it != eit; ++it)
+            it->first = priority(it->second);
+        std::make_heap(heap.begin(), heap.end(), std::greater<Item>());
+    }
+
+private:
+    typedef std::pair<u64_t, NodeID> Item;	///< (priority, node), the lowest first
+
+    inline u64_t priority(NodeID id) const {
+        if (policy == LRF_WL)
+            return id < lastFired.size() ? lastFired[id] : 0;
+        /// nodes created after the ranking go last
+        return id < ranks.size() ? ranks[id] : std::numeric_limits<u32_t>::max();
+    }
+    inline void pushHeap(NodeID id) {
+        heap.push_back(std::make_pair(priority(id), id));
+        std::push_heap(heap.begin(), heap.end(), std::greater<Item>());
+    }
+
+    Policy policy;
+    FIFOWorkList<NodeID> fifo;
+    FILOWorkList<NodeID> lifo;
+    std::vector<Item> heap;	///< LRF, TOPO and the current phase of TWOPHASE
+    std::vector<NodeID> nextPhase;	///< nodes of the next phase of TWOPHASE
+    DenseIDSet<NodeID> inList;	///< nodes in heap or nextPhase
+    std::vector<u64_t> lastFired;
+    std::vector<u32_t> ranks;
+    u64_t clock;
+};
 
 /*
  * Generic graph solver for whole program pointer analysis
@@ -49,12 +229,40 @@ public:
 
     typedef SCCDetection<GraphType> SCC;
 
-    typedef FIFOWorkList<NodeID> WorkList;
+    typedef WPAWorkList WorkList;
+
+    /// Order of the worklist and number of processed nodes
+    //@{
+    inline void setWorkListPolicy(WorkList::Policy policy) {
+        worklist.setPolicy(policy);
+    }
+    inline WorkList::Policy getWorkListPolicy() const {
+        return worklist.getPolicy();
+    }
+    inline Size_t getNumOfProcessedNodes() const {
+        return numOfProcessedNodes;
+    }
+    /// Statistic name of the processed nodes, with the policy
+    inline const char* getProcessedNodesStatName() const {
+        switch (worklist.getPolicy()) {
+        case WorkList::LIFO_WL:
+            return "ProcessedNodes(lifo)";
+        case WorkList::LRF_WL:
+            return "ProcessedNodes(lrf)";
+        case WorkList::TOPO_WL:
+            return "ProcessedNodes(topo)";
+        case WorkList::TWOPHASE_WL:
+            return "ProcessedNodes(2phase)";
+        default:
+            return "ProcessedNodes(fifo)";
+        }
+    }
+    //@}
 
 protected:
 
     /// Constructor
-    WPASolver(): _graph(NULL),scc(NULL)
+    WPASolver(): _graph(NULL),scc(NULL),numOfProcessedNodes(0)
     {
     }
     /// Destructor
@@ -92,12 +300,14 @@ protected:
         /// Nodes in nodeStack are in topological order by default.
         /// This order can be changed by overwritten SCCDetect() in sub-classes
         NodeStack& nodeStack = SCCDetect();
+        rankWorklist(nodeStack);
 
         /// initial worklist
         /// process nodes in nodeStack.
         while (!nodeStack.empty()) {
             NodeID nodeId = nodeStack.top();
             nodeStack.pop();
+            fireNode(nodeId);
             processNode(nodeId);
         }
 
@@ -142,8 +352,18 @@ protected:
     /// Worklist operations
     //@{
     inline NodeID popFromWorklist() {
+        numOfProcessedNodes++;
         return sccRepNode(worklist.pop());
     }
+    /// A node processed outside the worklist, e.g. in the topological pass
+    inline void fireNode(NodeID id) {
+        numOfProcessedNodes++;
+        worklist.fired(id);
+    }
+    /// Re-sort the worklist by a new topological order, for the ranked policies
+    inline void rankWorklist(const NodeStack& topoStack) {
+        worklist.setRanks(topoStack);
+    }
     inline void pushIntoWorklist(NodeID id) {
         worklist.push(sccRepNode(id));
     }
@@ -175,6 +395,9 @@ private:
 
     /// Worklist for resolution
     WorkList worklist;
+
+    /// Nodes popped from the worklist or processed in the topological pass
+    Size_t numOfProcessedNodes;
 };
 
 #endif /* GRAPHSOLVER_H_ */
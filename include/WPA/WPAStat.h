@@ -49,8 +49,18 @@ private:
 
 public:
     static const char* CollapseTime;
+    static const char* OfflineReductionTime;
 
     static const char* NumberOfCGNode;
+    static const char* NumOfOfflineMergedNodes;
+    static const char* NumOfOfflineRemovedEdges;
+    static const char* NumOfHCDMerges;
+    static const char* NumOfIndCallPtrUpdates;
+    static const char* NumOfSharedPtsSets;
+    static const char* NumOfSharedPtsTargets;
+    static const char* NumOfUnsharedPtsTargets;
+    static const char* NumOfUnionCacheLookups;
+    static const char* UnionCacheHitRate;
 
     static u32_t _MaxPtsSize;
     static u32_t _NumOfCycles;
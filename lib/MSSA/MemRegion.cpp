@@ -38,7 +38,7 @@ using namespace llvm;
 using namespace analysisUtil;
 
 Size_t MemRegion::totalMRNum = 0;
-Size_t MRVer::totalVERNum = 0;
+std::atomic<Size_t> MRVer::totalVERNum(0);
 
 static cl::opt<bool> IgnoreDeadFun("mssa-ignoreDeadFun", cl::init(false),
                                    cl::desc("Don't construct memory SSA for deadfunction"));
@@ -39,6 +39,8 @@
 #include <llvm/Support/raw_ostream.h>	// for output
 #include <llvm/Support/CommandLine.h>
 
+#include <mutex>
+
 using namespace llvm;
 using namespace analysisUtil;
 
@@ -60,10 +62,13 @@ double MemSSA::timeOfCreateMUCHI  = 0;	///< Time for generating mu/chi for load/
 double MemSSA::timeOfInsertingPHI  = 0;	///< Time for inserting phis
 double MemSSA::timeOfSSARenaming  = 0;	///< Time for SSA rename
 
+/// Guards the times above, which the workers of a parallel build add to
+static std::mutex timeMutex;
+
 /*!
  * Constructor
  */
-MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
+MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL),isWorker(false) {
     pta = p;
     assert((pta->getAnalysisTy()!=PointerAnalysis::Default_PTA)
            && "please specify a pointer analysis");
@@ -92,6 +97,17 @@ MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
     timeOfGeneratingMemRegions += (mrEnd - mrStart)/TIMEINTERVAL;
 }
 
+/*!
+ * Constructor of a worker, the memory regions are generated by its owner.
+ * A worker only reads the shared memory regions, its mus/chis/phis, version
+ * counters and stacks are its own until they are merged to the owner.
+ */
+MemSSA::MemSSA(MemSSA* owner) : df(NULL),dt(NULL),isWorker(true) {
+    pta = owner->pta;
+    mrGen = owner->mrGen;
+    stat = owner->stat;
+}
+
 /*!
  * Set DF/DT
  */
@@ -118,20 +134,51 @@ void MemSSA::buildMemSSA(const Function& fun, DominanceFrontier* f, DominatorTre
     double muchiStart = stat->getClk();
     createMUCHI(fun);
     double muchiEnd = stat->getClk();
-    timeOfCreateMUCHI += (muchiEnd - muchiStart)/TIMEINTERVAL;
 
     /// Insert PHI for memory regions
     double phiStart = stat->getClk();
     insertPHI(fun);
     double phiEnd = stat->getClk();
-    timeOfInsertingPHI += (phiEnd - phiStart)/TIMEINTERVAL;
 
     /// SSA rename for memory regions
     double renameStart = stat->getClk();
     SSARename(fun);
     double renameEnd = stat->getClk();
+
+    std::lock_guard<std::mutex> lock(timeMutex);
+    timeOfCreateMUCHI += (muchiEnd - muchiStart)/TIMEINTERVAL;
+    timeOfInsertingPHI += (phiEnd - phiStart)/TIMEINTERVAL;
     timeOfSSARenaming += (renameEnd - renameStart)/TIMEINTERVAL;
+}
 
+/*!
+ * Move the entries of a map of a worker to the same map of this memory SSA.
+ * The keys (loads, stores, callsites, basic blocks and functions) belong to one
+ * function, which is built by one worker, so that the maps are disjoint.
+ */
+template<class Map>
+static void mergeMap(Map& to, Map& from) {
+    for (typename Map::iterator it = from.begin(), eit = from.end(); it != eit; ++it) {
+        assert(to.find(it->first) == to.end() && "function built by two workers?");
+        to[it->first].swap(it->second);
+    }
+    from.clear();
+}
+
+/*!
+ * Merge a worker, the workers are merged in the order of their functions
+ * so that the maps are filled up in the order of a serial build
+ */
+void MemSSA::merge(MemSSA& worker) {
+    assert(worker.isWorker && worker.mrGen == mrGen && "not a worker of this memory SSA");
+
+    mergeMap(load2MuSetMap, worker.load2MuSetMap);
+    mergeMap(store2ChiSetMap, worker.store2ChiSetMap);
+    mergeMap(callsiteToMuSetMap, worker.callsiteToMuSetMap);
+    mergeMap(callsiteToChiSetMap, worker.callsiteToChiSetMap);
+    mergeMap(bb2PhiSetMap, worker.bb2PhiSetMap);
+    mergeMap(funToEntryChiSetMap, worker.funToEntryChiSetMap);
+    mergeMap(funToReturnMuSetMap, worker.funToReturnMuSetMap);
 }
 
 /*!
@@ -174,10 +221,15 @@ void MemSSA::createMUCHI(const Function& fun) {
                 for (PAGEdgeList::const_iterator bit = pagEdgeList.begin(),
                         ebit = pagEdgeList.end(); bit != ebit; ++bit) {
                     const PAGEdge* inst = *bit;
-                    if (const LoadPE* load = dyn_cast<LoadPE>(inst))
-                        AddLoadMU(bb, load, mrGen->getLoadMRSet(load));
-                    else if (const StorePE* store = dyn_cast<StorePE>(inst))
-                        AddStoreCHI(bb, store, mrGen->getStoreMRSet(store));
+                    /// the region maps are shared by the parallel workers, look them up without inserting
+                    if (const LoadPE* load = dyn_cast<LoadPE>(inst)) {
+                        if (mrGen->hasLoadMRSet(load))
+                            AddLoadMU(bb, load, mrGen->getLoadMRSet(load));
+                    }
+                    else if (const StorePE* store = dyn_cast<StorePE>(inst)) {
+                        if (mrGen->hasStoreMRSet(store))
+                            AddStoreCHI(bb, store, mrGen->getStoreMRSet(store));
+                    }
                 }
             }
             if (isCallSite(inst) && isInstrinsicDbgInst(inst)==false) {
@@ -440,9 +492,12 @@ void MemSSA::destroy() {
         }
     }
 
-    delete mrGen;
+    /// the memory regions and statistics of a worker are its owner's
+    if (!isWorker) {
+        delete mrGen;
+        delete stat;
+    }
     mrGen = NULL;
-    delete stat;
     stat = NULL;
     pta = NULL;
 }
@@ -43,7 +43,7 @@ static cl::opt<bool> DumpVFG("dump-svfg", cl::init(false),
 /*!
  * Constructor
  */
-SVFG::SVFG(SVFGK k): totalSVFGNode(0), kind(k),mssa(NULL),pta(NULL) {
+SVFG::SVFG(SVFGK k): totalSVFGNode(0), kind(k),mssa(NULL),pta(NULL),csr(NULL) {
     stat = new SVFGStat(this);
 }
 
@@ -53,10 +53,38 @@ SVFG::SVFG(SVFGK k): totalSVFGNode(0), kind(k),mssa(NULL),pta(NULL) {
 void SVFG::destroy() {
     delete stat;
     stat = NULL;
+    thaw();
     mssa = NULL;
     pta = NULL;
 }
 
+/*!
+ * Call site ID of a call/ret edge, 0 for the other edges
+ */
+static CallSiteID getEdgeCallSiteID(const SVFGEdge* edge) {
+    if (const CallDirSVFGEdge* callEdge = dyn_cast<CallDirSVFGEdge>(edge))
+        return callEdge->getCallSiteId();
+    else if (const RetDirSVFGEdge* retEdge = dyn_cast<RetDirSVFGEdge>(edge))
+        return retEdge->getCallSiteId();
+    else if (const CallIndSVFGEdge* callEdge = dyn_cast<CallIndSVFGEdge>(edge))
+        return callEdge->getCallSiteId();
+    else if (const RetIndSVFGEdge* retEdge = dyn_cast<RetIndSVFGEdge>(edge))
+        return retEdge->getCallSiteId();
+    return 0;
+}
+
+/*!
+ * Build the CSR layout of the edges once the SVFG is complete.
+ * Clients traversing it many times (e.g. the saber checkers) read the records
+ * instead of the edge sets and take the call site of an edge without casting it.
+ */
+void SVFG::freeze() {
+    thaw();
+    csr = new SVFGCSR(this, getEdgeCallSiteID);
+    DBOUT(DGENERAL, outs() << pasMsg("\tFreeze SVFG: ") << csr->getEdgeNum() << " edges, "
+          << csr->getMemUsage() << " bytes\n");
+}
+
 /*!
  * Build SVFG
  * 1) build SVFG nodes
@@ -540,7 +568,7 @@ SVFGEdge* SVFG::addIntraDirectVFEdge(NodeID srcId, NodeID dstId) {
         return NULL;
     }
     else {
-        IntraDirSVFGEdge* directEdge = new IntraDirSVFGEdge(srcNode,dstNode);
+        IntraDirSVFGEdge* directEdge = new (getArena()) IntraDirSVFGEdge(srcNode,dstNode);
         return (addSVFGEdge(directEdge) ? directEdge : NULL);
     }
 }
@@ -556,7 +584,7 @@ SVFGEdge* SVFG::addCallDirectVFEdge(NodeID srcId, NodeID dstId, CallSiteID csId)
         return NULL;
     }
     else {
-        CallDirSVFGEdge* callEdge = new CallDirSVFGEdge(srcNode,dstNode,csId);
+        CallDirSVFGEdge* callEdge = new (getArena()) CallDirSVFGEdge(srcNode,dstNode,csId);
         return (addSVFGEdge(callEdge) ? callEdge : NULL);
     }
 }
@@ -572,7 +600,7 @@ SVFGEdge* SVFG::addRetDirectVFEdge(NodeID srcId, NodeID dstId, CallSiteID csId)
         return NULL;
     }
     else {
-        RetDirSVFGEdge* retEdge = new RetDirSVFGEdge(srcNode,dstNode,csId);
+        RetDirSVFGEdge* retEdge = new (getArena()) RetDirSVFGEdge(srcNode,dstNode,csId);
         return (addSVFGEdge(retEdge) ? retEdge : NULL);
     }
 }
@@ -589,7 +617,7 @@ SVFGEdge* SVFG::addIntraIndirectVFEdge(NodeID srcId, NodeID dstId, const PointsT
         return (cast<IndirectSVFGEdge>(edge)->addPointsTo(cpts) ? edge : NULL);
     }
     else {
-        IntraIndSVFGEdge* indirectEdge = new IntraIndSVFGEdge(srcNode,dstNode);
+        IntraIndSVFGEdge* indirectEdge = new (getArena()) IntraIndSVFGEdge(srcNode,dstNode);
         indirectEdge->addPointsTo(cpts);
         return (addSVFGEdge(indirectEdge) ? indirectEdge : NULL);
     }
@@ -606,7 +634,7 @@ SVFGEdge* SVFG::addThreadMHPIndirectVFEdge(NodeID srcId, NodeID dstId, const Poi
         return (cast<IndirectSVFGEdge>(edge)->addPointsTo(cpts) ? edge : NULL);
     }
     else {
-        ThreadMHPIndSVFGEdge* indirectEdge = new ThreadMHPIndSVFGEdge(srcNode,dstNode);
+        ThreadMHPIndSVFGEdge* indirectEdge = new (getArena()) ThreadMHPIndSVFGEdge(srcNode,dstNode);
         indirectEdge->addPointsTo(cpts);
         return (addSVFGEdge(indirectEdge) ? indirectEdge : NULL);
     }
@@ -624,7 +652,7 @@ SVFGEdge* SVFG::addCallIndirectVFEdge(NodeID srcId, NodeID dstId, const PointsTo
         return (cast<CallIndSVFGEdge>(edge)->addPointsTo(cpts) ? edge : NULL);
     }
     else {
-        CallIndSVFGEdge* callEdge = new CallIndSVFGEdge(srcNode,dstNode,csId);
+        CallIndSVFGEdge* callEdge = new (getArena()) CallIndSVFGEdge(srcNode,dstNode,csId);
         callEdge->addPointsTo(cpts);
         return (addSVFGEdge(callEdge) ? callEdge : NULL);
     }
@@ -642,7 +670,7 @@ SVFGEdge* SVFG::addRetIndirectVFEdge(NodeID srcId, NodeID dstId, const PointsTo&
         return (cast<RetIndSVFGEdge>(edge)->addPointsTo(cpts) ? edge : NULL);
     }
     else {
-        RetIndSVFGEdge* retEdge = new RetIndSVFGEdge(srcNode,dstNode,csId);
+        RetIndSVFGEdge* retEdge = new (getArena()) RetIndSVFGEdge(srcNode,dstNode,csId);
         retEdge->addPointsTo(cpts);
         return (addSVFGEdge(retEdge) ? retEdge : NULL);
     }
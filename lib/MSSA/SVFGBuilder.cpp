@@ -30,9 +30,12 @@
 #include "MSSA/SVFG.h"
 #include "MSSA/SVFGBuilder.h"
 #include "WPA/Andersen.h"
+#include "Util/ThreadPool.h"
 
 #include <llvm/Support/CommandLine.h>
 
+#include <algorithm>
+
 using namespace llvm;
 using namespace analysisUtil;
 
@@ -42,6 +45,9 @@ static cl::opt<bool> SVFGWithIndirectCall("svfgWithIndCall", cl::init(false),
 static cl::opt<bool> SingleVFG("singleVFG", cl::init(false),
                                cl::desc("Create a single VFG shared by multiple analysis"));
 
+static cl::opt<unsigned> MSSAJobs("mssa-jobs", cl::init(1),
+                                  cl::desc("Number of chunks of functions whose memory SSA is built in parallel on the thread pool (see -nworkers)"));
+
 SVFGOPT* SVFGBuilder::globalSvfg = NULL;
 
 /*!
@@ -91,20 +97,24 @@ bool SVFGBuilder::build(SVFG* graph,BVDataPTAImpl* pta) {
 
     DBOUT(DGENERAL, outs() << pasMsg("Build Memory SSA \n"));
 
-    DominatorTree dt;
-    MemSSADF df;
-
+    FunctionList funs;
     for (llvm::Module::iterator iter = pta->getModule()->begin(), eiter = pta->getModule()->end();
             iter != eiter; ++iter) {
-
         llvm::Function& fun = *iter;
-        if (analysisUtil::isExtCall(&fun))
-            continue;
-
-        dt.recalculate(fun);
-        df.runOnDT(dt);
+        if (analysisUtil::isExtCall(&fun) == false)
+            funs.push_back(&fun);
+    }
 
-        mssa.buildMemSSA(fun, &df, &dt);
+    if (MSSAJobs > 1 && funs.size() > 1)
+        buildMemSSAInParallel(mssa, funs);
+    else {
+        DominatorTree dt;
+        MemSSADF df;
+        for (FunctionList::iterator it = funs.begin(), eit = funs.end(); it != eit; ++it) {
+            dt.recalculate(**it);
+            df.runOnDT(dt);
+            mssa.buildMemSSA(**it, &df, &dt);
+        }
     }
 
     mssa.performStat();
@@ -122,6 +132,58 @@ bool SVFGBuilder::build(SVFG* graph,BVDataPTAImpl* pta) {
     return false;
 }
 
+/*!
+ * Build the memory SSA of the functions on the thread pool. The functions are cut
+ * into -mssa-jobs chunks of consecutive functions with about the same number of
+ * basic blocks. A chunk is built by a worker MemSSA (sharing the memory regions
+ * of mssa) with its own dominator tree and dominance frontier, the workers are
+ * then merged in the order of the chunks, i.e. the order of the serial build.
+ */
+void SVFGBuilder::buildMemSSAInParallel(MemSSA& mssa, FunctionList& funs) {
+
+    Size_t bbNum = 0;
+    for (FunctionList::iterator it = funs.begin(), eit = funs.end(); it != eit; ++it)
+        bbNum += (*it)->size();
+
+    u32_t chunkNum = std::min<Size_t>(MSSAJobs, funs.size());
+    Size_t chunkBBNum = std::max<Size_t>(bbNum / chunkNum, 1);
+
+    std::vector<MemSSA*> workers;
+    std::vector<std::future<void> > chunks;
+    Size_t begin = 0;
+    while (begin < funs.size()) {
+        Size_t end = begin;
+        Size_t num = 0;
+        while (end < funs.size() && (end == begin || num < chunkBBNum))
+            num += funs[end++]->size();
+
+        /// the passes are created on this thread, their constructors initialize the pass registry
+        MemSSA* worker = new MemSSA(&mssa);
+        DominatorTree* dt = new DominatorTree();
+        MemSSADF* df = new MemSSADF();
+        workers.push_back(worker);
+        chunks.push_back(ThreadPool::getThreadPool()->enqueue([worker, dt, df, &funs, begin, end]() {
+            for (Size_t i = begin; i < end; ++i) {
+                dt->recalculate(*funs[i]);
+                df->runOnDT(*dt);
+                worker->buildMemSSA(*funs[i], df, dt);
+            }
+            delete df;
+            delete dt;
+        }));
+        begin = end;
+    }
+
+    DBOUT(DGENERAL, outs() << pasMsg("Build Memory SSA of ") << funs.size() << " functions in "
+          << chunks.size() << " chunks\n");
+
+    for (u32_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].get();
+        mssa.merge(*workers[i]);
+        delete workers[i];
+    }
+}
+
 
 
 /// Update call graph using pre-analysis results
@@ -45,7 +45,7 @@ void ConstraintGraph::buildCG() {
 
     // initialize nodes
     for(PAG::iterator it = pag->begin(), eit = pag->end(); it!=eit; ++it) {
-        addConstraintNode(new ConstraintNode(it->first),it->first);
+        addConstraintNode(new (getArena()) ConstraintNode(it->first),it->first);
     }
 
     // initialize edges
@@ -144,7 +144,7 @@ bool ConstraintGraph::addAddrCGEdge(NodeID src, NodeID dst) {
     ConstraintNode* dstNode = getConstraintNode(dst);
     if(hasEdge(srcNode,dstNode,ConstraintEdge::Addr))
         return false;
-    AddrCGEdge* edge = new AddrCGEdge(srcNode, dstNode, edgeIndex++);
+    AddrCGEdge* edge = new (getArena()) AddrCGEdge(srcNode, dstNode, edgeIndex++);
     bool added = AddrCGEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingAddrEdge(edge);
@@ -163,7 +163,7 @@ bool ConstraintGraph::addCopyCGEdge(NodeID src, NodeID dst) {
             || srcNode == dstNode)
         return false;
 
-    CopyCGEdge* edge = new CopyCGEdge(srcNode, dstNode, edgeIndex++);
+    CopyCGEdge* edge = new (getArena()) CopyCGEdge(srcNode, dstNode, edgeIndex++);
     bool added = directEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingCopyEdge(edge);
@@ -181,7 +181,7 @@ bool ConstraintGraph::addNormalGepCGEdge(NodeID src, NodeID dst, const LocationS
     if(hasEdge(srcNode,dstNode,ConstraintEdge::NormalGep))
         return false;
 
-    NormalGepCGEdge* edge = new NormalGepCGEdge(srcNode, dstNode,ls, edgeIndex++);
+    NormalGepCGEdge* edge = new (getArena()) NormalGepCGEdge(srcNode, dstNode,ls, edgeIndex++);
     bool added = directEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingGepEdge(edge);
@@ -198,7 +198,7 @@ bool ConstraintGraph::addVariantGepCGEdge(NodeID src, NodeID dst) {
     if(hasEdge(srcNode,dstNode,ConstraintEdge::VariantGep))
         return false;
 
-    VariantGepCGEdge* edge = new VariantGepCGEdge(srcNode, dstNode, edgeIndex++);
+    VariantGepCGEdge* edge = new (getArena()) VariantGepCGEdge(srcNode, dstNode, edgeIndex++);
     bool added = directEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingGepEdge(edge);
@@ -215,7 +215,7 @@ bool ConstraintGraph::addLoadCGEdge(NodeID src, NodeID dst) {
     if(hasEdge(srcNode,dstNode,ConstraintEdge::Load))
         return false;
 
-    LoadCGEdge* edge = new LoadCGEdge(srcNode, dstNode, edgeIndex++);
+    LoadCGEdge* edge = new (getArena()) LoadCGEdge(srcNode, dstNode, edgeIndex++);
     bool added = LoadCGEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingLoadEdge(edge);
@@ -232,7 +232,7 @@ bool ConstraintGraph::addStoreCGEdge(NodeID src, NodeID dst) {
     if(hasEdge(srcNode,dstNode,ConstraintEdge::Store))
         return false;
 
-    StoreCGEdge* edge = new StoreCGEdge(srcNode, dstNode, edgeIndex++);
+    StoreCGEdge* edge = new (getArena()) StoreCGEdge(srcNode, dstNode, edgeIndex++);
     bool added = StoreCGEdgeSet.insert(edge).second;
     assert(added && "not added??");
     srcNode->addOutgoingStoreEdge(edge);
@@ -58,7 +58,7 @@ bool PAG::addAddrEdge(NodeID src, NodeID dst) {
     if(hasIntraEdge(srcNode,dstNode, PAGEdge::Addr))
         return false;
     else
-        return addEdge(srcNode,dstNode, new AddrPE(srcNode, dstNode));
+        return addEdge(srcNode,dstNode, new (getArena()) AddrPE(srcNode, dstNode));
 }
 
 /*!
@@ -70,7 +70,7 @@ bool PAG::addCopyEdge(NodeID src, NodeID dst) {
     if(hasIntraEdge(srcNode,dstNode, PAGEdge::Copy))
         return false;
     else
-        return addEdge(srcNode,dstNode, new CopyPE(srcNode, dstNode));
+        return addEdge(srcNode,dstNode, new (getArena()) CopyPE(srcNode, dstNode));
 }
 
 /*!
@@ -82,7 +82,7 @@ bool PAG::addLoadEdge(NodeID src, NodeID dst) {
     if(hasIntraEdge(srcNode,dstNode, PAGEdge::Load))
         return false;
     else
-        return addEdge(srcNode,dstNode, new LoadPE(srcNode, dstNode));
+        return addEdge(srcNode,dstNode, new (getArena()) LoadPE(srcNode, dstNode));
 }
 
 /*!
@@ -94,7 +94,7 @@ bool PAG::addStoreEdge(NodeID src, NodeID dst) {
     if(hasIntraEdge(srcNode,dstNode, PAGEdge::Store))
         return false;
     else
-        return addEdge(srcNode,dstNode, new StorePE(srcNode, dstNode));
+        return addEdge(srcNode,dstNode, new (getArena()) StorePE(srcNode, dstNode));
 }
 
 /*!
@@ -106,7 +106,7 @@ bool PAG::addCallEdge(NodeID src, NodeID dst, const llvm::Instruction* cs) {
     if(hasInterEdge(srcNode,dstNode, PAGEdge::Call, cs))
         return false;
     else
-        return addEdge(srcNode,dstNode, new CallPE(srcNode, dstNode, cs));
+        return addEdge(srcNode,dstNode, new (getArena()) CallPE(srcNode, dstNode, cs));
 }
 
 /*!
@@ -118,7 +118,7 @@ bool PAG::addRetEdge(NodeID src, NodeID dst, const llvm::Instruction* cs) {
     if(hasInterEdge(srcNode,dstNode, PAGEdge::Ret, cs))
         return false;
     else
-        return addEdge(srcNode,dstNode, new RetPE(srcNode, dstNode, cs));
+        return addEdge(srcNode,dstNode, new (getArena()) RetPE(srcNode, dstNode, cs));
 }
 
 /*!
@@ -140,7 +140,7 @@ bool PAG::addThreadForkEdge(NodeID src, NodeID dst, const llvm::Instruction* cs)
     if(hasInterEdge(srcNode,dstNode, PAGEdge::ThreadFork, cs))
         return false;
     else
-        return addEdge(srcNode,dstNode, new TDForkPE(srcNode, dstNode, cs));
+        return addEdge(srcNode,dstNode, new (getArena()) TDForkPE(srcNode, dstNode, cs));
 }
 
 /*!
@@ -152,7 +152,7 @@ bool PAG::addThreadJoinEdge(NodeID src, NodeID dst, const llvm::Instruction* cs)
     if(hasInterEdge(srcNode,dstNode, PAGEdge::ThreadJoin, cs))
         return false;
     else
-        return addEdge(srcNode,dstNode, new TDJoinPE(srcNode, dstNode, cs));
+        return addEdge(srcNode,dstNode, new (getArena()) TDJoinPE(srcNode, dstNode, cs));
 }
 
 
@@ -184,7 +184,7 @@ bool PAG::addNormalGepEdge(NodeID src, NodeID dst, const LocationSet& ls) {
     if(hasIntraEdge(baseNode, dstNode, PAGEdge::NormalGep))
         return false;
     else
-        return addEdge(baseNode, dstNode, new NormalGepPE(baseNode, dstNode, ls+baseLS));
+        return addEdge(baseNode, dstNode, new (getArena()) NormalGepPE(baseNode, dstNode, ls+baseLS));
 }
 
 /*!
@@ -202,7 +202,7 @@ bool PAG::addVariantGepEdge(NodeID src, NodeID dst) {
     if(hasIntraEdge(baseNode, dstNode, PAGEdge::VariantGep))
         return false;
     else
-        return addEdge(baseNode, dstNode, new VariantGepPE(baseNode, dstNode));
+        return addEdge(baseNode, dstNode, new (getArena()) VariantGepPE(baseNode, dstNode));
 }
 
 /*!
@@ -266,7 +266,7 @@ NodeID PAG::addGepValNode(const llvm::Value* val, const LocationSet& ls, NodeID
     assert(0==GepValNodeMap.count(std::make_pair(base, ls))
            && "this node should not be created before");
     GepValNodeMap[std::make_pair(base, ls)] = i;
-    GepValPN *node = new GepValPN(val, i, ls, type, fieldidx);
+    GepValPN *node = new (getArena()) GepValPN(val, i, ls, type, fieldidx);
     return addValNode(val, node, i);
 }
 
@@ -318,7 +318,7 @@ NodeID PAG::addGepObjNode(const MemObj* obj, const LocationSet& ls, NodeID i) {
     assert(0==GepObjNodeMap.count(std::make_pair(base, ls))
            && "this node should not be created before");
     GepObjNodeMap[std::make_pair(base, ls)] = i;
-    GepObjPN *node = new GepObjPN(obj->getRefVal(), i, obj, ls);
+    GepObjPN *node = new (getArena()) GepObjPN(obj->getRefVal(), i, obj, ls);
     memToFieldsMap[base].set(i);
     return addObjNode(obj->getRefVal(), node, i);
 }
@@ -331,7 +331,7 @@ NodeID PAG::addFIObjNode(const MemObj* obj, NodeID i)
     //assert(findPAGNode(i) == false && "this node should not be created before");
     NodeID base = getObjectNode(obj);
     memToFieldsMap[base].set(i);
-    FIObjPN *node = new FIObjPN(obj->getRefVal(), i, obj);
+    FIObjPN *node = new (getArena()) FIObjPN(obj->getRefVal(), i, obj);
     return addObjNode(obj->getRefVal(), node, i);
 }
 
@@ -494,16 +494,9 @@ LocationSet PAG::getLocationSetFromBaseNode(NodeID nodeId) {
 
 /*!
  * Clean up memory
+ * Every edge is an incoming edge of its dst node, which deletes it in GenericGraph
  */
 void PAG::destroy() {
-    for (PAGEdge::PAGKindToEdgeSetMapTy::iterator I =
-                PAGEdgeKindToSetMap.begin(), E = PAGEdgeKindToSetMap.end(); I != E;
-            ++I) {
-        for (PAGEdge::PAGEdgeSetTy::iterator edgeIt = I->second.begin(),
-                endEdgeIt = I->second.end(); edgeIt != endEdgeIt; ++edgeIt) {
-            delete *edgeIt;
-        }
-    }
     delete symInfo;
     symInfo = NULL;
 }
@@ -1133,9 +1133,9 @@ void PAGBuilderFromFile::addEdge(NodeID srcID, NodeID dstID,
     else if (edge == "variant-gep")
         pag->addVariantGepEdge(srcID, dstID);
     else if (edge == "call")
-        pag->addEdge(srcNode, dstNode, new CallPE(srcNode, dstNode, NULL));
+        pag->addEdge(srcNode, dstNode, new (pag->getArena()) CallPE(srcNode, dstNode, NULL));
     else if (edge == "ret")
-        pag->addEdge(srcNode, dstNode, new RetPE(srcNode, dstNode, NULL));
+        pag->addEdge(srcNode, dstNode, new (pag->getArena()) RetPE(srcNode, dstNode, NULL));
     else
         assert(false && "format not support, can not create such edge");
 }
@@ -36,6 +36,10 @@
 #include "Util/CPPUtil.h"
 #include "MemoryModel/CHA.h"
 #include "MemoryModel/PTAType.h"
+#include <llvm/Bitcode/ReaderWriter.h>	// for WriteBitcodeToFile
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -85,6 +89,12 @@ static cl::opt<bool> EnableThreadCallGraph("enable-tcg", cl::init(true),
 static cl::opt<bool> INCDFPTData("incdata", cl::init(true),
                                  cl::desc("Enable incremental DFPTData for flow-sensitive analysis"));
 
+static cl::opt<bool> HashConsPts("hash-pts", cl::init(false),
+                                 cl::desc("Share identical points-to sets of Andersen's analysis (not for the diff wave solver)"));
+
+static cl::opt<bool> DensePts("dense-pts", cl::init(false),
+                              cl::desc("Index the points-to sets of Andersen's analysis by node IDs in dense vectors"));
+
 CHGraph* PointerAnalysis::chgraph = NULL;
 PAG* PointerAnalysis::pag = NULL;
 llvm::Module* PointerAnalysis::mod = NULL;
@@ -298,12 +308,20 @@ void PointerAnalysis::dumpAllTypes()
 /*!
  * Constructor
  */
-BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type) {
+BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type), mapPtD(NULL) {
     if(type == Andersen_WPA || type == AndersenWave_WPA || type == AndersenLCD_WPA) {
-        ptD = new PTDataTy();
+        if(HashConsPts)
+            ptD = new HashConsPTDataTy();
+        else if(DensePts)
+            ptD = new DensePTDataTy();
+        else
+            ptD = mapPtD = new PTDataTy();
     }
     else if (type == AndersenWaveDiff_WPA) {
-        ptD = new DiffPTDataTy();
+        if(DensePts)
+            ptD = new DenseDiffPTDataTy();
+        else
+            ptD = mapPtD = new DiffPTDataTy();
     }
     else if (type == FSSPARSE_WPA) {
         if(INCDFPTData)
@@ -312,7 +330,7 @@ BVDataPTAImpl::BVDataPTAImpl(PointerAnalysis::PTATY type) : PointerAnalysis(type
             ptD = new DFPTDataTy();
     }
     else if (type == FlowS_DDA) {
-        ptD = new PTDataTy();
+        ptD = mapPtD = new PTDataTy();
     }
     else
         assert(false && "no points-to data available");
@@ -422,7 +440,7 @@ bool BVDataPTAImpl::readFromFile(const string& filename) {
 
         // var
         NodeID var = atoi(line.substr(0, pos).c_str());
-        PointsTo &pts = ptD->getPts(var);
+        PointsTo pts;
 
         // objs
         pos = pos + delimiter1.length();
@@ -436,6 +454,7 @@ bool BVDataPTAImpl::readFromFile(const string& filename) {
                 pts.set(obj);
             }
         }
+        ptD->unionPts(var, pts);
     }
 
     // Read PAG offset nodes
@@ -462,6 +481,283 @@ bool BVDataPTAImpl::readFromFile(const string& filename) {
     return true;
 }
 
+/*
+ * Layout of the binary result cache, all integers in little endian:
+ *
+ *   header      magic, version, analysis type, fingerprint, node number,
+ *               gep object number, collapsed object number, set bytes
+ *   offsets     one u32 per node ID, (offset of its set in the set section + 1) or 0
+ *   gep objs    (id, base, offset) of each gep object node in ID order
+ *   collapsed   base objects made field-insensitive
+ *   sets        per set the number of runs of consecutive IDs, then each run as
+ *               (distance from the end of the previous run, length - 1), in ULEB128
+ */
+static const char PTSCacheMagic[8] = {'S', 'V', 'F', 'P', 'T', 'S', 'B', 'N'};
+static const u32_t PTSCacheVersion = 1;
+static const u32_t PTSCacheHeaderSize = 8 + 4 * 2 + 8 + 4 * 4;
+
+static inline void writeU32(std::string& buf, u32_t val) {
+    for (u32_t i = 0; i < 4; ++i)
+        buf.push_back((char)((val >> (8 * i)) & 0xff));
+}
+
+static inline void writeU64(std::string& buf, u64_t val) {
+    writeU32(buf, (u32_t)val);
+    writeU32(buf, (u32_t)(val >> 32));
+}
+
+static inline void writeULEB(std::string& buf, u32_t val) {
+    do {
+        unsigned char byte = val & 0x7f;
+        val >>= 7;
+        if (val != 0)
+            byte |= 0x80;
+        buf.push_back((char)byte);
+    } while (val != 0);
+}
+
+static inline u32_t readU32(const unsigned char* p) {
+    return (u32_t)p[0] | ((u32_t)p[1] << 8) | ((u32_t)p[2] << 16) | ((u32_t)p[3] << 24);
+}
+
+static inline u64_t readU64(const unsigned char* p) {
+    return (u64_t)readU32(p) | ((u64_t)readU32(p + 4) << 32);
+}
+
+/// Decode a ULEB128 value, return false if it runs past the end of the buffer
+static inline bool readULEB(const unsigned char*& p, const unsigned char* end, u32_t& val) {
+    val = 0;
+    for (u32_t shift = 0; p != end && shift < 35; shift += 7) {
+        unsigned char byte = *p++;
+        val |= (u32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Fingerprint of the analysed module and of the options that shape the result:
+ * the bitcode, the analysis type, the field limit, and the PAG size, which reflects
+ * the memory model options. It must be taken before solving, since solving adds
+ * gep object nodes into the PAG.
+ */
+u64_t BVDataPTAImpl::getResultFingerprint() const {
+    std::string bitcode;
+    raw_string_ostream os(bitcode);
+    WriteBitcodeToFile(getModule(), os);
+    os.flush();
+
+    std::string opts;
+    writeU32(opts, getAnalysisTy());
+    writeU32(opts, SymbolTableInfo::getMaxFieldLimit());
+    writeU64(opts, pag->getPAGNodeNum());
+    writeU64(opts, pag->getPAGEdgeNum());
+    writeU64(opts, pag->getTotalNodeNum());
+
+    MD5 hash;
+    hash.update(StringRef(bitcode));
+    hash.update(StringRef(opts));
+    MD5::MD5Result result;
+    hash.final(result);
+
+    u64_t fingerprint = 0;
+    for (u32_t i = 0; i < 8; ++i)
+        fingerprint |= (u64_t)result[i] << (8 * i);
+    return fingerprint;
+}
+
+/*!
+ * Store pointer analysis result into a binary cache file.
+ * Besides the points-to sets it keeps the gep object nodes created when solving
+ * Andersen's constraints and the objects collapsed into field-insensitive ones.
+ */
+void BVDataPTAImpl::writeToBinaryFile(const string& filename, u64_t fingerprint) {
+    outs() << "Storing pointer analysis results to cache '" << filename << "'...";
+
+    error_code err;
+    tool_output_file F(filename.c_str(), err, sys::fs::F_None);
+    if (err) {
+        outs() << "  error opening file for writing!\n";
+        F.os().clear_error();
+        return;
+    }
+
+    u32_t nodeNum = pag->getTotalNodeNum();
+    std::vector<u32_t> offsets(nodeNum, 0);
+    std::string sets;
+
+    // Query every node rather than the keys of the points-to data, so that
+    // the nodes merged into an SCC get the set of their representative
+    for (NodeID var = 0; var != nodeNum; ++var) {
+        const PointsTo &pts = getPts(var);
+        if (pts.empty())
+            continue;
+        offsets[var] = sets.size() + 1;
+
+        std::vector<std::pair<u32_t, u32_t> > runs;
+        for (PointsTo::iterator pit = pts.begin(), epit = pts.end(); pit != epit; ++pit) {
+            if (!runs.empty() && runs.back().first + runs.back().second == *pit)
+                runs.back().second++;
+            else
+                runs.push_back(std::make_pair(*pit, 1));
+        }
+        writeULEB(sets, runs.size());
+        u32_t prevEnd = 0;
+        for (u32_t i = 0; i < runs.size(); ++i) {
+            writeULEB(sets, runs[i].first - prevEnd);
+            writeULEB(sets, runs[i].second - 1);
+            prevEnd = runs[i].first + runs[i].second;
+        }
+    }
+
+    std::string geps;
+    std::string collapsed;
+    u32_t gepNum = 0;
+    u32_t collapsedNum = 0;
+    for (NodeID i = 0; i != nodeNum; ++i) {
+        PAGNode* node = pag->getPAGNode(i);
+        if (GepObjPN *gepObjPN = dyn_cast<GepObjPN>(node)) {
+            writeU32(geps, i);
+            writeU32(geps, pag->getBaseObjNode(i));
+            writeU32(geps, gepObjPN->getLocationSet().getOffset());
+            gepNum++;
+        }
+        else if (isa<ObjPN>(node) && !isa<DummyObjPN>(node) &&
+                 pag->getBaseObjNode(i) == i && isFieldInsensitive(i)) {
+            writeU32(collapsed, i);
+            collapsedNum++;
+        }
+    }
+
+    std::string header(PTSCacheMagic, sizeof(PTSCacheMagic));
+    writeU32(header, PTSCacheVersion);
+    writeU32(header, getAnalysisTy());
+    writeU64(header, fingerprint);
+    writeU32(header, nodeNum);
+    writeU32(header, gepNum);
+    writeU32(header, collapsedNum);
+    writeU32(header, sets.size());
+    assert(header.size() == PTSCacheHeaderSize && "unexpected header size");
+
+    F.os() << header;
+    std::string offsetTable;
+    offsetTable.reserve(nodeNum * 4);
+    for (u32_t i = 0; i < nodeNum; ++i)
+        writeU32(offsetTable, offsets[i]);
+    F.os() << offsetTable << geps << collapsed << sets;
+
+    // Job finish and close file
+    F.os().close();
+    if (!F.os().has_error()) {
+        outs() << "\n";
+        F.keep();
+        return;
+    }
+}
+
+/*!
+ * Load pointer analysis result from a binary cache file.
+ * The file is memory-mapped and decoded in place. It is rejected before anything
+ * is changed if it was written for another module, other options or another analysis.
+ */
+bool BVDataPTAImpl::readFromBinaryFile(const string& filename, u64_t fingerprint) {
+    outs() << "Loading pointer analysis results from cache '" << filename << "'...";
+
+    ErrorOr<std::unique_ptr<MemoryBuffer> > fileOrErr =
+        MemoryBuffer::getFile(filename, -1, /*RequiresNullTerminator=*/false);
+    if (!fileOrErr) {
+        outs() << "  no cache file!\n";
+        return false;
+    }
+
+    const MemoryBuffer& buf = *fileOrErr.get();
+    const unsigned char* begin = (const unsigned char*)buf.getBufferStart();
+    const unsigned char* end = (const unsigned char*)buf.getBufferEnd();
+    if (buf.getBufferSize() < PTSCacheHeaderSize ||
+            memcmp(begin, PTSCacheMagic, sizeof(PTSCacheMagic)) != 0 ||
+            readU32(begin + 8) != PTSCacheVersion) {
+        outs() << "  not a cache file of this version!\n";
+        return false;
+    }
+    if (readU32(begin + 12) != (u32_t)getAnalysisTy() || readU64(begin + 16) != fingerprint) {
+        outs() << "  stale cache, ignored!\n";
+        return false;
+    }
+
+    u32_t nodeNum = readU32(begin + 24);
+    u32_t gepNum = readU32(begin + 28);
+    u32_t collapsedNum = readU32(begin + 32);
+    u32_t setBytes = readU32(begin + 36);
+    const unsigned char* offsets = begin + PTSCacheHeaderSize;
+    const unsigned char* geps = offsets + (u64_t)nodeNum * 4;
+    const unsigned char* collapsed = geps + (u64_t)gepNum * 12;
+    const unsigned char* sets = collapsed + (u64_t)collapsedNum * 4;
+    if ((u64_t)(end - begin) != PTSCacheHeaderSize + (u64_t)nodeNum * 4 +
+            (u64_t)gepNum * 12 + (u64_t)collapsedNum * 4 + setBytes) {
+        outs() << "  truncated cache file!\n";
+        return false;
+    }
+
+    // Decode the points-to sets before touching the PAG
+    typedef std::vector<std::pair<NodeID, PointsTo> > PtsVec;
+    PtsVec ptsVec;
+    for (NodeID var = 0; var < nodeNum; ++var) {
+        u32_t off = readU32(offsets + var * 4);
+        if (off == 0)
+            continue;
+        if (off > setBytes) {
+            outs() << "  corrupted cache file!\n";
+            return false;
+        }
+        const unsigned char* p = sets + off - 1;
+        ptsVec.push_back(std::make_pair(var, PointsTo()));
+        PointsTo& pts = ptsVec.back().second;
+        u32_t runNum = 0;
+        bool ok = readULEB(p, end, runNum);
+        u32_t prevEnd = 0;
+        for (u32_t i = 0; ok && i < runNum; ++i) {
+            u32_t gap = 0, len = 0;
+            ok = readULEB(p, end, gap) && readULEB(p, end, len);
+            for (u32_t obj = prevEnd + gap, e = obj + len + 1; ok && obj != e; ++obj)
+                pts.set(obj);
+            prevEnd += gap + len + 1;
+        }
+        if (!ok) {
+            outs() << "  corrupted cache file!\n";
+            return false;
+        }
+    }
+
+    // Recreate the gep object nodes in ID order, the cache is not used if they get other IDs
+    for (u32_t i = 0; i < gepNum; ++i) {
+        const unsigned char* rec = geps + i * 12;
+        NodeID id = readU32(rec);
+        NodeID base = readU32(rec + 4);
+        u32_t offset = readU32(rec + 8);
+
+        const MemObj* obj = pag->findPAGNode(base) ? pag->getObject(base) : NULL;
+        if (obj == NULL || pag->getGepObjNode(obj, LocationSet(offset)) != id) {
+            outs() << "  gep objects do not match the module, cache ignored!\n";
+            return false;
+        }
+    }
+
+    for (u32_t i = 0; i < collapsedNum; ++i)
+        setObjFieldInsensitive(readU32(collapsed + i * 4));
+
+    PTDataTy *ptD = getPTDataTy();
+    for (PtsVec::const_iterator it = ptsVec.begin(), eit = ptsVec.end(); it != eit; ++it)
+        ptD->unionPts(it->first, it->second);
+
+    // Update callgraph
+    updateCallGraph(pag->getIndirectCallsites());
+
+    outs() << "\n";
+
+    return true;
+}
+
 /*!
  * Dump points-to of each pag node
  */
@@ -11,6 +11,7 @@
  *  	to ReachableSet[].
  */
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -34,32 +35,29 @@ CFGReachabilityAnalysis::~CFGReachabilityAnalysis() {
 }
 
 bool CFGReachabilityAnalysis::runOnModule(Module& M) {
-	return false;
+    // Build every index up front, the queries are then read-only and
+    // can be issued from several threads without locking
+    for (auto &F : M) {
+        if (F.isDeclaration())
+            continue;
+        funcReachMap[&F] = new CFGReachability(F);
+    }
+    return false;
 }
 
-CFGReachability* CFGReachabilityAnalysis::getReachabilityResultFor(const Function* func)
+const CFGReachability* CFGReachabilityAnalysis::getReachabilityResultFor(const Function* func) const
 {
-    CFGReachability* result;
     auto It = funcReachMap.find(func);
-
-    if (It == funcReachMap.end()) {
-        // We build the reachability results on demand
-        result = new CFGReachability(*func);
-        funcReachMap[func] = result;
-    }
-    else {
-        result = It->second;
-    }
-
-    return result;
+    assert(It != funcReachMap.end() && "reachability of a function without body?");
+    return It->second;
 }
 
-bool CFGReachabilityAnalysis::isBBReachable(const BasicBlock *Src, const BasicBlock *Dst) {
+bool CFGReachabilityAnalysis::isBBReachable(const BasicBlock *Src, const BasicBlock *Dst) const {
     assert(
             Src->getParent() == Dst->getParent()
                     && "Cannot query two basic blocks in different functions");
 
-    CFGReachability* BB_reach_set = getReachabilityResultFor(Src->getParent());
+    const CFGReachability* BB_reach_set = getReachabilityResultFor(Src->getParent());
     return BB_reach_set->isReachable(Src, Dst);
 }
 
@@ -68,19 +66,11 @@ bool CFGReachabilityAnalysis::isReachableInBlock(const Instruction* Src,
     assert(Src->getParent() == Dst->getParent()
             && "isReachableInBlock is called on two instructions that belongs to different Basic Blocks");
 
-    auto *srcBB = Src->getParent();
-    for (auto &I : *srcBB) {
-        if (&I == Src) {
-            return true;
-        } else if (&I == Dst) {
-            return false;
-        }
-    }
-
-    return false;
+    const CFGReachability* BB_reach_set = getReachabilityResultFor(Src->getParent()->getParent());
+    return BB_reach_set->isReachableInBlock(Src, Dst);
 }
 
-bool CFGReachabilityAnalysis::isReachable(const Instruction* Src, const Instruction* Dst) {
+bool CFGReachabilityAnalysis::isReachable(const Instruction* Src, const Instruction* Dst) const {
 
     auto *srcBB = Src->getParent();
     auto *dstBB = Dst->getParent();
@@ -94,71 +84,136 @@ bool CFGReachabilityAnalysis::isReachable(const Instruction* Src, const Instruct
     }
 }
 
-CFGReachability::CFGReachability(const Function& F) :
-        analyzed(F.size(), false) {
+CFGReachability::CFGReachability(const Function& F) {
+    buildIndex(F);
+}
+
+CFGReachability::~CFGReachability() {
+}
 
-    reachable = new ReachableSet[F.size()];
-    unsigned int i = 0;
+// Condense the CFG with an iterative Tarjan's algorithm, then compute the
+// transitive closure of the condensed DAG. Tarjan's algorithm finishes an SCC
+// only after all the SCCs reachable from it, so SCC IDs are in reverse
+// topological order and every successor row is complete when it is merged.
+void CFGReachability::buildIndex(const Function& F) {
+    const unsigned N = F.size();
 
+    std::vector<const BasicBlock *> IDtoBB;
+    std::unordered_map<const BasicBlock *, unsigned> BBID;
     for (auto &BB : F) {
+        BBID[&BB] = IDtoBB.size();
         IDtoBB.push_back(&BB);
-        BBID[&BB] = i;
-        reachable[i].resize(F.size(), false);
-        ++i;
+
+        unsigned ordinal = 0;
+        for (auto &I : BB)
+            InstOrdinal[&I] = ordinal++;
     }
-}
 
-CFGReachability::~CFGReachability() {
-    delete [] reachable;
-}
+    std::vector<std::vector<unsigned> > succs(N);
+    std::vector<bool> selfLoop(N, false);
+    for (unsigned i = 0; i < N; ++i) {
+        for (auto I = succ_begin(IDtoBB[i]), E = succ_end(IDtoBB[i]); I != E; ++I) {
+            unsigned succID = BBID.at(*I);
+            succs[i].push_back(succID);
+            if (succID == i)
+                selfLoop[i] = true;
+        }
+    }
 
-// Maps reachability to a common node by walking the predecessors of the
-// destination node.
-void CFGReachability::mapReachability(const BasicBlock *Dst) {
-	llvm::BitVector visited(analyzed.size());
-
-	ReachableSet &DstReachability = reachable[BBID[Dst]];
-
-	// Search all the reachable nodes from \p Dst
-	std::vector<const BasicBlock *> worklist;
-	worklist.push_back(Dst);
-	bool firstRun = true;
-
-	while (!worklist.empty()) {
-		const BasicBlock *block = worklist.back();
-		worklist.pop_back();
-		unsigned blockID = BBID[block];
-		if (visited[blockID])
-			continue;
-		visited[blockID] = true;
-
-		// Update reachability information for this node -> Dst
-		if (!firstRun) {
-			// Don't insert Dst -> Dst unless it was a predecessor of itself
-			DstReachability[blockID] = true;
-		} else
-			firstRun = false;
-
-		// Add the predecessors to the worklist.
-		for (auto I = pred_begin(block), E = pred_end(block); I != E;
-				++I) {
-			const BasicBlock* pred_bb = *I;
-			worklist.push_back(pred_bb);
-		}
-	}
+    // Tarjan's algorithm over all the blocks, including those unreachable from the entry
+    const int unvisited = -1;
+    std::vector<int> index(N, unvisited), lowlink(N, 0);
+    std::vector<bool> onStack(N, false);
+    std::vector<unsigned> sccOf(N, 0);
+    std::vector<bool> sccCyclic;
+    std::vector<unsigned> stack;
+    std::vector<std::pair<unsigned, unsigned> > callStack;	// (block, next successor)
+    int counter = 0;
+
+    for (unsigned root = 0; root < N; ++root) {
+        if (index[root] != unvisited)
+            continue;
+
+        index[root] = lowlink[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = true;
+        callStack.push_back(std::make_pair(root, 0));
+
+        while (!callStack.empty()) {
+            unsigned v = callStack.back().first;
+            unsigned next = callStack.back().second;
+            if (next < succs[v].size()) {
+                callStack.back().second++;
+                unsigned w = succs[v][next];
+                if (index[w] == unvisited) {
+                    index[w] = lowlink[w] = counter++;
+                    stack.push_back(w);
+                    onStack[w] = true;
+                    callStack.push_back(std::make_pair(w, 0));
+                } else if (onStack[w]) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                unsigned u = callStack.back().first;
+                lowlink[u] = std::min(lowlink[u], lowlink[v]);
+            }
+
+            if (lowlink[v] == index[v]) {
+                unsigned sccID = sccCyclic.size();
+                bool cyclic = selfLoop[v];
+                unsigned w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = false;
+                    sccOf[w] = sccID;
+                    if (w != v)
+                        cyclic = true;
+                } while (w != v);
+                sccCyclic.push_back(cyclic);
+            }
+        }
+    }
+
+    const unsigned numSCC = sccCyclic.size();
+    std::vector<std::vector<unsigned> > sccMembers(numSCC);
+    for (unsigned i = 0; i < N; ++i) {
+        BBToSCC[IDtoBB[i]] = sccOf[i];
+        sccMembers[sccOf[i]].push_back(i);
+    }
+
+    sccReachable.assign(numSCC, ReachableSet(numSCC, false));
+    for (unsigned scc = 0; scc < numSCC; ++scc) {
+        ReachableSet &sccReach = sccReachable[scc];
+        if (sccCyclic[scc])
+            sccReach.set(scc);
+        for (unsigned bb : sccMembers[scc]) {
+            for (unsigned succID : succs[bb]) {
+                unsigned succSCC = sccOf[succID];
+                if (succSCC == scc || sccReach.test(succSCC))
+                    continue;
+                assert(succSCC < scc && "SCCs not in reverse topological order?");
+                sccReach.set(succSCC);
+                sccReach |= sccReachable[succSCC];
+            }
+        }
+    }
 }
 
-bool CFGReachability::isReachable(const BasicBlock* Src, const BasicBlock* Dst) {
+bool CFGReachability::isReachable(const BasicBlock* Src, const BasicBlock* Dst) const {
 
-	assert(BBID.count(Dst) && BBID.count(Src) && "Never labeled the queried BB");
+	assert(BBToSCC.count(Dst) && BBToSCC.count(Src) && "Never labeled the queried BB");
 
-	const unsigned DstBlockID = BBID.at(Dst);
-	// If we haven't analyzed the destination node, run the analysis now
-	if (!analyzed[DstBlockID]) {
-		mapReachability(Dst);
-		analyzed[DstBlockID] = true;
-	}
+	return sccReachable[BBToSCC.at(Src)][BBToSCC.at(Dst)];
+}
+
+bool CFGReachability::isReachableInBlock(const Instruction* Src, const Instruction* Dst) const {
+
+	assert(InstOrdinal.count(Src) && InstOrdinal.count(Dst) && "Never labeled the queried instruction");
 
-	// Return the cached result
-	return reachable[DstBlockID][BBID.at(Src)];
+	return InstOrdinal.at(Src) <= InstOrdinal.at(Dst);
 }
@@ -0,0 +1,205 @@
+//===- InterProcReachability.cpp -- Interprocedural CFG reachability----------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * InterProcReachability.cpp
+ */
+
+#include "SABER/InterProcReachability.h"
+#include <llvm/IR/Instructions.h>
+
+using namespace llvm;
+
+InterProcReachability::InterProcReachability(PTACallGraph* cg, const CFGReachabilityAnalysis* cfgr) :
+    callgraph(cg), CFGR(cfgr), callGraphSCC(NULL) {
+    build();
+}
+
+InterProcReachability::~InterProcReachability() {
+    for (InstToSummaryMap::iterator it = summaries.begin(), eit = summaries.end(); it != eit; ++it)
+        delete it->second;
+    delete callGraphSCC;
+}
+
+/*!
+ * The callee closure is computed over the SCCs of the call graph in reverse
+ * topological order, so that the closures of the callees are complete
+ * when they are merged into their callers.
+ */
+void InterProcReachability::build() {
+    const u32_t funNum = callgraph->getTotalNodeNum();
+
+    for (PTACallGraph::iterator it = callgraph->begin(), eit = callgraph->end(); it != eit; ++it) {
+        const Function* fun = it->second->getFunction();
+        if (fun->isDeclaration())
+            continue;
+
+        InstVec& callsites = funToCallSites[fun];
+        std::vector<const BasicBlock*>& exits = funToExitBBs[fun];
+        for (Function::const_iterator bit = fun->begin(), ebit = fun->end(); bit != ebit; ++bit) {
+            const BasicBlock* bb = &*bit;
+            if (isa<ReturnInst>(bb->getTerminator()))
+                exits.push_back(bb);
+            for (BasicBlock::const_iterator iit = bb->begin(), eiit = bb->end(); iit != eiit; ++iit) {
+                if (callgraph->hasCallGraphEdge(&*iit))
+                    callsites.push_back(&*iit);
+            }
+        }
+    }
+
+    callGraphSCC = new CallGraphSCC(callgraph);
+    callGraphSCC->find();
+
+    NodeStack& topoOrder = callGraphSCC->topoNodeStack();
+    std::vector<NodeID> revTopoOrder;
+    while (!topoOrder.empty()) {
+        revTopoOrder.push_back(topoOrder.top());
+        topoOrder.pop();
+    }
+
+    calleeClosure.assign(funNum, FunctionBS());
+    for (std::vector<NodeID>::reverse_iterator it = revTopoOrder.rbegin(), eit = revTopoOrder.rend(); it != eit; ++it) {
+        NodeID rep = *it;
+        FunctionBS& closure = calleeClosure[rep];
+        closure.resize(funNum);
+
+        const NodeBS& subNodes = callGraphSCC->subNodes(rep);
+        bool inCycle = callGraphSCC->isInCycle(rep);
+        for (NodeBS::iterator nit = subNodes.begin(), enit = subNodes.end(); nit != enit; ++nit) {
+            if (inCycle)
+                closure.set(*nit);
+
+            PTACallGraphNode* node = callgraph->getCallGraphNode(*nit);
+            for (PTACallGraphNode::const_iterator eit = node->OutEdgeBegin(), eeit = node->OutEdgeEnd(); eit != eeit; ++eit) {
+                NodeID callee = (*eit)->getDstID();
+                NodeID calleeRep = callGraphSCC->repNode(callee);
+                if (calleeRep == rep || closure.test(callee))
+                    continue;
+                closure.set(callee);
+                closure |= calleeClosure[calleeRep];
+            }
+        }
+    }
+}
+
+void InterProcReachability::enterCallees(const Instruction* inst, FunctionBS& entered) const {
+    FunToInstsMap::const_iterator it = funToCallSites.find(inst->getParent()->getParent());
+    if (it == funToCallSites.end())
+        return;
+
+    for (InstVec::const_iterator cit = it->second.begin(), ecit = it->second.end(); cit != ecit; ++cit) {
+        const Instruction* cs = *cit;
+        if (cs == inst || !CFGR->isReachable(inst, cs))
+            continue;
+
+        for (PTACallGraph::CallGraphEdgeSet::const_iterator eit = callgraph->getCallEdgeBegin(cs),
+                eeit = callgraph->getCallEdgeEnd(cs); eit != eeit; ++eit) {
+            NodeID callee = (*eit)->getDstID();
+            if (entered.test(callee))
+                continue;
+            entered.set(callee);
+            entered |= calleeClosure[callGraphSCC->repNode(callee)];
+        }
+    }
+}
+
+bool InterProcReachability::mayReturn(const Instruction* inst) const {
+    const BasicBlock* bb = inst->getParent();
+    if (isa<ReturnInst>(bb->getTerminator()))
+        return true;
+
+    FunToBBsMap::const_iterator it = funToExitBBs.find(bb->getParent());
+    if (it == funToExitBBs.end())
+        return false;
+
+    for (std::vector<const BasicBlock*>::const_iterator bit = it->second.begin(), ebit = it->second.end(); bit != ebit; ++bit) {
+        if (CFGR->isBBReachable(bb, *bit))
+            return true;
+    }
+    return false;
+}
+
+/*!
+ * Walk up the call graph from the function of src. Every call site of a caller
+ * is a resume point once its callee returns, and the callees of the call sites
+ * reachable from a resume point may be entered as well.
+ */
+const InterProcReachability::Summary* InterProcReachability::getSummary(const Instruction* src) {
+    std::lock_guard<std::mutex> lock(summaryMutex);
+    InstToSummaryMap::const_iterator it = summaries.find(src);
+    if (it != summaries.end())
+        return it->second;
+
+    Summary* summary = new Summary();
+    summary->entered.resize(callgraph->getTotalNodeNum());
+    enterCallees(src, summary->entered);
+
+    std::set<const Instruction*> visited;
+    std::vector<const Instruction*> worklist;
+    worklist.push_back(src);
+    while (!worklist.empty()) {
+        const Instruction* inst = worklist.back();
+        worklist.pop_back();
+        if (!mayReturn(inst))
+            continue;
+
+        PTACallGraphNode* node = callgraph->getCallGraphNode(inst->getParent()->getParent());
+        for (PTACallGraphNode::const_iterator eit = node->InEdgeBegin(), eeit = node->InEdgeEnd(); eit != eeit; ++eit) {
+            const PTACallGraphEdge* edge = *eit;
+            for (int k = 0; k < 2; ++k) {
+                const PTACallGraphEdge::CallInstSet& calls = k == 0 ? edge->getDirectCalls() : edge->getIndirectCalls();
+                for (PTACallGraphEdge::CallInstSet::const_iterator cit = calls.begin(), ecit = calls.end(); cit != ecit; ++cit) {
+                    const Instruction* cs = *cit;
+                    if (!visited.insert(cs).second)
+                        continue;
+                    summary->resumed[cs->getParent()->getParent()].push_back(cs);
+                    enterCallees(cs, summary->entered);
+                    worklist.push_back(cs);
+                }
+            }
+        }
+    }
+
+    summaries[src] = summary;
+    return summary;
+}
+
+bool InterProcReachability::isReachable(const Instruction* src, const Instruction* dst) {
+    const Function* dstFun = dst->getParent()->getParent();
+    if (src->getParent()->getParent() == dstFun)
+        return CFGR->isReachable(src, dst);
+
+    const Summary* summary = getSummary(src);
+
+    if (summary->entered.test(getFunID(dstFun)))
+        return true;
+
+    FunToInstsMap::const_iterator rit = summary->resumed.find(dstFun);
+    if (rit == summary->resumed.end())
+        return false;
+    /// dst may be a resume point itself, e.g. the call site of the callee freeing an object
+    for (InstVec::const_iterator cit = rit->second.begin(), ecit = rit->second.end(); cit != ecit; ++cit) {
+        if (*cit == dst || CFGR->isReachable(*cit, dst))
+            return true;
+    }
+    return false;
+}
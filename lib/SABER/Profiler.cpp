@@ -6,7 +6,10 @@
  */
 
 #include <llvm/Support/raw_ostream.h>
+#include <algorithm>
 #include "SABER/Profiler.h"
+#include "Util/ByteCoder.h"
+#include <cstring>
 
 using namespace llvm;
 
@@ -30,6 +33,10 @@ int Profiler::pick_peak_memory() {
 	return pick_info("VmPeak");
 }
 
+int Profiler::pick_peak_rss() {
+	return pick_info("VmHWM");
+}
+
 int Profiler::pick_info(const char* info_name) {
 	int ret = VALUE_UNDEF;
 
@@ -187,3 +194,95 @@ void Profiler::print_peak_memory() {
 	int peak_memory = pick_peak_memory();
 	print_memory("Peak", peak_memory);
 }
+
+void Profiler::print_peak_rss() {
+	int peak_rss = pick_peak_rss();
+	print_memory("Peak RSS", peak_rss);
+}
+
+void Profiler::add_counter(const std::string& name, uint64_t value) {
+	counters[name] += value;
+}
+
+void Profiler::print_counters() {
+	for (auto& counter : counters) {
+		outs() << counter.first << ": \t" << counter.second << "\n";
+	}
+}
+
+void Profiler::add_cost(const std::string& name, double seconds, uint64_t nodes, uint64_t bdd_nodes) {
+	cost_t cost;
+	cost.name = name;
+	cost.seconds = seconds;
+	cost.nodes = nodes;
+	cost.bdd_nodes = bdd_nodes;
+	costs.push_back(cost);
+}
+
+void Profiler::print_top_costs(size_t n) {
+	if (costs.empty() || n == 0)
+		return;
+
+	std::vector<cost_t> sorted(costs);
+	std::stable_sort(sorted.begin(), sorted.end(), [](const cost_t& a, const cost_t& b) {
+		return a.seconds > b.seconds;
+	});
+	if (sorted.size() > n)
+		sorted.resize(n);
+
+	outs() << "Top " << sorted.size() << " of " << costs.size() << " items by time:\n";
+	for (auto& cost : sorted) {
+		outs() << cost.name << ": \t" << cost.seconds << "s, "
+			   << cost.nodes << " nodes, " << cost.bdd_nodes << " BDD nodes\n";
+	}
+}
+
+void Profiler::clear_records() {
+	counters.clear();
+	costs.clear();
+}
+
+void Profiler::save_records(std::string& data) const {
+	ByteCoder::putU64(data, counters.size());
+	for (auto& counter : counters) {
+		ByteCoder::putString(data, counter.first);
+		ByteCoder::putU64(data, counter.second);
+	}
+
+	ByteCoder::putU64(data, costs.size());
+	for (auto& cost : costs) {
+		u64_t seconds;
+		memcpy(&seconds, &cost.seconds, sizeof(seconds));
+		ByteCoder::putString(data, cost.name);
+		ByteCoder::putU64(data, seconds);
+		ByteCoder::putU64(data, cost.nodes);
+		ByteCoder::putU64(data, cost.bdd_nodes);
+	}
+}
+
+void Profiler::load_records(const std::string& data) {
+	size_t pos = 0;
+	u64_t num = 0;
+	ByteCoder::getU64(data, pos, num);
+	for (u64_t i = 0; i < num; ++i) {
+		std::string name;
+		u64_t value;
+		if (!ByteCoder::getString(data, pos, name) || !ByteCoder::getU64(data, pos, value))
+			return;
+		counters[name] += value;
+	}
+
+	num = 0;
+	ByteCoder::getU64(data, pos, num);
+	for (u64_t i = 0; i < num; ++i) {
+		cost_t cost;
+		u64_t seconds, nodes, bdd_nodes;
+		if (!ByteCoder::getString(data, pos, cost.name) || !ByteCoder::getU64(data, pos, seconds)
+				|| !ByteCoder::getU64(data, pos, nodes) || !ByteCoder::getU64(data, pos, bdd_nodes))
+			return;
+		memcpy(&cost.seconds, &seconds, sizeof(seconds));
+		cost.nodes = nodes;
+		cost.bdd_nodes = bdd_nodes;
+		costs.push_back(cost);
+	}
+}
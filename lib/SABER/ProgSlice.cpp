@@ -50,12 +50,17 @@ void ProgSlice::AllPathReachableSolve() {
     setVFCond(source,getTrueCond());
 
     while(!worklist.empty()) {
+        /// the conditions are incomplete if the budget is exhausted, the caller must not trust them
+        if(budget && !budget->visit())
+            break;
+
         const SVFGNode* node = worklist.pop();
         setCurSVFGNode(node);
         Condition* cond = getVFCond(node);
-        for(SVFGNode::const_iterator it = node->OutEdgeBegin(), eit = node->OutEdgeEnd(); it!=eit; ++it) {
-            const SVFGEdge* edge = (*it);
-            const SVFGNode* succ = edge->getDstNode();
+        /// walk the CSR records of the frozen SVFG, they carry the call sites of call/ret edges
+        const SVFG::SVFGCSR* csr = getSVFG()->getCSR();
+        for(SVFG::SVFGCSR::const_iterator it = csr->outBegin(node->getId()), eit = csr->outEnd(node->getId()); it!=eit; ++it) {
+            const SVFGNode* succ = it->node;
             if(inBackwardSlice(succ)) {
                 Condition* vfCond = NULL;
                 const BasicBlock* nodeBB = getSVFGNodeBB(node);
@@ -63,11 +68,11 @@ void ProgSlice::AllPathReachableSolve() {
                 /// clean up the control flow conditions for next round guard computation
                 clearCFCond();
 
-                if(edge->isCallVFGEdge()) {
-                    vfCond = ComputeInterCallVFGGuard(nodeBB,succBB, getCallSite(edge).getInstruction()->getParent());
+                if(SVFGEdge::isCallVFGEdgeKind(it->kind)) {
+                    vfCond = ComputeInterCallVFGGuard(nodeBB,succBB, getSVFG()->getCallSite(it->attr).getInstruction()->getParent());
                 }
-                else if(edge->isRetVFGEdge()) {
-                    vfCond = ComputeInterRetVFGGuard(nodeBB,succBB, getRetSite(edge).getInstruction()->getParent());
+                else if(SVFGEdge::isRetVFGEdgeKind(it->kind)) {
+                    vfCond = ComputeInterRetVFGGuard(nodeBB,succBB, getSVFG()->getCallSite(it->attr).getInstruction()->getParent());
                 }
                 else
                     vfCond = ComputeIntraVFGGuard(nodeBB,succBB);
@@ -189,6 +194,20 @@ std::string ProgSlice::evalFinalCond() const {
     return rawstr.str();
 }
 
+/*!
+ * The conditions of the other nodes stay with the worker manager, they are dropped
+ */
+void ProgSlice::transferCondsToMain() {
+    SVFGNodeToCondMap sinkConds;
+    for(SVFGNodeSetIter it = sinksBegin(), eit = sinksEnd(); it!=eit; ++it) {
+        SVFGNodeToCondMap::const_iterator cit = svfgNodeToCondMap.find(*it);
+        if(cit!=svfgNodeToCondMap.end())
+            sinkConds[*it] = pathAllocator->transferToMain(cit->second);
+    }
+    svfgNodeToCondMap.swap(sinkConds);
+    finalCond = pathAllocator->transferToMain(finalCond);
+}
+
 /*!
  * Annotate program paths according to the final path condition computed
  */
@@ -0,0 +1,119 @@
+//===- SourceBudget.cpp -- Analysis budget of one source---------------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * SourceBudget.cpp
+ */
+
+#include "SABER/SourceBudget.h"
+#include "SABER/Profiler.h"
+#include "Util/PathCondAllocator.h"
+#include <llvm/Support/CommandLine.h>
+
+using namespace llvm;
+
+static cl::opt<double> SrcTimeBudget("src-time-budget", cl::init(0),
+                                     cl::desc("Wall time (seconds) allowed for the analysis of one source (0: no limit)"));
+
+static cl::opt<unsigned> SrcNodeBudget("src-node-budget", cl::init(0),
+                                       cl::desc("Number of SVFG nodes visited for one source (0: no limit)"));
+
+static cl::opt<unsigned> SrcBddBudget("src-bdd-budget", cl::init(0),
+                                      cl::desc("Number of BDD nodes created for one source (0: no limit)"));
+
+extern Profiler* globalprofiler;
+
+SourceBudget::SourceBudget() :
+    maxTime(SrcTimeBudget), maxNodes(SrcNodeBudget), maxBddNodes(SrcBddBudget),
+    elapsed(0), visitedNodes(0), startBddNodes(0), bddNodes(0), stopped(true), exhausted(NotExhausted), bddLock(NULL) {
+}
+
+void SourceBudget::start() {
+    elapsed = 0;
+    visitedNodes = 0;
+    bddNodes = 0;
+    exhausted = NotExhausted;
+    resume();
+}
+
+void SourceBudget::resume() {
+    startTime = Clock::now();
+    startBddNodes = readBddNodes();
+    stopped = false;
+}
+
+void SourceBudget::stop() {
+    if (stopped)
+        return;
+    elapsed += std::chrono::duration<double>(Clock::now() - startTime).count();
+    u32_t curr = readBddNodes();
+    bddNodes += curr > startBddNodes ? curr - startBddNodes : 0;
+    stopped = true;
+}
+
+bool SourceBudget::check() {
+    if (maxTime > 0 && getElapsedTime() > maxTime)
+        exhausted = TimeExhausted;
+    else if (maxBddNodes != 0 && getBddNodes() > maxBddNodes)
+        exhausted = BddExhausted;
+    return exhausted == NotExhausted;
+}
+
+const char* SourceBudget::getExhaustReason() const {
+    switch (exhausted) {
+    case TimeExhausted:
+        return "time";
+    case NodeExhausted:
+        return "visited nodes";
+    case BddExhausted:
+        return "BDD nodes";
+    default:
+        return "none";
+    }
+}
+
+double SourceBudget::getElapsedTime() const {
+    if (stopped)
+        return elapsed;
+    return elapsed + std::chrono::duration<double>(Clock::now() - startTime).count();
+}
+
+/// The unique table of the BDD manager shrinks on garbage collection,
+/// so the number of created nodes is approximated by its growth
+u32_t SourceBudget::getBddNodes() const {
+    if (stopped)
+        return bddNodes;
+    u32_t curr = readBddNodes();
+    return bddNodes + (curr > startBddNodes ? curr - startBddNodes : 0);
+}
+
+u32_t SourceBudget::readBddNodes() const {
+    if (bddLock == NULL)
+        return PathCondAllocator::getBddNodeNum();
+    std::lock_guard<std::mutex> lock(*bddLock);
+    return PathCondAllocator::getBddNodeNum();
+}
+
+void SourceBudget::recordCost(const std::string& source) const {
+    if (globalprofiler)
+        globalprofiler->add_cost(source, getElapsedTime(), visitedNodes, getBddNodes());
+}
@@ -32,6 +32,11 @@
 #include "MSSA/SVFGStat.h"
 #include "Util/GraphUtil.h"
 #include "SABER/Profiler.h"
+#include "Util/ProcessShards.h"
+#include "Util/ByteCoder.h"
+#include "Util/ThreadPool.h"
+#include <deque>
+#include <future>
 
 using namespace llvm;
 
@@ -41,7 +46,57 @@ static cl::opt<bool> DumpSlice("dump-slice", cl::init(false),
 static cl::opt<unsigned> cxtLimit("cxtlimit",  cl::init(3),
                                   cl::desc("Source-Sink Analysis Contexts Limit"));
 
-void SrcSnkDDA::initialize(llvm::Module& module) {
+static cl::opt<bool> BDDStat("bdd-stat", cl::init(false),
+                             cl::desc("Print BDD and guard cache statistics"));
+
+static cl::opt<unsigned> Shards("shards", cl::init(0),
+                                cl::desc("Number of forked worker processes analyzing disjoint shards of the sources"));
+
+static cl::opt<unsigned> ShardTimeout("shard-timeout", cl::init(0),
+                                      cl::desc("Time limit (seconds) of one source in a worker process, the source is skipped on timeout (0: no limit)"));
+
+static cl::opt<unsigned> SliceJobs("slice-jobs", cl::init(1),
+                                   cl::desc("Number of slices traversed in parallel on the thread pool (see -nworkers), ignored with -shards"));
+
+static cl::opt<bool> SliceBddWorkers("slice-bdd-workers", cl::init(true),
+                                     cl::desc("Compute the guards of the slices on the pool threads with per-thread BDD managers (with -slice-jobs)"));
+
+extern Profiler* globalprofiler;
+
+SaberPreAnalysis* SaberPreAnalysis::sharedPreAnalysis = NULL;
+bool SrcSnkDDA::sharePreAnalysis = false;
+thread_local SrcSnkDDA::SliceContext* SrcSnkDDA::curContext = NULL;
+
+SaberPreAnalysis::~SaberPreAnalysis() {
+    if (svfg != NULL)
+        delete svfg;
+    svfg = NULL;
+
+    if (ptaCallGraph != NULL)
+        delete ptaCallGraph;
+    ptaCallGraph = NULL;
+
+    if(pathCondAllocator)
+        delete pathCondAllocator;
+    pathCondAllocator = NULL;
+}
+
+/*!
+ * Report the slabs and objects of a graph arena
+ */
+static void addArenaCounters(Profiler& profiler, const std::string& graph, const GraphArena& arena) {
+    profiler.add_counter(graph + " arena slab bytes", arena.getSlabBytes());
+    profiler.add_counter(graph + " arena objects", arena.getAllocatedNum());
+    profiler.add_counter(graph + " arena recycled objects", arena.getRecycledNum());
+}
+
+/*!
+ * Build the SVFG and allocate the branch conditions
+ */
+void SaberPreAnalysis::build(llvm::Module& module) {
+    if (isBuilt())
+        return;
+
     Profiler TimeMemProfiler(Profiler::TIME | Profiler::MEMORY);
 
     llvm::errs() << "==---------Start Pre-analysis---------==\n";
@@ -51,84 +106,342 @@ void SrcSnkDDA::initialize(llvm::Module& module) {
     ptaCallGraph = new PTACallGraph(&module);
     AndersenWaveDiff* ander = AndersenWaveDiff::createAndersenWaveDiff(module);
 
+    TimeMemProfiler.create_snapshot();
+    TimeMemProfiler.print_snapshot_result("PTA-Building");
+    TimeMemProfiler.reset();
+
     time(&CurrTime);
     double TimeElapsed = difftime(CurrTime, StartTime);
-    llvm::errs() << "PTA @ Pre-analysis: " << TimeElapsed << "s\n";
+    /// with -ander-cache, repeated runs on the same module load the points-to results instead of solving
+    llvm::errs() << "PTA @ Pre-analysis" << (ander->isReadFromCache() ? " (cached)" : "") << ": " << TimeElapsed << "s\n";
 
     svfg =  memSSA.buildSVFG(ander);
-    setGraph(memSSA.getSVFG());
+    /// the checkers only read the SVFG from here on, traverse it over a CSR layout
+    svfg->freeze();
     //AndersenWaveDiff::releaseAndersenWaveDiff();
     /// allocate control-flow graph branch conditions
-    getPathAllocator()->allocate(module);
+    pathCondAllocator->allocate(module);
 
     time(&CurrTime);
     TimeElapsed = difftime(CurrTime, StartTime);
     llvm::errs() << "SVFG @ Pre-analysis: " << TimeElapsed << "s\n";
 
+    TimeMemProfiler.create_snapshot();
+    TimeMemProfiler.print_snapshot_result("FSVFG-Building");
+    TimeMemProfiler.print_peak_rss();
+
+    /// the graph arenas, compare with -graph-arena=false
+    addArenaCounters(TimeMemProfiler, "PAG", PAG::getPAG()->getArena());
+    addArenaCounters(TimeMemProfiler, "ConstraintGraph", ander->getConstraintGraph()->getArena());
+    addArenaCounters(TimeMemProfiler, "SVFG", svfg->getArena());
+    TimeMemProfiler.print_counters();
+}
+
+void SrcSnkDDA::initialize(llvm::Module& module) {
+    if (sharePreAnalysis) {
+        preAnalysis = SaberPreAnalysis::getSharedPreAnalysis();
+        ownPreAnalysis = false;
+    }
+    else {
+        preAnalysis = new SaberPreAnalysis();
+        ownPreAnalysis = true;
+    }
+    preAnalysis->build(module);
+    setGraph(preAnalysis->getSVFG());
+
+    time_t StartTime, CurrTime;
+    time(&StartTime);
+
     initSrcs();
     initSnks();
 
     time(&CurrTime);
-    TimeElapsed = difftime(CurrTime, StartTime);
-    llvm::errs() << "Pre-analysis: " << TimeElapsed << "s\n";
+    double TimeElapsed = difftime(CurrTime, StartTime);
+    llvm::errs() << "Sources and sinks @ Pre-analysis: " << TimeElapsed << "s\n";
 
     ContextCond::setMaxCxtLen(cxtLimit);
-
-    TimeMemProfiler.create_snapshot();
-    TimeMemProfiler.print_snapshot_result("FSVFG-Building");
 }
 
 void SrcSnkDDA::analyze(llvm::Module& module) {
     initialize(module);
 
-    for (SVFGNodeSetIter iter = sourcesBegin(), eiter = sourcesEnd();
-            iter != eiter; ++iter) {
-        setCurSlice(*iter);
+    std::vector<const SVFGNode*> srcs(sourcesBegin(), sourcesEnd());
+    if (SliceJobs > 1 && !isSharded()) {
+        analyzeSourcesInParallel(srcs);
+    }
+    else {
+        analyzeSources(srcs, [this](const SVFGNode* src, std::string&) {
+            analyzeSource(src);
+            return 0u;
+        });
+    }
+
+    finalize();
+}
 
-        DBOUT(DGENERAL, outs() << "Analysing slice:" << (*iter)->getId() << ")\n");
-        ContextCond cxt;
-        DPIm item((*iter)->getId(),cxt);
-        forwardTraverse(item);
+/*!
+ * The slices are traversed on the thread pool, at most -slice-jobs of them at a time.
+ * With -slice-bdd-workers, the pool threads also compute the guards on their own BDD
+ * managers and transfer the results to the main manager, otherwise this thread computes
+ * the guards. This thread reports the bugs in the source order, so that the output is
+ * the same as the one of the serial analysis.
+ */
+void SrcSnkDDA::analyzeSourcesInParallel(const std::vector<const SVFGNode*>& srcs) {
+    std::deque<std::future<SliceContext*> > traversals;
+    u32_t next = 0;
+    auto enqueueNext = [this, &srcs, &traversals, &next]() {
+        const SVFGNode* src = srcs[next++];
+        traversals.push_back(ThreadPool::getThreadPool()->enqueue([this, src]() {
+            PathCondAllocator* pa = getPathAllocator();
+            if (SliceBddWorkers)
+                pa->attachWorker();
+
+            SliceContext* cxt = createContext(src);
+            /// without a worker manager, the budget reads the main manager this thread is checking
+            if (!SliceBddWorkers)
+                cxt->budget.setBddLock(&PathCondAllocator::getMainCondMutex());
+            setCurContext(cxt);
+            traverseSlice();
+            if (SliceBddWorkers) {
+                solveSlice();
+                getCurSlice()->transferCondsToMain();
+            }
+            setCurContext(NULL);
+            /// the main thread checks the slice holding the lock
+            cxt->budget.setBddLock(NULL);
+
+            if (SliceBddWorkers)
+                pa->detachWorker();
+            return cxt;
+        }));
+    };
+
+    while (next < srcs.size() && traversals.size() < SliceJobs)
+        enqueueNext();
+
+    while (!traversals.empty()) {
+        SliceContext* cxt = traversals.front().get();
+        traversals.pop_front();
+        if (next < srcs.size())
+            enqueueNext();
+
+        /// the workers may transfer their results to the main manager meanwhile
+        std::lock_guard<std::mutex> lock(PathCondAllocator::getMainCondMutex());
+        setCurContext(cxt);
+        checkSlice();
+        setCurContext(NULL);
+        delete cxt;
+    }
+}
 
-        /// do not consider there is bug when reaching a global SVFGNode
-        /// if we touch a global, then we assume the client uses this memory until the program exits.
-        if (getCurSlice()->isReachGlobal()) {
-            DBOUT(DSaber, outs() << "Forward analysis reaches globals for slice:" << (*iter)->getId() << ")\n");
+/*!
+ * Run func on the sources, in forked worker processes if -shards is set
+ * (see ProcessShards). The bug counts returned by func are summed up.
+ * A worker also hands back the profiler counters and costs of each source,
+ * which are merged here with the data of the source handed to replay.
+ */
+u32_t SrcSnkDDA::analyzeSources(const std::vector<const SVFGNode*>& srcs, SourceFunc func, ReplayFunc replay) {
+    if (isSharded()) {
+        ProcessShards shards(Shards, ShardTimeout);
+        u32_t bugNum = shards.run(srcs.size(), [&srcs, &func](u32_t i, std::string& data) {
+            /// only hand back the records of this source, not the ones copied from the parent
+            if (globalprofiler)
+                globalprofiler->clear_records();
+            std::string srcData;
+            u64_t num = func(srcs[i], srcData);
+
+            std::string records;
+            if (globalprofiler)
+                globalprofiler->save_records(records);
+            ByteCoder::putString(data, records);
+            ByteCoder::putString(data, srcData);
+            return num;
+        });
+        shards.printResults();
+
+        for (const ProcessShards::ShardStat& stat : shards.getShardStats()) {
+            for (u32_t i : stat.timedOutItems)
+                outs() << "\t Source timed out: " << srcs[i]->getId() << "\n";
+            for (u32_t i : stat.crashedItems)
+                outs() << "\t Source crashed: " << srcs[i]->getId() << "\n";
         }
-        else {
-            DBOUT(DSaber, outs() << "Forward process for slice:" << (*iter)->getId() << " (size = " << getCurSlice()->getForwardSliceSize() << ")\n");
-
-            for (SVFGNodeSetIter sit = getCurSlice()->sinksBegin(), esit =
-                        getCurSlice()->sinksEnd(); sit != esit; ++sit) {
-                ContextCond cxt;
-                DPIm item((*sit)->getId(),cxt);
-                backwardTraverse(item);
-            }
 
-            DBOUT(DSaber, outs() << "Backward process for slice:" << (*iter)->getId() << " (size = " << getCurSlice()->getBackwardSliceSize() << ")\n");
+        for (u32_t i = 0; i < srcs.size(); ++i) {
+            const std::string& data = shards.getItemData(i);
+            size_t pos = 0;
+            std::string records, srcData;
+            if (!ByteCoder::getString(data, pos, records) || !ByteCoder::getString(data, pos, srcData))
+                continue;
+            if (globalprofiler)
+                globalprofiler->load_records(records);
+            if (replay)
+                replay(srcs[i], srcData);
+        }
+        return bugNum;
+    }
 
-            AllPathReachability();
+    u32_t bugNum = 0;
+    for (const SVFGNode* src : srcs) {
+        std::string srcData;
+        bugNum += func(src, srcData);
+        if (replay)
+            replay(src, srcData);
+    }
+    return bugNum;
+}
 
-            DBOUT(DSaber, outs() << "Guard computation for slice:" << (*iter)->getId() << ")\n");
+bool SrcSnkDDA::isSharded() const {
+    return Shards > 1;
+}
+
+/*!
+ * Compute the slice of a source and report its bugs
+ */
+void SrcSnkDDA::analyzeSource(const SVFGNode* src) {
+    SliceContext* cxt = createContext(src);
+    setCurContext(cxt);
+    traverseSlice();
+    checkSlice();
+    setCurContext(NULL);
+    delete cxt;
+}
+
+/*!
+ * Forward traverse the slice from the source to the sinks, then backward from the sinks.
+ * The traversals only use the context of the source and read the SVFG.
+ */
+void SrcSnkDDA::traverseSlice() {
+    const SVFGNode* src = getCurSlice()->getSource();
+    getCurBudget().start();
+
+    DBOUT(DGENERAL, outs() << "Analysing slice:" << src->getId() << ")\n");
+    ContextCond cxt;
+    DPIm item(src->getId(),cxt);
+    forwardTraverse(item);
+
+    /// do not consider there is bug when reaching a global SVFGNode
+    /// if we touch a global, then we assume the client uses this memory until the program exits.
+    if (getCurSlice()->isReachGlobal()) {
+        DBOUT(DSaber, outs() << "Forward analysis reaches globals for slice:" << src->getId() << ")\n");
+    }
+    else {
+        DBOUT(DSaber, outs() << "Forward process for slice:" << src->getId() << " (size = " << getCurSlice()->getForwardSliceSize() << ")\n");
+
+        for (SVFGNodeSetIter sit = getCurSlice()->sinksBegin(), esit =
+                    getCurSlice()->sinksEnd(); sit != esit; ++sit) {
+            ContextCond cxt;
+            DPIm item((*sit)->getId(),cxt);
+            backwardTraverse(item);
         }
 
-        reportBug(getCurSlice());
+        DBOUT(DSaber, outs() << "Backward process for slice:" << src->getId() << " (size = " << getCurSlice()->getBackwardSliceSize() << ")\n");
     }
 
-    finalize();
+    /// the visited items are not needed by the guard computation,
+    /// once they are gone no item refers to the contexts interned by this thread
+    clearVisitedMap();
+    ContextCond::resetCxtTrie();
+    getCurBudget().stop();
 }
 
+/*!
+ * Compute the guards of the traversed slice
+ */
+void SrcSnkDDA::solveSlice() {
+    SliceContext* cxt = getCurContext();
+    cxt->budget.resume();
+
+    if (!getCurSlice()->isReachGlobal() && !cxt->budget.isExhausted()) {
+        AllPathReachability();
+        cxt->guarded = true;
+        DBOUT(DSaber, outs() << "Guard computation for slice:" << getCurSlice()->getSource()->getId() << ")\n");
+    }
+
+    cxt->budget.stop();
+    cxt->solved = true;
+}
+
+/*!
+ * Report the bugs of the slice, its guards are computed first if they are not yet
+ */
+void SrcSnkDDA::checkSlice() {
+    if (!getCurContext()->solved)
+        solveSlice();
+
+    /// annotate SVFG with slice information for debugging purpose
+    if (DumpSlice && getCurContext()->guarded)
+        annotateSlice(getCurSlice());
+
+    const SVFGNode* src = getCurSlice()->getSource();
+    SourceBudget& budget = getCurBudget();
+    std::string srcName = "src " + std::to_string(src->getId());
+    if (const Value* val = getCurSlice()->getLLVMValue(src))
+        srcName += " " + analysisUtil::getSourceLoc(val);
+
+    /// a slice cut by the budget is incomplete, its conditions cannot be used to report bugs
+    if (budget.isExhausted())
+        outs() << "Out of budget (" << budget.getExhaustReason() << "): " << srcName << "\n";
+    else
+        reportBug(getCurSlice());
+
+    budget.recordCost(srcName);
+}
+
+
+void SrcSnkDDA::finalize() {
+    dumpSlices();
+
+    if(BDDStat)
+        printBDDStat();
+}
+
+/*!
+ * Forward traverse from item over the out edge records of the frozen SVFG
+ */
+void SrcSnkDDA::forwardTraverse(DPIm& it) {
+    const SVFG::SVFGCSR* csr = getSVFG()->getCSR();
+    pushIntoWorklist(it);
+
+    while (!isWorklistEmpty()) {
+        DPIm item = popFromWorklist();
+        forwardProcess(item);
+
+        NodeID id = getNodeIDFromItem(item);
+        for (SVFG::SVFGCSR::const_iterator eit = csr->outBegin(id), eeit = csr->outEnd(id); eit != eeit; ++eit)
+            forwardpropagate(item, *eit);
+    }
+}
+
+/*!
+ * Backward traverse from item over the in edge records of the frozen SVFG
+ */
+void SrcSnkDDA::backwardTraverse(DPIm& it) {
+    const SVFG::SVFGCSR* csr = getSVFG()->getCSR();
+    pushIntoWorklist(it);
+
+    while (!isWorklistEmpty()) {
+        DPIm item = popFromWorklist();
+        backwardProcess(item);
+
+        NodeID id = getNodeIDFromItem(item);
+        for (SVFG::SVFGCSR::const_iterator eit = csr->inBegin(id), eeit = csr->inEnd(id); eit != eeit; ++eit)
+            backwardpropagate(item, *eit);
+    }
+}
 
 /*!
  * Propagate information forward by matching context
  */
-void SrcSnkDDA::forwardpropagate(const DPIm& item, SVFGEdge* edge) {
-    DBOUT(DSaber,outs() << "\n##processing source: " << getCurSlice()->getSource()->getId() <<" forward propagate from (" << edge->getSrcID());
+void SrcSnkDDA::forwardpropagate(const DPIm& item, const SVFG::SVFGCSREdge& rec) {
+    if (!getCurBudget().visit())
+        return;
+
+    DBOUT(DSaber,outs() << "\n##processing source: " << getCurSlice()->getSource()->getId() <<" forward propagate from (" << rec.edge->getSrcID());
 
     // for indirect SVFGEdge, the propagation should follow the def-use chains
     // points-to on the edge indicate whether the object of source node can be propagated
 
-    const SVFGNode* dstNode = edge->getDstNode();
+    const SVFGNode* dstNode = rec.node;
     DPIm newItem(dstNode->getId(),item.getContexts());
 
     /// handle globals here
@@ -139,25 +452,16 @@ void SrcSnkDDA::forwardpropagate(const DPIm& item, SVFGEdge* edge) {
 
 
     /// perform context sensitive reachability
+    /// the call site ID of a call/ret edge is inlined in its record
     // push context for calling
-    if (edge->isCallVFGEdge()) {
-        CallSiteID csId = 0;
-        if(const CallDirSVFGEdge* callEdge = dyn_cast<CallDirSVFGEdge>(edge))
-            csId = callEdge->getCallSiteId();
-        else
-            csId = cast<CallIndSVFGEdge>(edge)->getCallSiteId();
-
+    if (SVFGEdge::isCallVFGEdgeKind(rec.kind)) {
+        CallSiteID csId = rec.attr;
         newItem.pushContext(csId);
         DBOUT(DSaber, outs() << " push cxt [" << csId << "] ");
     }
     // match context for return
-    else if (edge->isRetVFGEdge()) {
-        CallSiteID csId = 0;
-        if(const RetDirSVFGEdge* callEdge = dyn_cast<RetDirSVFGEdge>(edge))
-            csId = callEdge->getCallSiteId();
-        else
-            csId = cast<RetIndSVFGEdge>(edge)->getCallSiteId();
-
+    else if (SVFGEdge::isRetVFGEdgeKind(rec.kind)) {
+        CallSiteID csId = rec.attr;
         if (newItem.matchContext(csId) == false) {
             DBOUT(DSaber, outs() << "-|-\n");
             return;
@@ -174,17 +478,17 @@ void SrcSnkDDA::forwardpropagate(const DPIm& item, SVFGEdge* edge) {
         addForwardVisited(dstNode, newItem);
 
     if(pushIntoWorklist(newItem))
-        DBOUT(DSaber,outs() << " --> " << edge->getDstID() << ", cxt size: " << newItem.getContexts().cxtSize() <<")\n");
+        DBOUT(DSaber,outs() << " --> " << dstNode->getId() << ", cxt size: " << newItem.getContexts().cxtSize() <<")\n");
 
 }
 
 /*!
  * Propagate information backward without matching context, as forward analysis already did it
  */
-void SrcSnkDDA::backwardpropagate(const DPIm& item, SVFGEdge* edge) {
-    DBOUT(DSaber,outs() << "backward propagate from (" << edge->getDstID() << " --> " << edge->getSrcID() << ")\n");
-    const SVFGNode* srcNode = edge->getSrcNode();
-    if(backwardVisited(srcNode))
+void SrcSnkDDA::backwardpropagate(const DPIm& item, const SVFG::SVFGCSREdge& rec) {
+    DBOUT(DSaber,outs() << "backward propagate from (" << rec.edge->getDstID() << " --> " << rec.edge->getSrcID() << ")\n");
+    const SVFGNode* srcNode = rec.node;
+    if(backwardVisited(srcNode) || !getCurBudget().visit())
         return;
     else
         addBackwardVisited(srcNode);
@@ -196,25 +500,15 @@ void SrcSnkDDA::backwardpropagate(const DPIm& item, SVFGEdge* edge) {
 
 /// Guarded reachability search
 void SrcSnkDDA::AllPathReachability() {
-    /// annotate SVFG with slice information for debugging purpose
-    if(DumpSlice)
-        annotateSlice(_curSlice);
+    getCurSlice()->AllPathReachableSolve();
 
-    _curSlice->AllPathReachableSolve();
-
-    if(isSatisfiableForAll(_curSlice)== true)
-        _curSlice->setAllReachable();
+    if(isSatisfiableForAll(getCurSlice())== true)
+        getCurSlice()->setAllReachable();
 }
 
-/// Set current slice
-void SrcSnkDDA::setCurSlice(const SVFGNode* src) {
-    if(_curSlice!=NULL) {
-        delete _curSlice;
-        _curSlice = NULL;
-        clearVisitedMap();
-    }
-
-    _curSlice = new ProgSlice(src,getPathAllocator(), getSVFG());
+/// Create the context of a source with an empty slice
+SrcSnkDDA::SliceContext* SrcSnkDDA::createContext(const SVFGNode* src) {
+    return new SliceContext(new ProgSlice(src,getPathAllocator(), getSVFG()));
 }
 
 void SrcSnkDDA::annotateSlice(ProgSlice* slice) {
@@ -238,4 +532,6 @@ void SrcSnkDDA::printBDDStat() {
     outs() << "BDD Mem usage: " << PathCondAllocator::getMemUsage() << "\n";
     outs() << "BDD Number: " << PathCondAllocator::getCondNum() << "\n";
     outs() << "BDD max live number: " << PathCondAllocator::getMaxLiveCondNumber() << "\n";
+    getPathAllocator()->printBddManagerStat();
+    getPathAllocator()->printGuardCacheStat();
 }
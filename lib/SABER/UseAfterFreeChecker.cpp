@@ -32,6 +32,11 @@
 #include "SABER/Profiler.h"
 #include "SABER/UseAfterFreeChecker.h"
 #include "Util/AnalysisUtil.h"
+#include "Util/ProcessShards.h"
+#include "Util/ByteCoder.h"
+#include "Util/ThreadPool.h"
+
+#include <atomic>
 
 #define DEBUG_TYPE "uaf"
 
@@ -51,6 +56,18 @@ static cl::opt<bool> Nocheck("no-check", cl::init(false),
 static cl::opt<bool> IgnoreGlobal("no-global", cl::init(false),
                                    cl::desc("Validate memory leak tests"));
 
+static cl::opt<bool> UAFSummary("uaf-summary", cl::init(false),
+                                cl::desc("Memoize the use sites reached by each sub-search of a deallocation source"));
+
+static cl::opt<unsigned> UAFSummaryLimit("uaf-summary-limit", cl::init(10000),
+                                         cl::desc("Maximum number of use sites kept in one value-flow summary"));
+
+static cl::opt<unsigned> UAFJobs("uaf-jobs", cl::init(1),
+                                 cl::desc("Number of deallocation sources searched in parallel on the thread pool (see -nworkers), ignored with -shards"));
+
+static cl::opt<bool> UAFInterProcReach("uaf-ip-reach", cl::init(true),
+                                       cl::desc("Check the reachability from a free site to a use across functions on the call graph"));
+
 unsigned Index = 0;
 
 extern Profiler* globalprofiler;
@@ -93,19 +110,50 @@ bool UseAfterFreeChecker::runOnModule(llvm::Module& M) {
     CFGR = &this->getAnalysis<CFGReachabilityAnalysis>();
     initialize(M);
 
-    for (SVFGNodeSetIter It = sourcesBegin(), E = sourcesEnd(); It != E; ++It) {
-        const ActualParmSVFGNode* Src = dyn_cast<ActualParmSVFGNode>(*It);
-        assert(Src);
-
-        std::vector<const SVFGEdge*> Ctx;
-        Ctx.push_back(SrcToCallEdgeMap[Src]);
-
-
-        DEBUG(errs() << "Start.... " << Src->getId() << "\n");
-
-        push();
-        searchBackward(Src, nullptr, nullptr, Ctx);
-        pop();
+    if (UAFInterProcReach.getValue())
+        IPR = new InterProcReachability(getSVFG()->getPTACallGraph(), CFGR);
+
+    std::vector<const SVFGNode*> Srcs(sourcesBegin(), sourcesEnd());
+    std::vector<SearchState> States(Srcs.size());
+
+    if (isSharded()) {
+        /// Each worker process searches its sources and hands their reports back,
+        /// the parent numbers and prints them in the source order (-uaf-jobs is ignored by the workers)
+        analyzeSources(Srcs, [this](const SVFGNode* Src, std::string& Data) {
+            SearchState S;
+            searchSource(Src, S);
+            recordSource(S);
+            packReports(S, Data);
+            return S.Reports.size() + S.NumReports;
+        }, [this](const SVFGNode* Src, const std::string& Data) {
+            SearchState S;
+            unpackReports(S, Data);
+            printReports(S);
+        });
+    } else if (UAFJobs.getValue() > 1) {
+        /// Each job is a lane on the thread pool pulling the next unsearched source.
+        /// Reports are buffered per source and flushed in the source order afterwards,
+        /// so that the output is the same as the one of the serial search.
+        std::atomic<size_t> Next(0);
+        std::vector<std::future<void>> Jobs;
+        for (unsigned J = 0; J < UAFJobs.getValue(); ++J) {
+            Jobs.push_back(ThreadPool::getThreadPool()->enqueue([this, &Srcs, &States, &Next]() {
+                for (size_t I = Next++; I < Srcs.size(); I = Next++) {
+                    searchSource(Srcs[I], States[I]);
+                }
+            }));
+        }
+        for (auto& Job : Jobs) {
+            Job.get();
+        }
+        for (auto& S : States) {
+            flushReports(S);
+        }
+    } else {
+        for (size_t I = 0; I < Srcs.size(); ++I) {
+            searchSource(Srcs[I], States[I]);
+            flushReports(States[I]);
+        }
     }
 
     finalize();
@@ -116,53 +164,241 @@ bool UseAfterFreeChecker::runOnModule(llvm::Module& M) {
     return false;
 }
 
-void UseAfterFreeChecker::searchBackward(const SVFGNode* CurrNode, const SVFGNode* PrevNode, const SVFGEdge* E,
-        std::vector<const SVFGEdge*> Ctx) {
-    if (Ctx.size() > ContextCond::getMaxCxtLen() + 1) {
-        return;
+void UseAfterFreeChecker::searchSource(const SVFGNode* Node, SearchState& S) {
+    const ActualParmSVFGNode* Src = dyn_cast<ActualParmSVFGNode>(Node);
+    assert(Src);
+
+    auto It = SrcToCallEdgeMap.find(Src);
+    assert(It != SrcToCallEdgeMap.end() && "no callsite edge for this source?");
+
+    CxtStackID Ctx = S.CxtTrie.push(CxtStackTrie::EmptyStack, getCSID(It->second), true);
+
+    DEBUG(errs() << "Start.... " << Src->getId() << "\n");
+
+    S.SourceName = "free " + std::to_string(Src->getId()) + " " + getSourceLoc(Src->getCallSite().getInstruction());
+    /// the other sources may compute conditions on the BDD manager meanwhile
+    S.Budget.setBddLock(&CondMutex);
+    S.Budget.start();
+
+    push(S);
+    searchBackward(S, Src, nullptr, nullptr, Ctx);
+    pop(S);
+
+    S.Budget.stop();
+
+    /// summaries are only valid for the free site of this source
+    assert(S.Recorders.empty() && "unfinished value-flow summary?");
+    S.Summaries.clear();
+    S.CxtTrie.reset();
+}
+
+/*!
+ * Record the statistics of a searched source, then print its buffered reports
+ */
+void UseAfterFreeChecker::flushReports(SearchState& S) {
+    recordSource(S);
+    printReports(S);
+}
+
+/*!
+ * Record the cost and the counters of a searched source in the profiler
+ */
+void UseAfterFreeChecker::recordSource(SearchState& S) {
+    /// the reports found before the budget is exhausted are kept
+    if (S.Budget.isExhausted()) {
+        S.OutOfBudget = S.Budget.getExhaustReason();
+        if (globalprofiler)
+            globalprofiler->add_counter("UAF sources out of budget", 1);
     }
+    S.Budget.recordCost(S.SourceName);
 
-    DEBUG(errs() << "Visiting[b] " << getSVFGNodeMsg(CurrNode)<< "\n");
+    if (UAFSummary.getValue() && globalprofiler) {
+        globalprofiler->add_counter("UAF summary hits", S.SummaryHits);
+        globalprofiler->add_counter("UAF summary misses", S.SummaryMisses);
+    }
+    S.SummaryHits = 0;
+    S.SummaryMisses = 0;
+}
+
+/*!
+ * Print the buffered reports of a source and count them in the global index
+ */
+void UseAfterFreeChecker::printReports(SearchState& S) {
+    if (!S.OutOfBudget.empty())
+        outs() << "Out of budget (" << S.OutOfBudget << "): " << S.SourceName << "\n";
 
-    SVFGPath.add(CurrNode);
+    for (auto& Report : S.Reports) {
+        outs() << "+++++" << ++Index << "+++++\n";
+        outs() << Report;
+    }
+    if (ReportNumOnly.getValue()) {
+        Index += S.NumReports;
+    }
+    S.Reports.clear();
+    S.NumReports = 0;
+}
+
+/*!
+ * Pack the reports of a source searched by a worker process, to be printed by the parent
+ */
+void UseAfterFreeChecker::packReports(const SearchState& S, std::string& Data) {
+    ByteCoder::putString(Data, S.SourceName);
+    ByteCoder::putString(Data, S.OutOfBudget);
+    ByteCoder::putU64(Data, S.NumReports);
+    ByteCoder::putU64(Data, S.Reports.size());
+    for (auto& Report : S.Reports) {
+        ByteCoder::putString(Data, Report);
+    }
+}
 
-    bool AllCalls = true;
-    for (size_t I = 0; I < Ctx.size(); ++I) {
-        if (!Ctx[I]->isCallVFGEdge()) {
-            AllCalls = false;
+void UseAfterFreeChecker::unpackReports(SearchState& S, const std::string& Data) {
+    size_t Pos = 0;
+    u64_t NumReports = 0, ReportNum = 0;
+    ByteCoder::getString(Data, Pos, S.SourceName);
+    ByteCoder::getString(Data, Pos, S.OutOfBudget);
+    ByteCoder::getU64(Data, Pos, NumReports);
+    ByteCoder::getU64(Data, Pos, ReportNum);
+    S.NumReports = NumReports;
+    for (u64_t I = 0; I < ReportNum; ++I) {
+        std::string Report;
+        if (!ByteCoder::getString(Data, Pos, Report))
             break;
+        S.Reports.push_back(std::move(Report));
+    }
+}
+
+/*!
+ * Summary key of the sub-search starting from Node, the interned context stack
+ * identifies the (call site ID, call or return) sequence. FreeCS is the call site
+ * freeing the object of a forward sub-search, the uses it reports must be reachable from it.
+ */
+UseAfterFreeChecker::SummaryKey UseAfterFreeChecker::getSummaryKey(const SVFGNode* Node, const SVFGNode* Prev,
+        CxtStackID Ctx, SummaryKind Kind, const Instruction* FreeCS) {
+    assert((Kind == BackwardSearch) == (FreeCS == NULL) && "only a forward sub-search has a free call site");
+    SummaryKey Key;
+    Key.Node = Node;
+    Key.Prev = Prev;
+    Key.Ctx = Ctx;
+    Key.Kind = Kind;
+    Key.FreeCS = FreeCS;
+    return Key;
+}
+
+/*!
+ * Replay the use sites of an already summarized sub-search, return false if it is not summarized
+ */
+bool UseAfterFreeChecker::replaySummary(SearchState& S, const SummaryKey& Key) {
+    auto It = S.Summaries.find(Key);
+    if (It == S.Summaries.end()) {
+        S.SummaryMisses++;
+        return false;
+    }
+
+    S.SummaryHits++;
+    for (auto& Hit : It->second) {
+        push(S);
+        for (auto* N : Hit.Suffix) {
+            S.SVFGPath.add(N);
         }
+        visitUse(S, Hit.User);
+        pop(S);
     }
-    if (AllCalls) {
-        push();
-        std::vector<const SVFGEdge*> FCtx;
-
-        assert(!Ctx.empty());
-        //assert(isa<CallDirSVFGEdge>(Ctx.back()));
-        CallSiteID XCSID;
-        if (auto* X = dyn_cast<CallDirSVFGEdge>(Ctx.back())) {
-            XCSID = X->getCallSiteId();
-        } else if (auto* Y = dyn_cast<CallIndSVFGEdge>(Ctx.back())) {
-            XCSID = Y->getCallSiteId();
-        } else {
-            assert(false);
+    return true;
+}
+
+/*!
+ * Start recording the use sites reached by a sub-search
+ */
+void UseAfterFreeChecker::beginSummary(SearchState& S, const SummaryKey& Key) {
+    SummaryRecorder R;
+    R.Key = Key;
+    R.Depth = S.SVFGPath.size();
+    R.Overflow = false;
+    S.Recorders.push_back(std::move(R));
+}
+
+/*!
+ * Finish the innermost sub-search and cache its summary
+ */
+void UseAfterFreeChecker::endSummary(SearchState& S) {
+    assert(!S.Recorders.empty() && "no value-flow summary is being recorded?");
+    SummaryRecorder& R = S.Recorders.back();
+    if (!R.Overflow) {
+        S.Summaries[R.Key] = std::move(R.Hits);
+    }
+    S.Recorders.pop_back();
+}
+
+/*!
+ * The freed pointer is used by User at the end of the current path
+ */
+void UseAfterFreeChecker::visitUse(SearchState& S, const Instruction* User) {
+    auto& Path = S.SVFGPath.getCacheVector();
+    for (auto& R : S.Recorders) {
+        if (R.Overflow) {
+            continue;
         }
-        searchForward(CurrNode, PrevNode, E, FCtx,
+        if (R.Hits.size() >= UAFSummaryLimit.getValue()) {
+            R.Overflow = true;
+            R.Hits.clear();
+            continue;
+        }
+        SummaryHit Hit;
+        Hit.Suffix.assign(Path.begin() + R.Depth, Path.end());
+        Hit.User = User;
+        R.Hits.push_back(std::move(Hit));
+    }
+
+    push(S);
+    if(check(S, User)) {
+        reportBug(S, User);
+    }
+    pop(S);
+}
+
+void UseAfterFreeChecker::searchBackward(SearchState& S, const SVFGNode* CurrNode, const SVFGNode* PrevNode, const SVFGEdge* E,
+        CxtStackID Ctx) {
+    if (S.CxtTrie.size(Ctx) > ContextCond::getMaxCxtLen() + 1) {
+        return;
+    }
+
+    if (!S.Budget.visit()) {
+        return;
+    }
+
+    DEBUG(errs() << "Visiting[b] " << getSVFGNodeMsg(CurrNode)<< "\n");
+
+    if (UAFSummary.getValue()) {
+        SummaryKey Key = getSummaryKey(CurrNode, PrevNode, Ctx, BackwardSearch, NULL);
+        if (replaySummary(S, Key))
+            return;
+        beginSummary(S, Key);
+    }
+
+    S.SVFGPath.add(CurrNode);
+
+    if (S.CxtTrie.isAllCalls(Ctx)) {
+        push(S);
+
+        assert(!S.CxtTrie.empty(Ctx));
+        CallSiteID XCSID = S.CxtTrie.top(Ctx);
+        searchForward(S, CurrNode, PrevNode, E, CxtStackTrie::EmptyStack,
                 getSVFG()->getCallSite(XCSID).getInstruction(), true);
-        pop();
+        pop(S);
     }
 
-    auto& InEdges = CurrNode->getInEdges();
-    for(auto It = InEdges.begin(), E = InEdges.end(); It != E; ++It) {
-        auto InEdge = *It;
-        SVFGNode* Ancestor = InEdge->getSrcNode();
+    /// the SVFG is frozen by the pre-analysis, the records carry the call sites
+    const SVFG::SVFGCSR* CSR = getSVFG()->getCSR();
+    for(auto It = CSR->inBegin(CurrNode->getId()), E = CSR->inEnd(CurrNode->getId()); It != E; ++It) {
+        SVFGEdge* InEdge = It->edge;
+        SVFGNode* Ancestor = It->node;
         //assert(Ancestor != CurrNode);
         if (Ancestor == CurrNode || !Ancestor->getBB())
             continue;
 
-        if (InEdge->isCallVFGEdge() || InEdge->isRetVFGEdge()) {
-            bool match = matchContextB(Ctx, InEdge);
-            DEBUG_WITH_TYPE("bctx", printContextStack(Ctx));
+        if (SVFGEdge::isCallVFGEdgeKind(It->kind) || SVFGEdge::isRetVFGEdgeKind(It->kind)) {
+            bool match = matchContextB(S.CxtTrie, Ctx, *It);
+            DEBUG_WITH_TYPE("bctx", printContextStack(S.CxtTrie, Ctx));
             if (!match) {
                 continue;
             }
@@ -170,21 +406,35 @@ void UseAfterFreeChecker::searchBackward(const SVFGNode* CurrNode, const SVFGNod
             continue;
         }
 
-        push();
-        searchBackward(Ancestor, CurrNode, InEdge, Ctx);
-        pop();
+        push(S);
+        searchBackward(S, Ancestor, CurrNode, InEdge, Ctx);
+        pop(S);
     }
+
+    if (UAFSummary.getValue())
+        endSummary(S);
 }
 
-void UseAfterFreeChecker::searchForward(const SVFGNode* CurrNode, const SVFGNode* PrevNode, const SVFGEdge* E,
-        std::vector<const SVFGEdge*> Ctx, Instruction* CS, bool TagX) {
-    if (Ctx.size() > ContextCond::getMaxCxtLen()) {
+void UseAfterFreeChecker::searchForward(SearchState& S, const SVFGNode* CurrNode, const SVFGNode* PrevNode, const SVFGEdge* E,
+        CxtStackID Ctx, Instruction* CS, bool TagX) {
+    if (S.CxtTrie.size(Ctx) > ContextCond::getMaxCxtLen()) {
+        return;
+    }
+
+    if (!S.Budget.visit()) {
         return;
     }
 
     DEBUG(errs() << "Visiting[f] " << getSVFGNodeMsg(CurrNode)<< "\n");
 
-    SVFGPath.add(CurrNode);
+    if (UAFSummary.getValue()) {
+        SummaryKey Key = getSummaryKey(CurrNode, PrevNode, Ctx, TagX ? TaggedForwardSearch : ForwardSearch, CS);
+        if (replaySummary(S, Key))
+            return;
+        beginSummary(S, Key);
+    }
+
+    S.SVFGPath.add(CurrNode);
 
     if (auto* StmtNode = dyn_cast<StmtSVFGNode>(CurrNode)) {
         auto* PAGE = StmtNode->getPAGEdge();
@@ -207,22 +457,15 @@ void UseAfterFreeChecker::searchForward(const SVFGNode* CurrNode, const SVFGNode
                 }
 
                 if (report && reachable(CS, Inst)) {
-                    push();
-                    if(check(User)) {
-                       // outs() << "+";
-                        reportBug(User);
-                    } else {
-                        // outs() << "-";
-                    }
-                    pop();
+                    visitUse(S, User);
                 }
             }
     }
 
-    auto& OutEdges = CurrNode->getOutEdges();
-    for(auto It = OutEdges.begin(), E = OutEdges.end(); It != E; ++It) {
-        auto OutEdge = *It;
-        SVFGNode* Child = OutEdge->getDstNode();
+    const SVFG::SVFGCSR* CSR = getSVFG()->getCSR();
+    for(auto It = CSR->outBegin(CurrNode->getId()), E = CSR->outEnd(CurrNode->getId()); It != E; ++It) {
+        SVFGEdge* OutEdge = It->edge;
+        SVFGNode* Child = It->node;
         if (Child == PrevNode)
             continue;
 
@@ -230,8 +473,8 @@ void UseAfterFreeChecker::searchForward(const SVFGNode* CurrNode, const SVFGNode
             continue;
 
         bool Tag = true && TagX;
-        if (OutEdge->isRetVFGEdge() || OutEdge->isCallVFGEdge()) {
-            CallSiteID CSID = getCSID(OutEdge);
+        if (SVFGEdge::isRetVFGEdgeKind(It->kind) || SVFGEdge::isCallVFGEdgeKind(It->kind)) {
+            CallSiteID CSID = It->attr;
             CallSite CS2 = getSVFG()->getCallSite(CSID);
 
             if (CS2.getInstruction() == CS) {
@@ -239,7 +482,7 @@ void UseAfterFreeChecker::searchForward(const SVFGNode* CurrNode, const SVFGNode
             }
 
             // match ctx
-            if (!matchContextF(Ctx, OutEdge)) {
+            if (!matchContextF(S.CxtTrie, Ctx, *It)) {
                 continue;
             }
 
@@ -250,92 +493,85 @@ void UseAfterFreeChecker::searchForward(const SVFGNode* CurrNode, const SVFGNode
             continue;
         }
 
-        push();
-        searchForward(Child, CurrNode, OutEdge, Ctx, CS, Tag);
-        pop();
+        push(S);
+        searchForward(S, Child, CurrNode, OutEdge, Ctx, CS, Tag);
+        pop(S);
     }
-}
 
-bool UseAfterFreeChecker::matchContextB(std::vector<const SVFGEdge*>& Ctx, SVFGEdge* Edge) {
-    if (!Ctx.empty()) {
-        CallSiteID ID = getCSID(Edge);
+    if (UAFSummary.getValue())
+        endSummary(S);
+}
 
-        auto* Top = Ctx.back();
-        CallSiteID TopID = getCSID(Top);
+/*!
+ * Match the context stack with a call/return edge visited backward,
+ * Ctx is updated if they match
+ */
+bool UseAfterFreeChecker::matchContextB(CxtStackTrie& T, CxtStackID& Ctx, const SVFG::SVFGCSREdge& Rec) {
+    if (!T.empty(Ctx)) {
+        CallSiteID ID = Rec.attr;
+        CallSiteID TopID = T.top(Ctx);
 
         if (ID == TopID) {
-            if (Edge->isCallVFGEdge() != Top->isCallVFGEdge()) {
+            if (SVFGEdge::isCallVFGEdgeKind(Rec.kind) != T.isTopCall(Ctx)) {
                 DEBUG_WITH_TYPE("bctx", errs() << "Pop back visiting " <<
                         getSourceLoc(getSVFG()->getCallSite(ID).getInstruction()));
-                Ctx.pop_back();
+                Ctx = T.pop(Ctx);
                 return true;
             }
         } else {
             // if it is call and all call in Ctx
-            if (Edge->isCallVFGEdge()) {
-                bool AllCalls = true;
-                for (size_t I = 0; I < Ctx.size(); ++I) {
-                    if (!Ctx[I]->isCallVFGEdge()) {
-                        AllCalls = false;
-                        break;
-                    }
-                }
-
-                if (AllCalls && Edge->getDstNode()->getBB()->getParent()
-                        == Top->getSrcNode()->getBB()->getParent()) {
-                    Ctx.push_back(Edge);
+            if (SVFGEdge::isCallVFGEdgeKind(Rec.kind)) {
+                // the top is a call, its source resides in the caller of the call site
+                if (T.isAllCalls(Ctx) && Rec.edge->getDstNode()->getBB()->getParent()
+                        == getSVFG()->getCallSite(TopID).getCaller()) {
+                    Ctx = T.push(Ctx, ID, true);
                     return true;
                 }
             } else {
-                assert(Edge->isRetVFGEdge());
-                Ctx.push_back(Edge);
+                assert(SVFGEdge::isRetVFGEdgeKind(Rec.kind));
+                Ctx = T.push(Ctx, ID, false);
                 return true;
             }
         }
     } else {
-        Ctx.push_back(Edge);
+        Ctx = T.push(Ctx, Rec.attr, SVFGEdge::isCallVFGEdgeKind(Rec.kind));
         return true;
     }
 
     return false;
 }
 
-bool UseAfterFreeChecker::matchContextF(std::vector<const SVFGEdge*>& Ctx, SVFGEdge* Edge) {
-    if (!Ctx.empty()) {
-        CallSiteID ID = getCSID(Edge);
-
-        auto* Top = Ctx.back();
-        CallSiteID TopID = getCSID(Top);
+/*!
+ * Match the context stack with a call/return edge visited forward,
+ * Ctx is updated if they match
+ */
+bool UseAfterFreeChecker::matchContextF(CxtStackTrie& T, CxtStackID& Ctx, const SVFG::SVFGCSREdge& Rec) {
+    if (!T.empty(Ctx)) {
+        CallSiteID ID = Rec.attr;
+        CallSiteID TopID = T.top(Ctx);
 
         if (ID == TopID) {
-            if (Edge->isCallVFGEdge() != Top->isCallVFGEdge()) {
-                Ctx.pop_back();
+            if (SVFGEdge::isCallVFGEdgeKind(Rec.kind) != T.isTopCall(Ctx)) {
+                Ctx = T.pop(Ctx);
                 return true;
             }
         } else {
             // if it is ret and all ret in Ctx
-            if (Edge->isRetVFGEdge()) {
-                bool AllRets = true;
-                for (size_t I = 0; I < Ctx.size(); ++I) {
-                    if (!Ctx[I]->isRetVFGEdge()) {
-                        AllRets = false;
-                        break;
-                    }
-                }
-
-                if (AllRets && Top->getDstNode()->getBB()->getParent()
-                        == Edge->getSrcNode()->getBB()->getParent()) {
-                    Ctx.push_back(Edge);
+            if (SVFGEdge::isRetVFGEdgeKind(Rec.kind)) {
+                // the top is a return, its destination resides in the caller of the call site
+                if (T.isAllRets(Ctx) && getSVFG()->getCallSite(TopID).getCaller()
+                        == Rec.edge->getSrcNode()->getBB()->getParent()) {
+                    Ctx = T.push(Ctx, ID, false);
                     return true;
                 }
             } else {
-                assert(Edge->isCallVFGEdge());
-                Ctx.push_back(Edge);
+                assert(SVFGEdge::isCallVFGEdgeKind(Rec.kind));
+                Ctx = T.push(Ctx, ID, true);
                 return true;
             }
         }
     } else {
-        Ctx.push_back(Edge);
+        Ctx = T.push(Ctx, Rec.attr, SVFGEdge::isCallVFGEdgeKind(Rec.kind));
         return true;
     }
 
@@ -358,9 +594,9 @@ CallSiteID UseAfterFreeChecker::getCSID(const SVFGEdge* Edge) {
     return ID;
 }
 
-void UseAfterFreeChecker::reportBug(const Instruction* TailInst) {
+void UseAfterFreeChecker::reportBug(SearchState& S, const Instruction* TailInst) {
     if (ReportNumOnly.getValue()) {
-        Index++;
+        S.NumReports++;
 //        if (Index >= 100) {
 //            outs() << "\n[!!!] Exit with more than 100 reports!\n";
 //            globalprofiler->create_snapshot();
@@ -372,16 +608,19 @@ void UseAfterFreeChecker::reportBug(const Instruction* TailInst) {
         return;
     }
 
-    outs() << "+++++" << ++Index << "+++++\n";
-    for(unsigned I = 0; I < SVFGPath.size(); ++I) {
-        auto* N = SVFGPath[I];
-        outs() << "[" << I << "] ";
-        outs() << getSVFGNodeMsg(N);
-        outs() << "\n";
+    /// the report is numbered when it is flushed, see flushReports()
+    std::string Report;
+    raw_string_ostream O(Report);
+    for(unsigned I = 0; I < S.SVFGPath.size(); ++I) {
+        auto* N = S.SVFGPath[I];
+        O << "[" << I << "] ";
+        O << getSVFGNodeMsg(N);
+        O << "\n";
     }
-    outs() << "[" << SVFGPath.size() << "] ";
-    outs() << "XX (" << TailInst->getParent()->getParent()->getName() << ") \t" << *TailInst;
-    outs() << "\n\n";
+    O << "[" << S.SVFGPath.size() << "] ";
+    O << "XX (" << TailInst->getParent()->getParent()->getName() << ") \t" << *TailInst;
+    O << "\n\n";
+    S.Reports.push_back(O.str());
 
 //    if (Index > 2000)
 //        exit(0);
@@ -415,17 +654,23 @@ std::string UseAfterFreeChecker::getSVFGNodeMsg(const SVFGNode* N) {
 
 bool UseAfterFreeChecker::reachable(const llvm::Instruction* From, const llvm::Instruction* To) {
     if (From->getParent()->getParent() != To->getParent()->getParent()) {
-        return true;
+        return IPR ? IPR->isReachable(From, To) : true;
     } else {
+        /// the reachability index is built up front, it is read-only here
         return CFGR->isReachable(From, To) && From != To;
     }
 }
 
-void UseAfterFreeChecker::printContextStack(std::vector<const SVFGEdge*>& Ctx) {
+void UseAfterFreeChecker::printContextStack(const CxtStackTrie& T, CxtStackID Ctx) {
+    /// collect the stack from top to bottom, and print it from bottom to top
+    std::vector<CxtStackID> Stack;
+    for (; !T.empty(Ctx); Ctx = T.pop(Ctx)) {
+        Stack.push_back(Ctx);
+    }
     outs() << "+++++++++++++++++++++++++\n";
-    for (auto* Edge : Ctx) {
-        bool Call = Edge->isCallVFGEdge();
-        CallSiteID Id = getCSID(Edge);
+    for (auto It = Stack.rbegin(), E = Stack.rend(); It != E; ++It) {
+        bool Call = T.isTopCall(*It);
+        CallSiteID Id = T.top(*It);
         CallSite CS = getSVFG()->getCallSite(Id);
         if (Call)
             outs() << "+ Call to ";
@@ -437,14 +682,18 @@ void UseAfterFreeChecker::printContextStack(std::vector<const SVFGEdge*>& Ctx) {
     outs() << "+++++++++++++++++++++++++\n";
 }
 
-bool UseAfterFreeChecker::check(const Instruction* User) {
+bool UseAfterFreeChecker::check(SearchState& S, const Instruction* User) {
     if (Nocheck.getValue()) {
         return true;
     }
 
+    /// the BDD manager and the guard computation of the path allocator are shared by all sources
+    std::lock_guard<std::mutex> Lock(CondMutex);
+
     auto* PA = this->getPathAllocator();
+    auto& SVFGPath = S.SVFGPath;
 
-    svfgNodeToCondMap.clear();
+    S.svfgNodeToCondMap.clear();
     PA->clearCFCond();
 
     const SVFGNode* source = nullptr;
@@ -473,14 +722,14 @@ bool UseAfterFreeChecker::check(const Instruction* User) {
     VFWorkList worklist;
     worklist.push(source);
     /// mark source node conditions to be true
-    setVFCond(source, PA->getTrueCond());
+    setVFCond(S, source, PA->getTrueCond());
 
     while(!worklist.empty()) {
         const SVFGNode* node = worklist.pop();
 
         PA->setCurEvalVal(getLLVMValue(node));
 
-        PathCondAllocator::Condition* cond = getVFCond(node);
+        PathCondAllocator::Condition* cond = getVFCond(S, node);
         for(SVFGNode::const_iterator it = node->OutEdgeBegin(), eit = node->OutEdgeEnd(); it!=eit; ++it) {
             const SVFGEdge* edge = (*it);
             const SVFGNode* succ = edge->getDstNode();
@@ -502,12 +751,12 @@ bool UseAfterFreeChecker::check(const Instruction* User) {
                 }
 
                 PathCondAllocator::Condition* succPathCond = PA->condAnd(cond, vfCond);
-                if(setVFCond(succ,  PA->condOr(getVFCond(succ), succPathCond) ))
+                if(setVFCond(S, succ,  PA->condOr(getVFCond(S, succ), succPathCond) ))
                     worklist.push(succ);
             }
 
             DBOUT(DSaber, outs() << " node (" << node->getId() << ":" << node->getBB()->getName() <<
-                    ") --> " << "succ (" << succ->getId() << ":" << succ->getBB()->getName() << ") condition: " << getVFCond(succ) << "\n");
+                    ") --> " << "succ (" << succ->getId() << ":" << succ->getBB()->getName() << ") condition: " << getVFCond(S, succ) << "\n");
         }
     }
 
@@ -519,10 +768,10 @@ bool UseAfterFreeChecker::check(const Instruction* User) {
     /// clean up the control flow conditions for next round guard computation
     PA->clearCFCond();
     vfCond = PA->ComputeIntraVFGGuard(nodeBB,succBB);
-    PathCondAllocator::Condition* succPathCond = PA->condAnd(getVFCond(SVFGPath.top()), vfCond);
+    PathCondAllocator::Condition* succPathCond = PA->condAnd(getVFCond(S, SVFGPath.top()), vfCond);
     /*************************/
 
-    PathCondAllocator::Condition* guard = PA->condAnd(getVFCond(SVFGPath[0]), succPathCond);
+    PathCondAllocator::Condition* guard = PA->condAnd(getVFCond(S, SVFGPath[0]), succPathCond);
     if(guard != PA->getFalseCond()) {
         return true;
     }
@@ -530,10 +779,10 @@ bool UseAfterFreeChecker::check(const Instruction* User) {
     return false;
 }
 
-void UseAfterFreeChecker::push() {
-    SVFGPath.push();
+void UseAfterFreeChecker::push(SearchState& S) {
+    S.SVFGPath.push();
 }
 
-void UseAfterFreeChecker::pop() {
-    SVFGPath.pop();
+void UseAfterFreeChecker::pop(SearchState& S) {
+    S.SVFGPath.pop();
 }
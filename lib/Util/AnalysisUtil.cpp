@@ -42,6 +42,7 @@
 #include <llvm/IR/CFG.h>		// for CFG
 #include "Util/Conditions.h"
 #include <sys/resource.h>		/// increase stack size
+#include <mutex>
 
 using namespace llvm;
 
@@ -370,6 +371,9 @@ std::string analysisUtil::sucMsg(std::string msg) {
  */
 void analysisUtil::wrnMsg(std::string msg) {
     if(DisableWarn) return;
+    /// warnings are also printed by the pool threads building the memory SSA
+    static std::mutex wrnMutex;
+    std::lock_guard<std::mutex> lock(wrnMutex);
     outs() << KYEL + msg + KNRM << "\n";
 }
 
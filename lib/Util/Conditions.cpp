@@ -31,16 +31,117 @@
 #include "Util/Conditions.h"
 #include "Util/AnalysisUtil.h"
 #include <llvm/Support/CommandLine.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 
 using namespace llvm;
 
+enum CondBackendTy {
+    BddCond,	///< BDDs of CUDD
+    CubeCond	///< bounded sets of cubes
+};
+
+static cl::opt<CondBackendTy> CondBackend("cond-backend", cl::init(BddCond),
+        cl::desc("Representation of the path conditions"),
+        cl::values(
+            clEnumValN(BddCond, "bdd", "Binary decision diagrams (precise)"),
+            clEnumValN(CubeCond, "cube", "Bounded sets of cubes over the branches (fast, coarse)"),
+            clEnumValEnd));
+
 static cl::opt<unsigned> maxBddSize("maxbddsize",  cl::init(100000),
                                     cl::desc("Maximum context limit for DDA"));
 
+static cl::opt<unsigned> MaxCubes("max-cubes", cl::init(16),
+                                  cl::desc("Maximum number of cubes of a condition of -cond-backend=cube"));
+
+static cl::opt<Cudd_ReorderingType> BddReorder("bdd-reorder", cl::init(CUDD_REORDER_NONE),
+        cl::desc("Dynamic reordering of the BDD variables"),
+        cl::values(
+            clEnumValN(CUDD_REORDER_NONE, "none", "No reordering"),
+            clEnumValN(CUDD_REORDER_SIFT, "sift", "Sifting"),
+            clEnumValN(CUDD_REORDER_SIFT_CONVERGE, "sift-conv", "Sifting repeated until no improvement"),
+            clEnumValN(CUDD_REORDER_GROUP_SIFT, "group-sift", "Group sifting"),
+            clEnumValN(CUDD_REORDER_WINDOW2, "window2", "Window permutation of 2 variables"),
+            clEnumValN(CUDD_REORDER_WINDOW3, "window3", "Window permutation of 3 variables"),
+            clEnumValN(CUDD_REORDER_WINDOW4, "window4", "Window permutation of 4 variables"),
+            clEnumValEnd));
+
+static cl::opt<unsigned> BddReorderThreshold("bdd-reorder-threshold", cl::init(4004),
+        cl::desc("Number of BDD nodes triggering the first reordering, doubled after each reordering"));
+
+static cl::opt<double> BddMaxGrowth("bdd-max-growth", cl::init(1.2),
+                                    cl::desc("Maximum growth of the BDDs during a sifting step"));
+
+/// The hooks of CUDD do not take a client pointer, they find their manager here
+typedef std::map<DdManager*, BddCondManager*> DdToCondManagerMap;
+static DdToCondManagerMap reorderingManagers;
+static std::mutex reorderingManagersMutex;
+
+static BddCondManager* getReorderingManager(DdManager* dd) {
+    std::lock_guard<std::mutex> lock(reorderingManagersMutex);
+    DdToCondManagerMap::const_iterator it = reorderingManagers.find(dd);
+    return it!=reorderingManagers.end() ? it->second : NULL;
+}
+
+static int preReorderingHook(DdManager* dd, const char* str, void* data) {
+    if (BddCondManager* mgr = getReorderingManager(dd))
+        mgr->beforeReordering();
+    return 1;
+}
+
+static int postReorderingHook(DdManager* dd, const char* str, void* data) {
+    if (BddCondManager* mgr = getReorderingManager(dd))
+        mgr->afterReordering();
+    return 1;
+}
+
+CondManager* CondManager::createCondManager() {
+    if (CondBackend == CubeCond)
+        return new CubeCondManager();
+    return new BddCondManager();
+}
+
+BddCondManager::BddCondManager() :
+    liveBeforeReordering(0), reorderedNodes(0) {
+    m_bdd_mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+
+    if (BddReorder != CUDD_REORDER_NONE) {
+        Cudd_AutodynEnable(m_bdd_mgr, BddReorder);
+        Cudd_SetNextReordering(m_bdd_mgr, BddReorderThreshold);
+        Cudd_SetMaxGrowth(m_bdd_mgr, BddMaxGrowth);
+
+        {
+            std::lock_guard<std::mutex> lock(reorderingManagersMutex);
+            reorderingManagers[m_bdd_mgr] = this;
+        }
+        Cudd_AddHook(m_bdd_mgr, preReorderingHook, CUDD_PRE_REORDERING_HOOK);
+        Cudd_AddHook(m_bdd_mgr, postReorderingHook, CUDD_POST_REORDERING_HOOK);
+    }
+}
+
+BddCondManager::~BddCondManager() {
+    {
+        std::lock_guard<std::mutex> lock(reorderingManagersMutex);
+        reorderingManagers.erase(m_bdd_mgr);
+    }
+    Cudd_Quit(m_bdd_mgr);
+}
+
+void BddCondManager::beforeReordering() {
+    liveBeforeReordering = getLiveNodeNumber();
+}
+
+void BddCondManager::afterReordering() {
+    u32_t live = getLiveNodeNumber();
+    if (liveBeforeReordering > live)
+        reorderedNodes += liveBeforeReordering - live;
+}
+
 /// Operations on conditions.
 //@{
 /// use Cudd_bddAndLimit interface to avoid bdds blow up
-DdNode* BddCondManager::AND(DdNode* lhs, DdNode* rhs) {
+CondExpr* BddCondManager::AND(CondExpr* lhs, CondExpr* rhs) {
     if (lhs == getFalseCond() || rhs == getFalseCond())
         return getFalseCond();
     else if (lhs == getTrueCond())
@@ -48,15 +149,16 @@ DdNode* BddCondManager::AND(DdNode* lhs, DdNode* rhs) {
     else if (rhs == getTrueCond())
         return lhs;
     else {
-        DdNode* tmp = Cudd_bddAndLimit(m_bdd_mgr, lhs, rhs, maxBddSize);
+        DdNode* tmp = Cudd_bddAndLimit(m_bdd_mgr, toDd(lhs), toDd(rhs), maxBddSize);
         if(tmp==NULL) {
+            andLimitHits++;
             analysisUtil::wrnMsg("exceeds max bdd size \n");
             ///drop the rhs condition
             return lhs;
         }
         else {
             Cudd_Ref(tmp);
-            return tmp;
+            return toCond(tmp);
         }
     }
 }
@@ -64,7 +166,7 @@ DdNode* BddCondManager::AND(DdNode* lhs, DdNode* rhs) {
 /*!
  * Use Cudd_bddOrLimit interface to avoid bdds blow up
  */
-DdNode* BddCondManager::OR(DdNode* lhs, DdNode* rhs) {
+CondExpr* BddCondManager::OR(CondExpr* lhs, CondExpr* rhs) {
     if (lhs == getTrueCond() || rhs == getTrueCond())
         return getTrueCond();
     else if (lhs == getFalseCond())
@@ -72,26 +174,27 @@ DdNode* BddCondManager::OR(DdNode* lhs, DdNode* rhs) {
     else if (rhs == getFalseCond())
         return lhs;
     else {
-        DdNode* tmp = Cudd_bddOrLimit(m_bdd_mgr, lhs, rhs, maxBddSize);
+        DdNode* tmp = Cudd_bddOrLimit(m_bdd_mgr, toDd(lhs), toDd(rhs), maxBddSize);
         if(tmp==NULL) {
+            orLimitHits++;
             analysisUtil::wrnMsg("exceeds max bdd size \n");
             /// drop the two conditions here
             return getTrueCond();
         }
         else {
             Cudd_Ref(tmp);
-            return tmp;
+            return toCond(tmp);
         }
     }
 }
 
-DdNode* BddCondManager::NEG(DdNode* lhs) {
+CondExpr* BddCondManager::NEG(CondExpr* lhs) {
     if (lhs == getTrueCond())
         return getFalseCond();
     else if (lhs == getFalseCond())
         return getTrueCond();
     else
-        return Cudd_Not(lhs);
+        return toCond(Cudd_Not(toDd(lhs)));
 }
 //@}
 
@@ -132,7 +235,7 @@ void BddCondManager::BddSupport(DdNode * f, NodeBS &support) const {
  * Dump BDD
  */
 void BddCondManager::dump(DdNode* lhs, llvm::raw_ostream & O) {
-    if (lhs == getTrueCond())
+    if (lhs == BddOne())
         O << "T";
     else {
         NodeBS support;
@@ -148,13 +251,13 @@ void BddCondManager::dump(DdNode* lhs, llvm::raw_ostream & O) {
 /*!
  * Dump BDD
  */
-std::string BddCondManager::dumpStr(DdNode* lhs) const {
+std::string BddCondManager::dumpStr(CondExpr* lhs) const {
     std::string str;
     if (lhs == getTrueCond())
         str += "T";
     else {
         NodeBS support;
-        BddSupport(lhs, support);
+        BddSupport(toDd(lhs), support);
         for (NodeBS::iterator iter = support.begin(); iter != support.end();
                 ++iter) {
             unsigned rid = *iter;
@@ -167,3 +270,232 @@ std::string BddCondManager::dumpStr(DdNode* lhs) const {
     return str;
 }
 
+/// Lexicographical order of the set bits
+static bool lessThan(const NodeBS& lhs, const NodeBS& rhs) {
+    NodeBS::iterator lit = lhs.begin(), elit = lhs.end();
+    NodeBS::iterator rit = rhs.begin(), erit = rhs.end();
+    for (; lit != elit && rit != erit; ++lit, ++rit) {
+        if (*lit != *rit)
+            return *lit < *rit;
+    }
+    return lit == elit && rit != erit;
+}
+
+/// Cubes are ordered by their positive then negative variables
+bool CubeCondManager::Cube::operator< (const Cube& rhs) const {
+    if (!(pos == rhs.pos))
+        return lessThan(pos, rhs.pos);
+    return lessThan(neg, rhs.neg);
+}
+
+CubeCondManager::CubeCondManager() : varNum(0), maxCubes(MaxCubes), cubeNum(0) {
+    falseCond = getOrAddCond(CubeVec());
+    trueCond = getOrAddCond(CubeVec(1, Cube()));
+}
+
+CubeCondManager::~CubeCondManager() {
+}
+
+CondExpr* CubeCondManager::createNewCond(unsigned i) {
+    assert(indexToCondMap.find(i)==indexToCondMap.end() && "This should be fresh index to create new condition");
+    CubeVec cubes(1);
+    cubes[0].pos.set(i);
+    CondExpr* cond = getOrAddCond(cubes);
+    indexToCondMap[i] = cond;
+    reserveVars(i + 1);
+    return cond;
+}
+
+CondExpr* CubeCondManager::getOrAddCond(const CubeVec& cubes) {
+    CubeVec simplified(cubes);
+    simplify(simplified);
+    std::pair<CubeVecSet::iterator, bool> res = conds.insert(simplified);
+    if (res.second)
+        cubeNum += simplified.size();
+    return toCond(*res.first);
+}
+
+/*!
+ * Whether a = c & x and b = c & !x, merged is c then
+ */
+bool CubeCondManager::resolve(const Cube& a, const Cube& b, Cube& merged) {
+    if (!a.pos.contains(b.pos) || !b.neg.contains(a.neg))
+        return false;
+    NodeBS posDiff = a.pos;
+    posDiff.intersectWithComplement(b.pos);
+    NodeBS negDiff = b.neg;
+    negDiff.intersectWithComplement(a.neg);
+    if (posDiff.count() != 1 || !(posDiff == negDiff))
+        return false;
+    merged.pos = b.pos;
+    merged.neg = a.neg;
+    return true;
+}
+
+/*!
+ * Sort the cubes, remove the duplicated and subsumed ones, and merge the cubes
+ * c & x and c & !x into c until nothing changes. A true cube makes the whole condition true.
+ */
+void CubeCondManager::simplify(CubeVec& cubes) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::sort(cubes.begin(), cubes.end());
+        cubes.erase(std::unique(cubes.begin(), cubes.end()), cubes.end());
+
+        CubeVec kept;
+        for (CubeVec::const_iterator it = cubes.begin(), eit = cubes.end(); it != eit; ++it) {
+            if (it->pos.empty() && it->neg.empty()) {
+                cubes.assign(1, Cube());
+                return;
+            }
+            bool subsumed = false;
+            for (CubeVec::const_iterator kit = cubes.begin(); kit != eit && !subsumed; ++kit)
+                subsumed = kit != it && kit->subsumes(*it);
+            if (!subsumed)
+                kept.push_back(*it);
+        }
+        cubes.swap(kept);
+
+        for (u32_t i = 0; i < cubes.size() && !changed; ++i) {
+            for (u32_t j = i + 1; j < cubes.size() && !changed; ++j) {
+                Cube merged;
+                if (resolve(cubes[i], cubes[j], merged) || resolve(cubes[j], cubes[i], merged)) {
+                    cubes[i] = merged;
+                    cubes.erase(cubes.begin() + j);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * Conjunction of every pair of cubes, contradicting cubes are dropped.
+ * Drop the rhs condition if the result has too many cubes.
+ */
+CondExpr* CubeCondManager::AND(CondExpr* lhs, CondExpr* rhs) {
+    if (lhs == getFalseCond() || rhs == getFalseCond())
+        return getFalseCond();
+    else if (lhs == getTrueCond())
+        return rhs;
+    else if (rhs == getTrueCond())
+        return lhs;
+    else if (lhs == rhs)
+        return lhs;
+
+    const CubeVec& lhsCubes = getCubes(lhs);
+    const CubeVec& rhsCubes = getCubes(rhs);
+    CubeVec cubes;
+    for (CubeVec::const_iterator lit = lhsCubes.begin(), elit = lhsCubes.end(); lit != elit; ++lit) {
+        for (CubeVec::const_iterator rit = rhsCubes.begin(), erit = rhsCubes.end(); rit != erit; ++rit) {
+            Cube cube = *lit;
+            cube.pos |= rit->pos;
+            cube.neg |= rit->neg;
+            if (!cube.pos.intersects(cube.neg))
+                cubes.push_back(cube);
+        }
+    }
+
+    simplify(cubes);
+    if (cubes.size() > maxCubes) {
+        andLimitHits++;
+        return lhs;
+    }
+    return getOrAddCond(cubes);
+}
+
+/*!
+ * Union of the cubes, saturate to true if the result has too many cubes
+ */
+CondExpr* CubeCondManager::OR(CondExpr* lhs, CondExpr* rhs) {
+    if (lhs == getTrueCond() || rhs == getTrueCond())
+        return getTrueCond();
+    else if (lhs == getFalseCond())
+        return rhs;
+    else if (rhs == getFalseCond())
+        return lhs;
+    else if (lhs == rhs)
+        return lhs;
+
+    CubeVec cubes(getCubes(lhs));
+    const CubeVec& rhsCubes = getCubes(rhs);
+    cubes.insert(cubes.end(), rhsCubes.begin(), rhsCubes.end());
+
+    simplify(cubes);
+    if (cubes.size() > maxCubes) {
+        orLimitHits++;
+        return getTrueCond();
+    }
+    return getOrAddCond(cubes);
+}
+
+/*!
+ * De Morgan: the conjunction over the cubes of the disjunction of their negated literals,
+ * saturate to true if an intermediate result has too many cubes
+ */
+CondExpr* CubeCondManager::NEG(CondExpr* lhs) {
+    if (lhs == getTrueCond())
+        return getFalseCond();
+    else if (lhs == getFalseCond())
+        return getTrueCond();
+
+    const CubeVec& lhsCubes = getCubes(lhs);
+    CondExpr* res = getTrueCond();
+    for (CubeVec::const_iterator it = lhsCubes.begin(), eit = lhsCubes.end(); it != eit; ++it) {
+        CubeVec negCubes;
+        for (NodeBS::iterator vit = it->pos.begin(), evit = it->pos.end(); vit != evit; ++vit) {
+            Cube cube;
+            cube.neg.set(*vit);
+            negCubes.push_back(cube);
+        }
+        for (NodeBS::iterator vit = it->neg.begin(), evit = it->neg.end(); vit != evit; ++vit) {
+            Cube cube;
+            cube.pos.set(*vit);
+            negCubes.push_back(cube);
+        }
+        if (negCubes.size() > maxCubes) {
+            orLimitHits++;
+            return getTrueCond();
+        }
+        u32_t hits = andLimitHits;
+        res = AND(res, getOrAddCond(negCubes));
+        if (andLimitHits != hits)
+            return getTrueCond();
+    }
+    return res;
+}
+
+void CubeCondManager::support(CondExpr* cond, NodeBS &support) const {
+    const CubeVec& cubes = getCubes(cond);
+    for (CubeVec::const_iterator it = cubes.begin(), eit = cubes.end(); it != eit; ++it) {
+        support |= it->pos;
+        support |= it->neg;
+    }
+}
+
+/*!
+ * Dump the cubes, e.g., "1 !2 | 3"
+ */
+std::string CubeCondManager::dumpStr(CondExpr* cond) const {
+    if (cond == getTrueCond())
+        return "T";
+    else if (cond == getFalseCond())
+        return "F";
+
+    std::string str;
+    const CubeVec& cubes = getCubes(cond);
+    for (CubeVec::const_iterator it = cubes.begin(), eit = cubes.end(); it != eit; ++it) {
+        if (it != cubes.begin())
+            str += "| ";
+        NodeBS vars = it->pos;
+        vars |= it->neg;
+        for (NodeBS::iterator vit = vars.begin(), evit = vars.end(); vit != evit; ++vit) {
+            if (it->neg.test(*vit))
+                str += "!";
+            str += std::to_string(*vit);
+            str += " ";
+        }
+    }
+    return str;
+}
@@ -0,0 +1,97 @@
+//===- GraphArena.cpp -- Slab allocator of graph nodes and edges-------------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * GraphArena.cpp
+ */
+
+#include "Util/GraphArena.h"
+#include <llvm/Support/CommandLine.h>
+
+using namespace llvm;
+
+static cl::opt<bool> UseGraphArena("graph-arena", cl::init(true),
+                                   cl::desc("Allocate the nodes and edges of PAG, constraint graph and SVFG from per-graph slabs"));
+
+/*!
+ * Constructor, the option is read once so that an arena does not change its mind
+ */
+GraphArena::GraphArena(): slabBytes(0), allocatedNum(0), recycledNum(0), enabled(UseGraphArena) {
+    for (size_t i = 0; i <= MaxObjectSize / Alignment; ++i) {
+        classes[i].cur = NULL;
+        classes[i].end = NULL;
+        classes[i].freeList = NULL;
+        classes[i].nextSlabSize = MinSlabSize;
+    }
+}
+
+/*!
+ * The objects still alive in the slabs are gone with them, their destructors
+ * must have run already (GenericGraph deletes its nodes before its arena goes)
+ */
+GraphArena::~GraphArena() {
+    for (std::vector<void*>::iterator it = slabs.begin(), eit = slabs.end(); it != eit; ++it)
+        std::free(*it);
+}
+
+/*!
+ * Take a slot from the free list of the size class, or bump it from the current slab
+ */
+void* GraphArena::allocate(size_t size) {
+    if (!enabled || size > MaxObjectSize)
+        return allocateUnowned(size);
+
+    SizeClass& sc = classes[getSizeClass(size)];
+    Header* header;
+    if (sc.freeList) {
+        header = reinterpret_cast<Header*>(sc.freeList);
+        sc.freeList = sc.freeList->next;
+    }
+    else {
+        size_t slotSize = HeaderSize + getSizeClass(size) * Alignment;
+        if ((size_t)(sc.end - sc.cur) < slotSize)
+            grow(sc, slotSize);
+        header = reinterpret_cast<Header*>(sc.cur);
+        sc.cur += slotSize;
+    }
+    header->arena = this;
+    allocatedNum++;
+    return header + 1;
+}
+
+/*!
+ * Slabs of a size class double up to MaxSlabSize, the tail of the previous slab is left unused
+ */
+void GraphArena::grow(SizeClass& sc, size_t slotSize) {
+    size_t bytes = sc.nextSlabSize;
+    if (bytes < slotSize)
+        bytes = slotSize;
+    if (sc.nextSlabSize < MaxSlabSize)
+        sc.nextSlabSize *= 2;
+
+    char* slab = static_cast<char*>(std::malloc(bytes));
+    assert(slab && "out of memory");
+    slabs.push_back(slab);
+    slabBytes += bytes;
+    sc.cur = slab;
+    sc.end = slab + bytes;
+}
@@ -36,6 +36,9 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Analysis/PostDominators.h>
 #include <llvm/IR/Dominators.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/ADT/DepthFirstIterator.h>
+#include <llvm/ADT/PostOrderIterator.h>
 #include <limits.h>
 
 using namespace llvm;
@@ -48,27 +51,59 @@ u32_t VFPathCond::maximumPathLen = 0;
 u32_t VFPathCond::maximumPath = 0;
 
 u32_t PathCondAllocator::totalCondNum = 0;
-BddCondManager* PathCondAllocator::bddCondMgr = NULL;
+CondManager* PathCondAllocator::bddCondMgr = NULL;
+std::mutex PathCondAllocator::mainCondMutex;
+thread_local PathCondAllocator::CondState* PathCondAllocator::workerState = NULL;
 static cl::opt<bool> PrintPathCond("print-pc", cl::init(false),
                                    cl::desc("Print out path condition"));
 
+enum CondOrderTy {
+    BlockCondOrder,
+    DomTreeCondOrder,
+    RPOCondOrder
+};
+
+static cl::opt<CondOrderTy> CondOrder("cond-order", cl::init(BlockCondOrder),
+                                      cl::desc("Order of the branch condition variables of a function"),
+                                      cl::values(
+                                          clEnumValN(BlockCondOrder, "block", "Layout order of the basic blocks"),
+                                          clEnumValN(DomTreeCondOrder, "domtree", "Preorder of the dominator tree, a branch before the ones it dominates"),
+                                          clEnumValN(RPOCondOrder, "rpo", "Reverse post order of the control-flow graph"),
+                                          clEnumValEnd));
+
+static cl::opt<bool> LazyCond("lazy-cond", cl::init(true),
+                              cl::desc("Allocate the branch conditions of a function when a guard computation enters it"));
+
+static cl::opt<unsigned> GuardCacheSize("guard-cache-size", cl::init(100000),
+                                        cl::desc("Maximum number of memoized intra-procedural guards (0 disables the cache)"));
+
 /*!
- * Allocate path condition for each branch
+ * Reserve the condition indices of each function in the module order, so that the index
+ * of a branch condition does not depend on when (or by which thread) it is allocated.
+ * The variables are created in the index order, which keeps the initial BDD order controlled.
  */
 void PathCondAllocator::allocate(const Module& M) {
     DBOUT(DGENERAL,outs() << pasMsg("path condition allocation starts\n"));
 
+    std::vector<const Function*> funs;
     for (Module::const_iterator fit = M.begin(); fit != M.end(); ++fit) {
         const Function & func = *fit;
         if (!analysisUtil::isExtCall(&func)) {
-            // Allocate conditions for a program.
+            funToCondIndexMap[&func] = totalCondNum;
             for (Function::const_iterator bit = func.begin(), ebit = func.end(); bit != ebit; ++bit) {
-                const BasicBlock & bb = *bit;
-                collectBBCallingProgExit(bb);
-                allocateForBB(bb);
+                collectBBCallingProgExit(*bit);
+                totalCondNum += getCondNumOfBB(*bit);
             }
+            funs.push_back(&func);
         }
     }
+    mainState.condMgr->reserveVars(totalCondNum);
+
+    // Allocate conditions for a program.
+    if (!LazyCond || PrintPathCond) {
+        for (std::vector<const Function*>::const_iterator it = funs.begin(), eit = funs.end(); it != eit; ++it)
+            allocateMainConds(*it);
+    }
 
     if(PrintPathCond)
         printPathCond();
@@ -76,10 +111,99 @@ void PathCondAllocator::allocate(const Module& M) {
     DBOUT(DGENERAL,outs() << pasMsg("path condition allocation ends\n"));
 }
 
+/*!
+ * The dominator tree and the reverse post order only cover the reachable blocks,
+ * the unreachable ones follow in the layout order
+ */
+void PathCondAllocator::getBBsInCondOrder(const Function& fun, std::vector<const BasicBlock*>& bbs) {
+    std::set<const BasicBlock*> ordered;
+
+    if (CondOrder == DomTreeCondOrder) {
+        DominatorTree* dt = getDT(&fun);
+        for (df_iterator<DomTreeNode*> it = df_begin(dt->getRootNode()), eit = df_end(dt->getRootNode()); it != eit; ++it) {
+            bbs.push_back(it->getBlock());
+            ordered.insert(it->getBlock());
+        }
+    }
+    else if (CondOrder == RPOCondOrder) {
+        ReversePostOrderTraversal<const Function*> rpot(&fun);
+        for (ReversePostOrderTraversal<const Function*>::rpo_iterator it = rpot.begin(), eit = rpot.end(); it != eit; ++it) {
+            bbs.push_back(*it);
+            ordered.insert(*it);
+        }
+    }
+
+    for (Function::const_iterator bit = fun.begin(), ebit = fun.end(); bit != ebit; ++bit) {
+        if (ordered.find(&*bit) == ordered.end())
+            bbs.push_back(&*bit);
+    }
+}
+
+/*!
+ * Number of decision variables of a basic block, log2(num_succ) if it has more than one successor
+ */
+u32_t PathCondAllocator::getCondNumOfBB(const BasicBlock& bb) const {
+    u32_t succ_number = getBBSuccessorNum(&bb);
+    if(succ_number > 1) {
+        double num = log(succ_number)/log(2);
+        return (u32_t)ceil(num);
+    }
+    return 0;
+}
+
+/*!
+ * A worker state gets the conditions of a function from the main state,
+ * where they are allocated first if they are not yet
+ */
+void PathCondAllocator::allocateForFunction(const Function* fun) {
+    CondState& state = getState();
+    if(state.condFuns.find(fun) != state.condFuns.end())
+        return;
+
+    if(&state == &mainState) {
+        allocateMainConds(fun);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mainCondMutex);
+    /// the main conditions are computed on the main manager
+    workerState = NULL;
+    allocateMainConds(fun);
+    workerState = &state;
+
+    for (Function::const_iterator bit = fun->begin(), ebit = fun->end(); bit != ebit; ++bit) {
+        BBCondMap::const_iterator it = mainState.bbConds.find(&*bit);
+        if(it == mainState.bbConds.end())
+            continue;
+        CondPosMap& condPosMap = state.bbConds[&*bit];
+        for(CondPosMap::const_iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit)
+            condPosMap[cit->first] = state.condMgr->transfer(mainState.condMgr, cit->second);
+    }
+    state.condFuns.insert(fun);
+}
+
+/*!
+ * Allocate the conditions of a function in its reserved indices, in the order of -cond-order
+ */
+void PathCondAllocator::allocateMainConds(const Function* fun) {
+    if(mainState.condFuns.find(fun) != mainState.condFuns.end())
+        return;
+    mainState.condFuns.insert(fun);
+
+    FunToCondIndexMap::const_iterator it = funToCondIndexMap.find(fun);
+    assert(it != funToCondIndexMap.end() && "no condition index reserved for this function?");
+    u32_t index = it->second;
+
+    std::vector<const BasicBlock*> bbs;
+    getBBsInCondOrder(*fun, bbs);
+    for (std::vector<const BasicBlock*>::const_iterator bit = bbs.begin(), ebit = bbs.end(); bit != ebit; ++bit)
+        allocateForBB(**bit, index);
+}
+
 /*!
  * Allocate conditions for a basic block and propagate its condition to its successors.
  */
-void PathCondAllocator::allocateForBB(const BasicBlock & bb)
+void PathCondAllocator::allocateForBB(const BasicBlock & bb, u32_t& index)
 {
 
     u32_t succ_number = getBBSuccessorNum(&bb);
@@ -88,12 +212,11 @@ void PathCondAllocator::allocateForBB(const BasicBlock & bb)
     if(succ_number > 1) {
 
         //allocate log2(num_succ) decision variables
-        double num = log(succ_number)/log(2);
-        u32_t bit_num = (u32_t)ceil(num);
+        u32_t bit_num = getCondNumOfBB(bb);
         u32_t succ_index = 0;
         std::vector<Condition*> condVec;
         for(u32_t i = 0 ; i < bit_num; i++) {
-            condVec.push_back(newCond(bb.getTerminator()));
+            condVec.push_back(newCond(bb.getTerminator(), index++));
         }
 
         // iterate each successor
@@ -134,6 +257,7 @@ PathCondAllocator::Condition* PathCondAllocator::getBranchCond(const llvm::Basic
     if(getBBSuccessorNum(bb) == 1)
         return getTrueCond();
     else {
+        const BBCondMap& bbConds = getState().bbConds;
         BBCondMap::const_iterator it = bbConds.find(bb);
         assert(it!=bbConds.end() && "basic block does not have branch and conditions??");
         CondPosMap::const_iterator cit = it->second.find(pos);
@@ -149,7 +273,7 @@ void PathCondAllocator::setBranchCond(const llvm::BasicBlock *bb, const llvm::Ba
     /// we only care about basic blocks have more than one successor
     assert(getBBSuccessorNum(bb) > 1 && "not more than one successor??");
     u32_t pos = getBBSuccessorPos(bb,succ);
-    CondPosMap& condPosMap = bbConds[bb];
+    CondPosMap& condPosMap = getState().bbConds[bb];
 
     /// FIXME: llvm getNumSuccessors allows duplicated block in the successors, it makes this assertion fail
     /// In this case we may waste a condition allocation, because the overwrite of the previous cond
@@ -377,14 +501,13 @@ PathCondAllocator::Condition* PathCondAllocator::getPHIComplementCond(const Basi
 /*!
  * Compute calling inter-procedural guards between two SVFGNodes (from caller to callee)
  * src --c1--> callBB --true--> funEntryBB --c2--> dst
- * the InterCallVFGGuard is c1 ^ c2
+ * the InterCallVFGGuard is exactly c1 ^ c2, c2 starts from true at funEntryBB
  */
 PathCondAllocator::Condition* PathCondAllocator::ComputeInterCallVFGGuard(const llvm::BasicBlock* srcBB, const llvm::BasicBlock* dstBB, const BasicBlock* callBB) {
     const BasicBlock* funEntryBB = &dstBB->getParent()->getEntryBlock();
 
     assert(srcBB->getParent() == callBB->getParent());
     Condition* c1 = ComputeIntraVFGGuard(srcBB,callBB);
-    setCFCond(funEntryBB,condOr(getCFCond(funEntryBB),getCFCond(callBB)));
 
     assert(funEntryBB->getParent() == dstBB->getParent());
     Condition* c2 = ComputeIntraVFGGuard(funEntryBB,dstBB);
@@ -394,21 +517,192 @@ PathCondAllocator::Condition* PathCondAllocator::ComputeInterCallVFGGuard(const
 /*!
  * Compute return inter-procedural guards between two SVFGNodes (from callee to caller)
  * src --c1--> funExitBB --true--> retBB --c2--> dst
- * the InterRetVFGGuard is c1 ^ c2
+ * the InterRetVFGGuard is exactly c1 ^ c2, c2 starts from true at retBB
  */
 PathCondAllocator::Condition* PathCondAllocator::ComputeInterRetVFGGuard(const llvm::BasicBlock*  srcBB, const llvm::BasicBlock*  dstBB, const BasicBlock* retBB) {
     const BasicBlock* funExitBB = getFunExitBB(srcBB->getParent());
 
     Condition* c1 = ComputeIntraVFGGuard(srcBB,funExitBB);
-    setCFCond(retBB,condOr(getCFCond(retBB),getCFCond(funExitBB)));
     Condition* c2 = ComputeIntraVFGGuard(retBB,dstBB);
     return condAnd(c1,c2);
 }
 
 /*!
  * Compute intra-procedural guards between two SVFGNodes (inside same function)
+ * A guard only depends on the two basic blocks and the value under evaluation when it is
+ * computed from scratch, so it is memoized. A cache miss starts from cleared control-flow
+ * conditions. An inter-procedural guard is the conjunction c1 ^ c2 of the two intra-procedural
+ * guards around its call/ret edge, each of them memoized on its own, no control-flow condition
+ * is carried from c1 to c2.
  */
 PathCondAllocator::Condition* PathCondAllocator::ComputeIntraVFGGuard(const llvm::BasicBlock* srcBB, const llvm::BasicBlock* dstBB) {
+    if(GuardCacheSize == 0)
+        return computeIntraVFGGuard(srcBB,dstBB);
+
+    GuardKey key(std::make_pair(srcBB,dstBB), getCurEvalVal());
+    Condition* cond = NULL;
+    if(lookupGuard(key,cond)) {
+        getState().guardCacheHits++;
+        return cond;
+    }
+
+    getState().guardCacheMisses++;
+    clearCFCond();
+    cond = computeIntraVFGGuard(srcBB,dstBB);
+    insertGuard(key,cond);
+    return cond;
+}
+
+/*!
+ * Look up a memoized guard and mark it as the most recently used
+ */
+bool PathCondAllocator::lookupGuard(const GuardKey& key, Condition*& cond) {
+    CondState& state = getState();
+    GuardCacheMap::iterator it = state.guardCache.find(key);
+    if(it==state.guardCache.end())
+        return false;
+
+    state.guardLRU.splice(state.guardLRU.begin(), state.guardLRU, it->second.second);
+    cond = it->second.first;
+    return true;
+}
+
+/*!
+ * Memoize a guard, evict the least recently used one if the cache is full
+ */
+void PathCondAllocator::insertGuard(const GuardKey& key, Condition* cond) {
+    CondState& state = getState();
+    assert(state.guardCache.find(key)==state.guardCache.end() && "guard has already been cached");
+    if(state.guardCache.size() >= GuardCacheSize) {
+        GuardCacheMap::iterator it = state.guardCache.find(state.guardLRU.back());
+        assert(it!=state.guardCache.end() && "LRU list and guard cache out of sync");
+        markForRelease(it->second.first);
+        state.guardCache.erase(it);
+        state.guardLRU.pop_back();
+        state.guardCacheEvictions++;
+    }
+
+    state.condMgr->retain(cond);
+    state.guardLRU.push_front(key);
+    state.guardCache[key] = std::make_pair(cond, state.guardLRU.begin());
+}
+
+/*!
+ * Release all the memoized guards of the main state,
+ * the guards of the workers go with their managers
+ */
+void PathCondAllocator::releaseGuardCache() {
+    for(GuardCacheMap::iterator it = mainState.guardCache.begin(), eit = mainState.guardCache.end(); it!=eit; ++it)
+        mainState.condMgr->markForRelease(it->second.first);
+    mainState.guardCache.clear();
+    mainState.guardLRU.clear();
+}
+
+/*!
+ * Print guard cache statistics
+ */
+void PathCondAllocator::printGuardCacheStat() {
+    u32_t hits = mainState.guardCacheHits;
+    u32_t misses = mainState.guardCacheMisses;
+    u32_t evictions = mainState.guardCacheEvictions;
+    u32_t size = mainState.guardCache.size();
+    for(CondStateVec::const_iterator it = workerStates.begin(), eit = workerStates.end(); it!=eit; ++it) {
+        hits += (*it)->guardCacheHits;
+        misses += (*it)->guardCacheMisses;
+        evictions += (*it)->guardCacheEvictions;
+        size += (*it)->guardCache.size();
+    }
+
+    u32_t queries = hits + misses;
+    outs() << "Guard cache hits: " << hits << "\n";
+    outs() << "Guard cache misses: " << misses << "\n";
+    if(queries)
+        outs() << "Guard cache hit rate: " << (hits * 100.0 / queries) << "%\n";
+    outs() << "Guard cache evictions: " << evictions << "\n";
+    outs() << "Guard cache size: " << size << "\n";
+    if(!workerStates.empty())
+        outs() << "Guard cache workers: " << workerStates.size() << "\n";
+}
+
+/*!
+ * Print the statistics of the BDD managers, summed up over the main and the worker managers
+ */
+void PathCondAllocator::printBddManagerStat() {
+    CondStateVec states(workerStates);
+    states.push_back(&mainState);
+
+    u32_t andLimitHits = 0, orLimitHits = 0, reorderings = 0, peakLiveNodes = 0;
+    u64_t reorderedNodes = 0;
+    long reorderingTime = 0;
+    for(CondStateVec::const_iterator it = states.begin(), eit = states.end(); it!=eit; ++it) {
+        CondManager* mgr = (*it)->condMgr;
+        andLimitHits += mgr->getAndLimitHits();
+        orLimitHits += mgr->getOrLimitHits();
+        reorderings += mgr->getReorderingNum();
+        reorderingTime += mgr->getReorderingTime();
+        reorderedNodes += mgr->getReorderedNodes();
+        peakLiveNodes += mgr->getMaxLiveCondNumber();
+    }
+
+    outs() << "BDD size limit hits (AND/OR): " << andLimitHits << "/" << orLimitHits << "\n";
+    outs() << "BDD reorderings: " << reorderings << " (" << reorderingTime << "ms)\n";
+    outs() << "BDD live nodes removed by reordering: " << reorderedNodes << "\n";
+    outs() << "BDD peak live nodes: " << peakLiveNodes << "\n";
+}
+
+/*!
+ * Attach a worker state to the calling thread, an idle one if any
+ */
+void PathCondAllocator::attachWorker() {
+    assert(workerState==NULL && "the thread already has a worker state");
+    CondState* state = NULL;
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        if(!idleWorkerStates.empty()) {
+            state = idleWorkerStates.back();
+            idleWorkerStates.pop_back();
+        }
+    }
+    if(state==NULL)
+        state = createWorkerState();
+    workerState = state;
+}
+
+void PathCondAllocator::detachWorker() {
+    assert(workerState && "the thread has no worker state");
+    std::lock_guard<std::mutex> lock(workerMutex);
+    idleWorkerStates.push_back(workerState);
+    workerState = NULL;
+}
+
+/*!
+ * Create a worker manager with the variables of the main manager (in the same order),
+ * the branch conditions are transferred into it function by function (see allocateForFunction)
+ */
+PathCondAllocator::CondState* PathCondAllocator::createWorkerState() {
+    CondState* state = new CondState(CondManager::createCondManager());
+    {
+        std::lock_guard<std::mutex> lock(mainCondMutex);
+        state->condMgr->reserveVars(totalCondNum);
+    }
+
+    std::lock_guard<std::mutex> lock(workerMutex);
+    workerStates.push_back(state);
+    return state;
+}
+
+PathCondAllocator::Condition* PathCondAllocator::transferToMain(Condition* cond) {
+    if(workerState==NULL)
+        return cond;
+
+    std::lock_guard<std::mutex> lock(mainCondMutex);
+    return mainState.condMgr->transfer(workerState->condMgr, cond);
+}
+
+/*!
+ * Compute an intra-procedural guard by propagating branch conditions from srcBB to dstBB
+ */
+PathCondAllocator::Condition* PathCondAllocator::computeIntraVFGGuard(const llvm::BasicBlock* srcBB, const llvm::BasicBlock* dstBB) {
 
     assert(srcBB->getParent() == dstBB->getParent() && "two basic blocks are not in the same function??");
 
@@ -416,6 +710,8 @@ PathCondAllocator::Condition* PathCondAllocator::ComputeIntraVFGGuard(const llvm
     if(postDT->dominates(dstBB,srcBB))
         return getTrueCond();
 
+    allocateForFunction(srcBB->getParent());
+
     CFWorkList worklist;
     worklist.push(srcBB);
     setCFCond(srcBB,getTrueCond());
@@ -462,6 +758,14 @@ PathCondAllocator::Condition* PathCondAllocator::ComputeIntraVFGGuard(const llvm
  * Release memory
  */
 void PathCondAllocator::destroy() {
+    for(CondStateVec::iterator it = workerStates.begin(), eit = workerStates.end(); it!=eit; ++it) {
+        delete (*it)->condMgr;
+        delete *it;
+    }
+    workerStates.clear();
+    idleWorkerStates.clear();
+
+    releaseGuardCache();
     delete bddCondMgr;
     bddCondMgr = NULL;
 }
@@ -473,7 +777,7 @@ void PathCondAllocator::printPathCond() {
 
     outs() << "print path condition\n";
 
-    for(BBCondMap::iterator it = bbConds.begin(), eit = bbConds.end(); it!=eit; ++it) {
+    for(BBCondMap::iterator it = mainState.bbConds.begin(), eit = mainState.bbConds.end(); it!=eit; ++it) {
         const BasicBlock* bb = it->first;
         for(CondPosMap::iterator cit = it->second.begin(), ecit = it->second.end(); cit!=ecit; ++cit) {
             const TerminatorInst *Term = bb->getTerminator();
@@ -0,0 +1,252 @@
+//===- ProcessShards.cpp -- Sharding work items over forked processes--------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * ProcessShards.cpp
+ */
+
+#include "Util/ProcessShards.h"
+#include "Util/ByteCoder.h"
+#include <llvm/Support/raw_ostream.h>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+/// Create an empty temporary file and return its name
+static std::string createTempFile() {
+    char name[] = "/tmp/svf-shard-XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0) {
+        llvm::errs() << "cannot create a temporary file for a shard\n";
+        exit(1);
+    }
+    close(fd);
+    return name;
+}
+
+/// Read a whole file and remove it
+static std::string readAndRemove(const std::string& file) {
+    std::ifstream in(file.c_str(), std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    unlink(file.c_str());
+    return content.str();
+}
+
+static void writeProgress(int fd, const void* prog, size_t size) {
+    if (pwrite(fd, prog, size, 0) != (ssize_t)size)
+        _exit(2);
+}
+
+static void writeAll(int fd, const char* buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, buf, size);
+        if (n <= 0)
+            _exit(2);
+        buf += n;
+        size -= n;
+    }
+}
+
+int ProcessShards::startChild(u32_t shard, ItemFunc& func, ChildRun& child) {
+    child.shard = shard;
+    child.outFile = createTempFile();
+    child.errFile = createTempFile();
+    child.progFile = createTempFile();
+    child.dataFile = createTempFile();
+
+    /// the child starts from the next position, record it in case the child dies before its first write
+    Progress prog;
+    prog.current = shardNext[shard];
+    prog.next = shardNext[shard];
+    prog.result = 0;
+    int progFd = open(child.progFile.c_str(), O_WRONLY);
+    writeProgress(progFd, &prog, sizeof(prog));
+
+    /// do not let the child inherit (and print again) buffered output
+    outs().flush();
+    errs().flush();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        errs() << "cannot fork a worker process for shard " << shard << "\n";
+        exit(1);
+    }
+    if (pid > 0) {
+        close(progFd);
+        stats[shard].processNum++;
+        return pid;
+    }
+
+    /// child process: the alarm, armed for every item, kills the child when an item runs out of time
+    signal(SIGALRM, SIG_DFL);
+
+    int outFd = open(child.outFile.c_str(), O_WRONLY);
+    int errFd = open(child.errFile.c_str(), O_WRONLY);
+    dup2(outFd, STDOUT_FILENO);
+    dup2(errFd, STDERR_FILENO);
+    close(outFd);
+    close(errFd);
+    /// keep the partial output if the child is killed
+    outs().SetUnbuffered();
+
+    int dataFd = open(child.dataFile.c_str(), O_WRONLY | O_APPEND);
+    const std::vector<u32_t>& items = shardItems[shard];
+    for (u32_t pos = prog.next; pos < items.size(); ++pos) {
+        prog.current = pos;
+        writeProgress(progFd, &prog, sizeof(prog));
+        if (timeLimit > 0)
+            alarm(timeLimit);
+        std::string data;
+        prog.result += func(items[pos], data);
+        if (timeLimit > 0)
+            alarm(0);
+
+        /// the data of an item is written before the item is marked as finished
+        std::string record;
+        ByteCoder::putU64(record, pos);
+        ByteCoder::putString(record, data);
+        writeAll(dataFd, record.data(), record.size());
+        prog.next = pos + 1;
+        writeProgress(progFd, &prog, sizeof(prog));
+    }
+
+    close(dataFd);
+    outs().flush();
+    errs().flush();
+    close(progFd);
+    _exit(0);
+}
+
+void ProcessShards::collectChild(const ChildRun& child, int status) {
+    ShardStat& stat = stats[child.shard];
+    const std::vector<u32_t>& items = shardItems[child.shard];
+    u32_t& next = shardNext[child.shard];
+
+    Progress prog;
+    std::string progData = readAndRemove(child.progFile);
+    assert(progData.size() >= sizeof(prog) && "progress of a worker process not found?");
+    memcpy(&prog, progData.data(), sizeof(prog));
+
+    stat.out += readAndRemove(child.outFile);
+    stat.err += readAndRemove(child.errFile);
+
+    std::string records = readAndRemove(child.dataFile);
+    size_t pos = 0;
+    u64_t itemPos;
+    std::string data;
+    while (ByteCoder::getU64(records, pos, itemPos) && ByteCoder::getString(records, pos, data)) {
+        /// a child killed between the two writes leaves the data of an item counted as failed
+        if (itemPos < prog.next)
+            itemData[items[itemPos]].swap(data);
+    }
+    stat.result += prog.result;
+    stat.doneNum += prog.next - next;
+    next = prog.next;
+
+    bool normalExit = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!normalExit && next < items.size()) {
+        /// skip the item in flight, the rest of the shard is run by a new child
+        u32_t failed = items[next];
+        if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM)
+            stat.timedOutItems.push_back(failed);
+        else
+            stat.crashedItems.push_back(failed);
+        next++;
+    }
+}
+
+/*!
+ * Run the shards concurrently, one child process per shard at a time
+ */
+u64_t ProcessShards::run(u32_t itemNum, ItemFunc func) {
+    stats.assign(shardNum, ShardStat());
+    shardItems.assign(shardNum, std::vector<u32_t>());
+    shardNext.assign(shardNum, 0);
+    itemData.assign(itemNum, std::string());
+    for (u32_t i = 0; i < itemNum; ++i)
+        shardItems[i % shardNum].push_back(i);
+
+    std::map<pid_t, ChildRun> running;
+    for (u32_t s = 0; s < shardNum; ++s) {
+        stats[s].itemNum = shardItems[s].size();
+        if (shardItems[s].empty())
+            continue;
+        ChildRun child;
+        pid_t pid = startChild(s, func, child);
+        running[pid] = child;
+    }
+
+    while (!running.empty()) {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        std::map<pid_t, ChildRun>::iterator it = running.find(pid);
+        if (it == running.end())
+            continue;
+
+        ChildRun child = it->second;
+        running.erase(it);
+        collectChild(child, status);
+
+        if (shardNext[child.shard] < shardItems[child.shard].size()) {
+            ChildRun restart;
+            pid_t newPid = startChild(child.shard, func, restart);
+            running[newPid] = restart;
+        }
+    }
+
+    u64_t result = 0;
+    for (u32_t s = 0; s < shardNum; ++s)
+        result += stats[s].result;
+    return result;
+}
+
+void ProcessShards::printResults() const {
+    for (u32_t s = 0; s < shardNum; ++s) {
+        outs() << stats[s].out;
+        errs() << stats[s].err;
+    }
+
+    outs() << "\n==---------Shards---------==\n";
+    for (u32_t s = 0; s < shardNum; ++s) {
+        const ShardStat& stat = stats[s];
+        outs() << "Shard " << s << ": " << stat.doneNum << "/" << stat.itemNum << " done, "
+               << stat.timedOutItems.size() << " timed out, " << stat.crashedItems.size() << " crashed, "
+               << stat.processNum << " processes\n";
+    }
+}
@@ -29,7 +29,9 @@
 
 #include "MemoryModel/PAG.h"
 #include "WPA/Andersen.h"
+#include "WPA/OfflineConsG.h"
 #include "Util/AnalysisUtil.h"
+#include "Util/CPPUtil.h"
 
 #include <llvm/Support/CommandLine.h> // for tool output file
 
@@ -53,12 +55,26 @@ Size_t Andersen::MaxPointsToSetSize = 0;
 double Andersen::timeOfProcessCopyGep = 0;
 double Andersen::timeOfProcessLoadStore = 0;
 double Andersen::timeOfUpdateCallGraph = 0;
+Size_t Andersen::numOfOfflineMergedNodes = 0;
+Size_t Andersen::numOfOfflineRemovedEdges = 0;
+Size_t Andersen::numOfHCDMerges = 0;
+Size_t Andersen::numOfIndCallPtrUpdates = 0;
+double Andersen::timeOfOfflineReduction = 0;
 
 
 static cl::opt<string> WriteAnder("write-ander",  cl::init(""),
                                   cl::desc("Write Andersen's analysis results to a file"));
 static cl::opt<string> ReadAnder("read-ander",  cl::init(""),
                                  cl::desc("Read Andersen's analysis results from a file"));
+static cl::opt<string> AnderCache("ander-cache",  cl::init(""),
+                                  cl::desc("Reuse Andersen's analysis results from a binary cache file, or solve and write it if it is missing or stale"));
+static cl::opt<bool> AnderIncCallGraph("ander-inc-cg", cl::init(true),
+                                       cl::desc("Re-resolve only the indirect callsites whose function pointers gained objects"));
+static cl::opt<WPAWorkList::Policy> AnderWorkList("ander-wl", cl::init(WPAWorkList::FIFO_WL),
+        cl::desc("Worklist order of Andersen's analysis"),
+        WPAWorkList::getPolicyValues());
+static cl::opt<bool> AnderHVN("ander-hvn", cl::init(false),
+                              cl::desc("Merge pointer-equivalent and offline cycle nodes of the constraint graph before solving"));
 
 
 /*!
@@ -77,9 +93,16 @@ bool Andersen::runOnModule(llvm::Module& module) {
 void Andersen::analyze(llvm::Module& module) {
     /// Initialization for the Solver
     initialize(module);
+    setWorkListPolicy(AnderWorkList);
 
     bool readResultsFromFile = false;
-    if(!ReadAnder.empty())
+    u64_t cacheFingerprint = 0;
+    if(!AnderCache.empty()) {
+        cacheFingerprint = this->getResultFingerprint();
+        readResultsFromFile = this->readFromBinaryFile(AnderCache, cacheFingerprint);
+        readFromCache = readResultsFromFile;
+    }
+    else if(!ReadAnder.empty())
         readResultsFromFile = this->readFromFile(ReadAnder);
 
     if(!readResultsFromFile) {
@@ -87,6 +110,9 @@ void Andersen::analyze(llvm::Module& module) {
 
         processAllAddr();
 
+        if (AnderHVN)
+            reduceConstraintGraph();
+
         do {
             numOfIteration++;
 
@@ -113,6 +139,9 @@ void Andersen::analyze(llvm::Module& module) {
         finalize();
     }
 
+    if(!AnderCache.empty() && !readFromCache)
+        this->writeToBinaryFile(AnderCache, cacheFingerprint);
+
     if(!WriteAnder.empty())
         this->writeToFile(WriteAnder);
 }
@@ -129,6 +158,13 @@ void Andersen::processNode(NodeID nodeId) {
         dumpStat();
     }
 
+    if (!hcdTargets.empty()) {
+        mergeHCDCycle(nodeId);
+        /// the node itself may be merged into the cycle
+        if (sccRepNode(nodeId) != nodeId)
+            return;
+    }
+
     ConstraintNode* node = consCG->getConstraintNode(nodeId);
 
     for (ConstraintNode::const_iterator it = node->outgoingAddrsBegin(), eit =
@@ -164,6 +200,85 @@ void Andersen::processNode(NodeID nodeId) {
     }
 }
 
+/*!
+ * Number of edges in the constraint graph
+ */
+static Size_t getCGEdgeNum(ConstraintGraph* consCG) {
+    return consCG->getAddrCGEdges().size() + consCG->getDirectCGEdges().size()
+           + consCG->getLoadCGEdges().size() + consCG->getStoreCGEdges().size();
+}
+
+/*!
+ * Merge the groups found by the offline analysis, the address edges have been processed
+ * so that the points-to sets of the merged nodes are kept in their reps
+ */
+void Andersen::reduceConstraintGraph() {
+    double reduceStart = stat->getClk();
+    Size_t edgeNum = getCGEdgeNum(consCG);
+
+    OfflineConsG offline(consCG, pag);
+    offline.compute();
+
+    NodeBS changedRepNodes;
+    const OfflineConsG::NodeGroups& groups = offline.getMergeGroups();
+    for (OfflineConsG::NodeGroups::const_iterator it = groups.begin(), eit = groups.end(); it != eit; ++it) {
+        NodeID repNodeId = it->front();
+        for (OfflineConsG::NodeVec::const_iterator nit = it->begin() + 1, enit = it->end(); nit != enit; ++nit) {
+            mergeNodeToRep(*nit, repNodeId);
+            changedRepNodes.set(*nit);
+        }
+        if (!getPts(repNodeId).empty())
+            pushIntoWorklist(repNodeId);
+    }
+    for (NodeBS::iterator it = changedRepNodes.begin(), eit = changedRepNodes.end(); it != eit; ++it)
+        updateNodeRepAndSubs(*it);
+    numOfOfflineMergedNodes += changedRepNodes.count();
+
+    /// the pointers may have been merged as well
+    hcdTargets.clear();
+    const ConstraintGraph::NodeToRepMap& targets = offline.getHCDTargets();
+    for (ConstraintGraph::NodeToRepMap::const_iterator it = targets.begin(), eit = targets.end(); it != eit; ++it)
+        hcdTargets[sccRepNode(it->first)] = it->second;
+
+    Size_t newEdgeNum = getCGEdgeNum(consCG);
+    numOfOfflineRemovedEdges += edgeNum > newEdgeNum ? edgeNum - newEdgeNum : 0;
+
+    double reduceEnd = stat->getClk();
+    timeOfOfflineReduction += (reduceEnd - reduceStart) / TIMEINTERVAL;
+
+    DBOUT(DGENERAL, llvm::outs() << analysisUtil::pasMsg("Offline reduction: ") << offline.getSCCNum() << " SCCs, "
+          << offline.getLabelNum() << " labels, " << changedRepNodes.count() << " nodes merged\n");
+}
+
+/*!
+ * Every object pointed to by the node is in a cycle with the target of the node,
+ * merge them before the copies through the loads and stores are added
+ */
+void Andersen::mergeHCDCycle(NodeID nodeId) {
+    ConstraintGraph::NodeToRepMap::const_iterator it = hcdTargets.find(nodeId);
+    if (it == hcdTargets.end())
+        return;
+
+    NodeID repNodeId = sccRepNode(it->second);
+    NodeBS changedRepNodes;
+    /// the points-to set of the node may grow during the merges, iterate over a clone
+    PointsTo pts = getPts(nodeId);
+    for (PointsTo::iterator pit = pts.begin(), epit = pts.end(); pit != epit; ++pit) {
+        NodeID objRepId = sccRepNode(*pit);
+        if (objRepId == repNodeId || !consCG->hasConstraintNode(objRepId))
+            continue;
+        mergeNodeToRep(objRepId, repNodeId);
+        changedRepNodes.set(objRepId);
+    }
+    if (changedRepNodes.empty())
+        return;
+
+    for (NodeBS::iterator nit = changedRepNodes.begin(), enit = changedRepNodes.end(); nit != enit; ++nit)
+        updateNodeRepAndSubs(*nit);
+    numOfHCDMerges += changedRepNodes.count();
+    pushIntoWorklist(repNodeId);
+}
+
 /*!
  * Process address edges
  */
@@ -261,10 +376,22 @@ void Andersen::processGep(NodeID node, const GepCGEdge* edge) {
  * Compute points-to for gep edges
  */
 void Andersen::processGepPts(PointsTo& pts, const GepCGEdge* edge)
+{
+    PointsTo tmpDstPts;
+    computeGepPts(pts, edge, tmpDstPts);
+
+    NodeID dstId = edge->getDstID();
+    if (unionPts(dstId, tmpDstPts))
+        pushIntoWorklist(dstId);
+}
+
+/*!
+ * Compute the points-to of the destination of a gep edge from the points-to of its source
+ */
+void Andersen::computeGepPts(PointsTo& pts, const GepCGEdge* edge, PointsTo& tmpDstPts)
 {
     numOfProcessedGep++;
 
-    PointsTo tmpDstPts;
     for (PointsTo::iterator piter = pts.begin(), epiter = pts.end(); piter != epiter; ++piter) {
         /// get the object
         NodeID ptd = *piter;
@@ -299,10 +426,6 @@ void Andersen::processGepPts(PointsTo& pts, const GepCGEdge* edge)
             }
         }
     }
-
-    NodeID dstId = edge->getDstID();
-    if (unionPts(dstId, tmpDstPts))
-        pushIntoWorklist(dstId);
 }
 
 /*
@@ -404,9 +527,9 @@ bool Andersen::collapseField(NodeID nodeId)
             for (PointsTo::iterator ptdIt = revPts.begin(), ptdEit = revPts.end();
                     ptdIt != ptdEit; ptdIt++) {
                 // change the points-to target from field to base node
-                PointsTo & pts = getPts(*ptdIt);
-                pts.reset(fieldId);
-                pts.set(baseId);
+                NodeID ptrId = sccRepNode(*ptdIt);
+                getPTDataTy()->removePts(ptrId, fieldId);
+                getPTDataTy()->addPts(ptrId, baseId);
 
                 changed = true;
             }
@@ -474,6 +597,65 @@ bool Andersen::updateCallGraph(const CallSiteToFunPtrMap& callsites) {
     return false;
 }
 
+/*!
+ * On the fly call graph construction, restricted to the function pointers whose
+ * points-to sets grew since they were last resolved. Only the new objects are
+ * resolved for a non-virtual callsite, since the old ones already have their
+ * edges; a virtual callsite is resolved again with the whole set of its vtable
+ * pointer. Other callsite maps than the PAG's one are resolved in full.
+ */
+void Andersen::onTheFlyCallGraphSolve(const CallSiteToFunPtrMap& callsites, CallEdgeMap& newEdges,llvm::CallGraph* callgraph) {
+    if (!AnderIncCallGraph || &callsites != &getIndirectCallsites()) {
+        BVDataPTAImpl::onTheFlyCallGraphSolve(callsites, newEdges, callgraph);
+        return;
+    }
+
+    /// the indirect callsites are fixed once the PAG is built, index their pointers once
+    if (resolvedFunPtrPts.empty() && vtblToCallSites.empty()) {
+        for(CallSiteToFunPtrMap::const_iterator iter = callsites.begin(), eiter = callsites.end(); iter!=eiter; ++iter) {
+            llvm::CallSite cs = iter->first;
+            if (cppUtil::isVirtualCallSite(cs)) {
+                const llvm::Value *vtbl = cppUtil::getVCallVtblPtr(cs);
+                assert(pag->hasValueNode(vtbl));
+                NodeID vtblId = pag->getValueNode(vtbl);
+                vtblToCallSites[vtblId].push_back(cs);
+                resolvedVtblPts[vtblId];
+            }
+            else
+                resolvedFunPtrPts[iter->second];
+        }
+    }
+
+    PointsTo newPts;
+    for(NodeToPTSMap::iterator it = resolvedFunPtrPts.begin(), eit = resolvedFunPtrPts.end(); it!=eit; ++it) {
+        NodeID funPtr = it->first;
+        newPts.intersectWithComplement(getPts(funPtr), it->second);
+        if (newPts.empty())
+            continue;
+        it->second |= newPts;
+        numOfIndCallPtrUpdates++;
+
+        const PAG::CallSiteSet& css = pag->getIndCallSites(funPtr);
+        for(PAG::CallSiteSet::const_iterator cit = css.begin(), ecit = css.end(); cit!=ecit; ++cit) {
+            if (!cppUtil::isVirtualCallSite(*cit))
+                resolveIndCalls(*cit, newPts, newEdges, callgraph);
+        }
+    }
+
+    for(NodeToPTSMap::iterator it = resolvedVtblPts.begin(), eit = resolvedVtblPts.end(); it!=eit; ++it) {
+        NodeID vtblId = it->first;
+        const PointsTo& pts = getPts(vtblId);
+        if (it->second.contains(pts))
+            continue;
+        it->second |= pts;
+        numOfIndCallPtrUpdates++;
+
+        const std::vector<llvm::CallSite>& css = vtblToCallSites[vtblId];
+        for(std::vector<llvm::CallSite>::const_iterator cit = css.begin(), ecit = css.end(); cit!=ecit; ++cit)
+            resolveCPPIndCalls(*cit, pts, newEdges, callgraph);
+    }
+}
+
 /*
  * Merge a node to its rep node
  */
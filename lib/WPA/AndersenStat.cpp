@@ -39,7 +39,17 @@ u32_t AndersenStat::_NumOfNodesInCycles = 0;
 u32_t AndersenStat::_MaxNumOfNodesInSCC = 0;
 
 const char* AndersenStat::CollapseTime = "CollapseTime";
+const char* AndersenStat::OfflineReductionTime = "OfflineReduceTime";
 const char* AndersenStat::NumberOfCGNode = "CGNodeNum";
+const char* AndersenStat::NumOfOfflineMergedNodes = "OfflineMergedNodes";
+const char* AndersenStat::NumOfOfflineRemovedEdges = "OfflineRemovedEdges";
+const char* AndersenStat::NumOfHCDMerges = "HCDMergedNodes";
+const char* AndersenStat::NumOfIndCallPtrUpdates = "IndCallPtrUpdates";
+const char* AndersenStat::NumOfSharedPtsSets = "SharedPtsSets";
+const char* AndersenStat::NumOfSharedPtsTargets = "SharedPtsTargets";
+const char* AndersenStat::NumOfUnsharedPtsTargets = "UnsharedPtsTargets";
+const char* AndersenStat::NumOfUnionCacheLookups = "UnionCacheLookups";
+const char* AndersenStat::UnionCacheHitRate = "UnionCacheHitRate";
 
 /*!
  * Constructor
@@ -197,6 +207,7 @@ void AndersenStat::performStat() {
     timeStatMap[SCCDetectionTime] = Andersen::timeOfSCCDetection;
     timeStatMap[SCCMergeTime] =  Andersen::timeOfSCCMerges;
     timeStatMap[CollapseTime] =  Andersen::timeOfCollapse;
+    timeStatMap[OfflineReductionTime] = Andersen::timeOfOfflineReduction;
 
     timeStatMap[ProcessLoadStoreTime] =  Andersen::timeOfProcessLoadStore;
     timeStatMap[ProcessCopyGepTime] =  Andersen::timeOfProcessCopyGep;
@@ -234,6 +245,7 @@ void AndersenStat::performStat() {
     PTNumStatMap[MaxPointsToSetSize] = _MaxPtsSize;
 
     PTNumStatMap[NumOfIterations] = pta->numOfIteration;
+    PTNumStatMap[pta->getProcessedNodesStatName()] = pta->getNumOfProcessedNodes();
 
     PTNumStatMap[NumOfIndirectCallSites] = consCG->getIndirectCallsites().size();
     PTNumStatMap[NumOfIndirectEdgeSolved] = pta->getNumOfResolvedIndCallEdge();
@@ -243,10 +255,24 @@ void AndersenStat::performStat() {
     PTNumStatMap[NumOfPWCCycles] = _NumOfPWCCycles;
     PTNumStatMap[NumOfNodesInCycles] = _NumOfNodesInCycles;
     PTNumStatMap[MaxNumOfNodesInSCC] = _MaxNumOfNodesInSCC;
+    PTNumStatMap[NumOfOfflineMergedNodes] = Andersen::numOfOfflineMergedNodes;
+    PTNumStatMap[NumOfOfflineRemovedEdges] = Andersen::numOfOfflineRemovedEdges;
+    PTNumStatMap[NumOfHCDMerges] = Andersen::numOfHCDMerges;
+    PTNumStatMap[NumOfIndCallPtrUpdates] = Andersen::numOfIndCallPtrUpdates;
     PTNumStatMap[NumOfNullPointer] = _NumOfNullPtr;
     PTNumStatMap["PointsToConstPtr"] = _NumOfConstantPtr;
     PTNumStatMap["PointsToBlkPtr"] = _NumOfBlackholePtr;
 
+    /// memory of the shared points-to sets, compared with one set per pointer
+    if (const BVDataPTAImpl::HashConsPTDataTy* hcD = pta->getHashConsPTDataTy()) {
+        PTNumStatMap[NumOfSharedPtsSets] = hcD->getPtsSetNum();
+        PTNumStatMap[NumOfSharedPtsTargets] = hcD->getSharedTargetNum();
+        PTNumStatMap[NumOfUnsharedPtsTargets] = hcD->getTotalTargetNum();
+        PTNumStatMap[NumOfUnionCacheLookups] = hcD->getUnionLookups();
+        u32_t lookups = hcD->getUnionLookups();
+        timeStatMap[UnionCacheHitRate] = lookups ? (double)hcD->getUnionHits() / lookups : 0;
+    }
+
     printStat();
 
 }
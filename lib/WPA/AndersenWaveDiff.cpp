@@ -28,23 +28,78 @@
  */
 
 #include "WPA/Andersen.h"
+#include "Util/ThreadPool.h"
 #include <llvm/Support/CommandLine.h> // for tool output file
 
 using namespace llvm;
 using namespace analysisUtil;
 
+static cl::opt<unsigned> AnderThreads("ander-threads", cl::init(0),
+                                      cl::desc("Number of shards propagating the copy/gep points-to of the diff wave solver on the thread pool (0: serial)"));
+
+/// Unions handed to a shard at once
+static const u32_t UnionBatchSize = 256;
+
 AndersenWaveDiff* AndersenWaveDiff::diffWave = NULL;
 
+AndersenWaveDiff::AndersenWaveDiff(PTATY type): AndersenWave(type), shardNum(AnderThreads) {
+    batches.resize(shardNum);
+    shardJobs.resize(shardNum);
+    pendingDsts.resize(shardNum);
+}
+
+/*!
+ * In the parallel mode, the copy/gep unions of the topological pass run on the shards
+ * while the nodes are visited in the serial order, and are flushed before the loads and stores
+ */
+void AndersenWaveDiff::solve() {
+    if (!isParallel()) {
+        AndersenWave::solve();
+        return;
+    }
+
+    NodeStack& nodeStack = SCCDetect();
+    rankWorklist(nodeStack);
+    while (!nodeStack.empty()) {
+        NodeID nodeId = nodeStack.top();
+        nodeStack.pop();
+        fireNode(nodeId);
+        processNode(nodeId);
+    }
+    flushUnions();
+
+    while (!isWorklistEmpty()) {
+        NodeID nodeId = popFromWorklist();
+        postProcessNode(nodeId);
+    }
+}
+
+/*!
+ * Collapsing a PWC node rewrites the points-to of other nodes, flush the unions first
+ */
+void AndersenWaveDiff::processNode(NodeID nodeId) {
+    if (isParallel() && consCG->isPWCNode(nodeId))
+        flushUnions();
+    AndersenWave::processNode(nodeId);
+}
+
 
 /*!
  * Compute diff points-to set before propagation
  */
 void AndersenWaveDiff::handleCopyGep(ConstraintNode* node)
 {
+    if (isParallel())
+        waitForPts(sccRepNode(node->getId()));
+
     computeDiffPts(node->getId());
 
     if (!getDiffPts(node->getId()).empty())
         AndersenWave::handleCopyGep(node);
+
+    /// the fields are collapsed next, which rewrites the points-to of other nodes
+    if (isParallel() && consCG->hasNodesToBeCollapsed())
+        flushUnions();
 }
 
 /*!
@@ -58,6 +113,11 @@ bool AndersenWaveDiff::processCopy(NodeID node, const ConstraintEdge* edge) {
     NodeID dst = edge->getDstID();
     PointsTo& srcDiffPts = getDiffPts(node);
     processCast(edge);
+    /// the result is known once the union is flushed
+    if (isParallel()) {
+        scheduleUnion(addUnion(dst, &srcDiffPts));
+        return false;
+    }
     if(unionPts(dst,srcDiffPts)) {
         changed = true;
         pushIntoWorklist(dst);
@@ -71,7 +131,14 @@ bool AndersenWaveDiff::processCopy(NodeID node, const ConstraintEdge* edge) {
  */
 void AndersenWaveDiff::processGep(NodeID node, const GepCGEdge* edge) {
     PointsTo& srcDiffPts = getDiffPts(edge->getSrcID());
-    processGepPts(srcDiffPts, edge);
+    if (isParallel()) {
+        PtsUnion& u = addUnion(edge->getDstID(), NULL);
+        computeGepPts(srcDiffPts, edge, u.gepPts);
+        u.srcPts = &u.gepPts;
+        scheduleUnion(u);
+    }
+    else
+        processGepPts(srcDiffPts, edge);
 }
 
 /*!
@@ -155,3 +222,94 @@ void AndersenWaveDiff::mergeNodeToRep(NodeID nodeId,NodeID newRepId) {
 
     Andersen::mergeNodeToRep(nodeId, newRepId);
 }
+
+/*!
+ * The points-to of the destination is looked up here, the shards never touch the points-to maps
+ */
+AndersenWaveDiff::PtsUnion& AndersenWaveDiff::addUnion(NodeID dst, const PointsTo* srcPts) {
+    unions.push_back(PtsUnion());
+    PtsUnion& u = unions.back();
+    u.dst = dst;
+    u.dstPts = &getPTDataTy()->getPts(dst);
+    u.srcPts = srcPts;
+    u.changed = false;
+    return u;
+}
+
+void AndersenWaveDiff::scheduleUnion(PtsUnion& u) {
+    u32_t shard = u.dst % shardNum;
+    batches[shard].push_back(&u);
+    pendingDsts[shard].set(u.dst);
+    if (batches[shard].size() >= UnionBatchSize)
+        submitShard(shard);
+}
+
+/*!
+ * A job of a shard starts after the previous one, the thread pool is FIFO so that one is already running
+ */
+void AndersenWaveDiff::submitShard(u32_t shard) {
+    if (batches[shard].empty())
+        return;
+
+    PtsUnionBatch batch;
+    batch.swap(batches[shard]);
+    std::shared_future<void> prev = shardJobs[shard];
+    shardJobs[shard] = ThreadPool::getThreadPool()->enqueue([prev, batch]() {
+        if (prev.valid())
+            prev.wait();
+        for (PtsUnionBatch::const_iterator it = batch.begin(), eit = batch.end(); it != eit; ++it)
+            (*it)->changed = (*(*it)->dstPts |= *(*it)->srcPts);
+    }).share();
+}
+
+void AndersenWaveDiff::waitShard(u32_t shard) {
+    submitShard(shard);
+    if (shardJobs[shard].valid())
+        shardJobs[shard].wait();
+    pendingDsts[shard].clear();
+}
+
+void AndersenWaveDiff::waitForPts(NodeID id) {
+    u32_t shard = id % shardNum;
+    if (pendingDsts[shard].test(id))
+        waitShard(shard);
+}
+
+/*!
+ * The reverse points-to are updated by the shards of the objects,
+ * their entries are created before so the shards only look them up
+ */
+void AndersenWaveDiff::flushUnions() {
+    if (unions.empty())
+        return;
+
+    for (u32_t shard = 0; shard < shardNum; ++shard)
+        waitShard(shard);
+
+    NodeBS objs;
+    for (PtsUnionQueue::const_iterator it = unions.begin(), eit = unions.end(); it != eit; ++it)
+        objs |= *it->srcPts;
+    for (NodeBS::iterator it = objs.begin(), eit = objs.end(); it != eit; ++it)
+        getPTDataTy()->getRevPts(*it);
+
+    std::vector<std::future<void> > revJobs;
+    for (u32_t shard = 0; shard < shardNum; ++shard) {
+        revJobs.push_back(ThreadPool::getThreadPool()->enqueue([this, shard]() {
+            for (PtsUnionQueue::const_iterator it = unions.begin(), eit = unions.end(); it != eit; ++it) {
+                for (PointsTo::iterator pit = it->srcPts->begin(), epit = it->srcPts->end(); pit != epit; ++pit) {
+                    if (*pit % shardNum == shard)
+                        getPTDataTy()->getRevPts(*pit).set(it->dst);
+                }
+            }
+        }));
+    }
+    for (u32_t i = 0; i < revJobs.size(); ++i)
+        revJobs[i].wait();
+
+    /// the worklist is updated in the serial order
+    for (PtsUnionQueue::const_iterator it = unions.begin(), eit = unions.end(); it != eit; ++it) {
+        if (it->changed)
+            pushIntoWorklist(it->dst);
+    }
+    unions.clear();
+}
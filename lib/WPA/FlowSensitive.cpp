@@ -31,10 +31,15 @@
 #include "WPA/FlowSensitive.h"
 #include "WPA/Andersen.h"
 #include <llvm/Support/Debug.h>		// DEBUG TYPE
+#include <llvm/Support/CommandLine.h>
 
 using namespace llvm;
 
 
+static cl::opt<WPAWorkList::Policy> FSWorkList("fs-wl", cl::init(WPAWorkList::FIFO_WL),
+        cl::desc("Worklist order of the flow-sensitive analysis"),
+        WPAWorkList::getPolicyValues());
+
 FlowSensitive* FlowSensitive::fspta = NULL;
 
 /*!
@@ -57,6 +62,7 @@ void FlowSensitive::initialize(llvm::Module& module) {
 void FlowSensitive::analyze(llvm::Module& module) {
     /// Initialization for the Solver
     initialize(module);
+    setWorkListPolicy(FSWorkList);
 
     double start = stat->getClk();
     /// Start solving constraints
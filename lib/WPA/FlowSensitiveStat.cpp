@@ -155,6 +155,7 @@ void FlowSensitiveStat::performStat()
     PTNumStatMap[NumOfStores] = numOfStore;
 
     PTNumStatMap[NumOfIterations] = fspta->numOfIteration;
+    PTNumStatMap[fspta->getProcessedNodesStatName()] = fspta->getNumOfProcessedNodes();
 
     PTNumStatMap[NumOfIndirectEdgeSolved] = fspta->getNumOfResolvedIndCallEdge();
 
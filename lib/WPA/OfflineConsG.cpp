@@ -0,0 +1,319 @@
+//===- OfflineConsG.cpp -- Offline reduction of the constraint graph----------//
+//
+//                     SVF: Static Value-Flow Analysis
+//
+// Copyright (C) <2013-2016>  <Yulei Sui>
+// Copyright (C) <2013-2016>  <Jingling Xue>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//===----------------------------------------------------------------------===//
+
+/*
+ * OfflineConsG.cpp
+ */
+
+#include "WPA/OfflineConsG.h"
+#include "MemoryModel/PAG.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+void OfflineConsG::compute() {
+    buildGraph();
+    markIndirectNodes();
+    findSCCs();
+    labelSCCs();
+    collectResults();
+}
+
+/*!
+ * The graph is built from the current rep nodes, the address edges are not part of it
+ * but give the labels of their destinations
+ */
+void OfflineConsG::buildGraph() {
+    nodeNum = 0;
+    for (ConstraintGraph::iterator it = consCG->begin(), eit = consCG->end(); it != eit; ++it)
+        nodeNum = std::max(nodeNum, it->first + 1);
+
+    succs.assign(2 * nodeNum, OffEdgeVec());
+    present.assign(2 * nodeNum, false);
+
+    for (ConstraintGraph::iterator it = consCG->begin(), eit = consCG->end(); it != eit; ++it) {
+        NodeID id = it->first;
+        ConstraintNode* node = it->second;
+        present[id] = true;
+
+        for (ConstraintNode::const_iterator edgeIt = node->directOutEdgeBegin(), edgeEit = node->directOutEdgeEnd();
+                edgeIt != edgeEit; ++edgeIt)
+            succs[id].push_back(OffEdge((*edgeIt)->getDstID(), dyn_cast<GepCGEdge>(*edgeIt)));
+
+        /// q = *p
+        for (ConstraintNode::const_iterator edgeIt = node->outgoingLoadsBegin(), edgeEit = node->outgoingLoadsEnd();
+                edgeIt != edgeEit; ++edgeIt) {
+            present[refNode(id)] = true;
+            succs[refNode(id)].push_back(OffEdge((*edgeIt)->getDstID(), NULL));
+        }
+
+        /// *p = q
+        for (ConstraintNode::const_iterator edgeIt = node->outgoingStoresBegin(), edgeEit = node->outgoingStoresEnd();
+                edgeIt != edgeEit; ++edgeIt) {
+            u32_t ref = refNode((*edgeIt)->getDstID());
+            present[ref] = true;
+            succs[id].push_back(OffEdge(ref, NULL));
+        }
+    }
+}
+
+/*!
+ * Indirect nodes get points-to targets not flowing through the offline edges:
+ * the objects (through stores), the ref nodes, and the parameters and returns
+ * connected when the indirect calls are resolved
+ */
+void OfflineConsG::markIndirectNodes() {
+    indirect.assign(2 * nodeNum, false);
+
+    for (u32_t n = 0; n < 2 * nodeNum; ++n) {
+        if (!present[n])
+            continue;
+        if (isRefNode(n) || isa<ObjPN>(pag->getPAGNode(n)))
+            indirect[n] = true;
+    }
+
+    /// formal parameters of the functions which may be called indirectly
+    PAG::FunToArgsListMap& funArgs = pag->getFunArgsMap();
+    for (PAG::FunToArgsListMap::iterator it = funArgs.begin(), eit = funArgs.end(); it != eit; ++it) {
+        const Function* fun = it->first;
+        if (!fun->hasAddressTaken())
+            continue;
+        for (PAG::PAGNodeList::iterator ait = it->second.begin(), eait = it->second.end(); ait != eait; ++ait) {
+            NodeID arg = (*ait)->getId();
+            if (arg < nodeNum)
+                indirect[arg] = true;
+        }
+        if (fun->isVarArg()) {
+            NodeID vaArg = consCG->getVarargNode(fun);
+            if (vaArg < nodeNum)
+                indirect[vaArg] = true;
+        }
+    }
+
+    /// returns received at the indirect callsites
+    const PAG::CallSiteToFunPtrMap& callsites = consCG->getIndirectCallsites();
+    for (PAG::CallSiteToFunPtrMap::const_iterator it = callsites.begin(), eit = callsites.end(); it != eit; ++it) {
+        if (!pag->callsiteHasRet(it->first))
+            continue;
+        NodeID ret = pag->getCallSiteRet(it->first)->getId();
+        if (ret < nodeNum)
+            indirect[ret] = true;
+    }
+}
+
+/*!
+ * Iterative Tarjan's algorithm, an SCC is completed after all its successors,
+ * so the SCCs are found in the reverse topological order
+ */
+void OfflineConsG::findSCCs() {
+    const u32_t unvisited = ~0U;
+    u32_t total = 2 * nodeNum;
+    LabelVec index(total, unvisited);
+    LabelVec lowLink(total, 0);
+    std::vector<bool> onStack(total, false);
+    LabelVec sccStack;
+    std::vector<std::pair<u32_t, u32_t> > dfsStack;	///< node and the position of its next successor
+    u32_t nextIndex = 0;
+
+    sccOf.assign(total, unvisited);
+    sccs.clear();
+
+    for (u32_t root = 0; root < total; ++root) {
+        if (!present[root] || index[root] != unvisited)
+            continue;
+
+        dfsStack.push_back(std::make_pair(root, 0));
+        index[root] = lowLink[root] = nextIndex++;
+        sccStack.push_back(root);
+        onStack[root] = true;
+
+        while (!dfsStack.empty()) {
+            u32_t n = dfsStack.back().first;
+            u32_t& pos = dfsStack.back().second;
+            if (pos < succs[n].size()) {
+                u32_t s = succs[n][pos++].dst;
+                if (index[s] == unvisited) {
+                    index[s] = lowLink[s] = nextIndex++;
+                    sccStack.push_back(s);
+                    onStack[s] = true;
+                    dfsStack.push_back(std::make_pair(s, 0));
+                }
+                else if (onStack[s]) {
+                    lowLink[n] = std::min(lowLink[n], index[s]);
+                }
+                continue;
+            }
+
+            dfsStack.pop_back();
+            if (!dfsStack.empty()) {
+                u32_t parent = dfsStack.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[n]);
+            }
+            if (lowLink[n] != index[n])
+                continue;
+
+            u32_t scc = sccs.size();
+            sccs.push_back(LabelVec());
+            u32_t member;
+            do {
+                member = sccStack.back();
+                sccStack.pop_back();
+                onStack[member] = false;
+                sccOf[member] = scc;
+                sccs.back().push_back(member);
+            } while (member != n);
+        }
+    }
+}
+
+bool OfflineConsG::hasGepInside(u32_t scc) const {
+    for (LabelVec::const_iterator it = sccs[scc].begin(), eit = sccs[scc].end(); it != eit; ++it) {
+        for (OffEdgeVec::const_iterator sit = succs[*it].begin(), esit = succs[*it].end(); sit != esit; ++sit) {
+            if (sit->gep && sccOf[sit->dst] == scc)
+                return true;
+        }
+    }
+    return false;
+}
+
+u32_t OfflineConsG::getGepLabel(u32_t srcLabel, const GepCGEdge* gep) {
+    if (const NormalGepCGEdge* normalGep = dyn_cast<NormalGepCGEdge>(gep)) {
+        u32_t& label = gepLabels[std::make_pair(srcLabel, normalGep->getLocationSet())];
+        if (label == 0)
+            label = newLabel();
+        return label;
+    }
+    u32_t& label = variantGepLabels[srcLabel];
+    if (label == 0)
+        label = newLabel();
+    return label;
+}
+
+/*!
+ * Hash-based value numbering, the labels of the predecessors of an SCC are known
+ * when it is reached in the topological order
+ */
+void OfflineConsG::labelSCCs() {
+    labels.assign(2 * nodeNum, 0);
+    std::vector<LabelVec> inLabels(sccs.size());
+
+    for (u32_t n = 0; n < nodeNum; ++n) {
+        if (!present[n])
+            continue;
+        ConstraintNode* node = consCG->getConstraintNode(n);
+        for (ConstraintNode::const_iterator it = node->incomingAddrsBegin(), eit = node->incomingAddrsEnd();
+                it != eit; ++it) {
+            u32_t& label = addrLabels[(*it)->getSrcID()];
+            if (label == 0)
+                label = newLabel();
+            inLabels[sccOf[n]].push_back(label);
+        }
+    }
+
+    for (u32_t scc = sccs.size(); scc-- > 0;) {
+        const LabelVec& members = sccs[scc];
+
+        bool fresh = hasGepInside(scc);
+        for (LabelVec::const_iterator it = members.begin(), eit = members.end(); it != eit && !fresh; ++it)
+            fresh = indirect[*it];
+
+        u32_t label = 0;
+        LabelVec& in = inLabels[scc];
+        if (fresh) {
+            label = newLabel();
+        }
+        else if (!in.empty()) {
+            std::sort(in.begin(), in.end());
+            in.erase(std::unique(in.begin(), in.end()), in.end());
+            if (in.size() == 1) {
+                label = in.front();
+            }
+            else {
+                u32_t& setLabel = setLabels[in];
+                if (setLabel == 0)
+                    setLabel = newLabel();
+                label = setLabel;
+            }
+        }
+        LabelVec().swap(in);
+
+        for (LabelVec::const_iterator it = members.begin(), eit = members.end(); it != eit; ++it) {
+            labels[*it] = label;
+            if (label == 0)
+                continue;
+            for (OffEdgeVec::const_iterator sit = succs[*it].begin(), esit = succs[*it].end(); sit != esit; ++sit) {
+                u32_t dstScc = sccOf[sit->dst];
+                if (dstScc == scc)
+                    continue;
+                inLabels[dstScc].push_back(sit->gep ? getGepLabel(label, sit->gep) : label);
+            }
+        }
+    }
+}
+
+/*!
+ * Nodes sharing a non-zero label are merged, as well as the nodes of an SCC labeled 0.
+ * The hybrid cycle detection pairs are taken from the SCCs without gep edges inside,
+ * the others become PWC nodes once merged and are collapsed by the solver.
+ */
+void OfflineConsG::collectResults() {
+    mergeGroups.clear();
+    hcdTargets.clear();
+
+    std::map<u32_t, NodeVec> labelToNodes;
+    for (u32_t scc = 0; scc < sccs.size(); ++scc) {
+        NodeVec vars;
+        NodeVec refs;
+        for (LabelVec::const_iterator it = sccs[scc].begin(), eit = sccs[scc].end(); it != eit; ++it) {
+            if (isRefNode(*it))
+                refs.push_back(*it - nodeNum);
+            else
+                vars.push_back(*it);
+        }
+        if (vars.empty())
+            continue;
+
+        std::sort(vars.begin(), vars.end());
+        u32_t label = labels[vars.front()];
+        if (label != 0) {
+            NodeVec& nodes = labelToNodes[label];
+            nodes.insert(nodes.end(), vars.begin(), vars.end());
+        }
+        else if (vars.size() > 1) {
+            mergeGroups.push_back(vars);
+        }
+
+        if (!hasGepInside(scc)) {
+            for (NodeVec::const_iterator it = refs.begin(), eit = refs.end(); it != eit; ++it)
+                hcdTargets[*it] = vars.front();
+        }
+    }
+
+    for (std::map<u32_t, NodeVec>::iterator it = labelToNodes.begin(), eit = labelToNodes.end(); it != eit; ++it) {
+        NodeVec& nodes = it->second;
+        if (nodes.size() < 2)
+            continue;
+        std::sort(nodes.begin(), nodes.end());
+        mergeGroups.push_back(nodes);
+    }
+}
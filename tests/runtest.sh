@@ -6,6 +6,8 @@
 #  ./runtest opt   run testcases with llvm opt to load your .so library
 #  Set TestFolders to indicate the testcasts you want to compile and run 
 #  Set TestScript to indicate which analysis/optimizations you want to test with
+#  Set UAFTestFolders/UAFTestScripts for the use-after-free tests
+#  The script exits with 1 if a test script reports a failure
 ################################################
 
 ##remember to run ./setup script before running testings
@@ -26,16 +28,22 @@ TestScripts="testsaber.sh"
 #	     testdvf.sh\
 #	     testmssa.sh"
 
+### Add the fold of use-after-free tests and their test shell files
+UAFTestFolders="uaf"
+UAFTestScripts="testuaf.sh"
+
+Failures=0
 
 ### remove previous compile log
 rm -rf $COMPILELOG
 
-### start testing
-for folder in $TestFolders 
+### run the test scripts ($2) on the folders ($1)
+runTests() {
+for folder in $1
   do
     echo Entering Folder $folder for testing ...
     echo "#################COMPILATION LOG##############" > $COMPILELOG
-	for testscript in $TestScripts 
+	for testscript in $2
 	do
         ### test plain c program files
 		for i in `find $folder -name '*.c'` 
@@ -46,7 +54,7 @@ for folder in $TestFolders
 		$LLVMOPT $LLVMOPTFLAG $FileName.bc -o $FileName.opt
 		echo @@@analyzing $FileName.c with $testscript 
 		$LLVMDIS $FileName.opt
-		$PTATESTSCRIPTS/$testscript $FileName.opt $TESTWITHOPT
+		$PTATESTSCRIPTS/$testscript $FileName.opt $TESTWITHOPT || Failures=$((Failures+1))
 		done
 
         ### test llvm bitcode files (located in cpu2000/cpu2006 folder)
@@ -57,8 +65,18 @@ for folder in $TestFolders
 		$LLVMOPT $LLVMOPTFLAG $i -o $FileName.opt
 		echo @@@analyzing $FileName.c with $testscript 
 		$LLVMDIS $FileName.opt
-		$PTATESTSCRIPTS/$testscript $FileName.opt $TESTWITHOPT
+		$PTATESTSCRIPTS/$testscript $FileName.opt $TESTWITHOPT || Failures=$((Failures+1))
 		done
 	done
   done
+}
+
+### start testing
+runTests "$TestFolders" "$TestScripts"
+runTests "$UAFTestFolders" "$UAFTestScripts"
 echo analysis finished
+if [[ $Failures -ne 0 ]]
+then
+  echo $Failures test runs failed
+  exit 1
+fi
@@ -0,0 +1,53 @@
+#/bin/bash
+###############################
+#
+# Script to test the use-after-free checker, change variables and options for testing
+# The expected number of reports is given in the test file by a line
+#   UAF_REPORTS: <number>
+# and checked with and without the value-flow summaries, the script exits
+# with 1 if a run reports a different number.
+#
+##############################
+
+TNAME=saber
+###########SET variables and options when testing using executable file
+EXEFILE=$PTABIN/saber    ### Add the tools here for testing
+FLAGS="-uaf -stat=false"  ### Add the FLAGS here for testing
+
+###########SET variables and options when testing using loadable so file invoked by opt
+LLVMFLAGS="-uaf-checker -stat=false -mem2reg --debug-pass=Structure "
+LIBNAME=lib$TNAME
+
+###########Flags of each run, the checker is run once per entry
+RUNFLAGS="-uaf-summary=false -uaf-summary"
+
+############don't need to touch here (please see run.sh script for meaning of the parameters)##########
+SRCFILE=$(dirname $1)/`basename $1 .opt`.c
+EXPECTED=`grep -o 'UAF_REPORTS: *[0-9]*' $SRCFILE | grep -o '[0-9]*$'`
+if [[ -z $EXPECTED ]]
+then
+  echo "FAILURE: no UAF_REPORTS line in $SRCFILE"
+  exit 1
+fi
+
+STATUS=0
+for runflag in $RUNFLAGS
+do
+  if [[ $2 == 'opt' ]]
+  then
+    OUTPUT=`$RUNSCRIPT $1 $TNAME "$LLVMFLAGS $runflag" $2`
+  else
+    OUTPUT=`$RUNSCRIPT $1 $TNAME "$FLAGS $runflag" $2`
+  fi
+  echo "$OUTPUT"
+
+  REPORTS=`echo "$OUTPUT" | grep '^Total: ' | tail -n 1 | grep -o '[0-9]*$'`
+  if [[ $REPORTS == $EXPECTED ]]
+  then
+    echo "SUCCESS: $SRCFILE ($runflag) $REPORTS reports"
+  else
+    echo "FAILURE: $SRCFILE ($runflag) ${REPORTS:-no} reports, expected $EXPECTED"
+    STATUS=1
+  fi
+done
+exit $STATUS
@@ -0,0 +1,25 @@
+/*
+ * Use after free, freed in a callee and used in its caller
+ * Date: 17/10/2026
+ *
+ * The forward search from the free in release() returns to main() through
+ * the call of release(), which is the resume point of the free. The use
+ * *p = 1 after the call must be checked (-uaf-ip-reach).
+ *
+ * Expected with -uaf, with and without -uaf-summary (checked by testuaf.sh):
+ *   one use after free, *p = 1 in main()
+ * UAF_REPORTS: 1
+ */
+
+#include "aliascheck.h"
+
+void release(int *q) {
+	free(q);
+}
+
+int main(int argc, char **argv) {
+	int *p = (int *) malloc(sizeof(int));
+	release(p);
+	*p = 1;
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Use after free, one free reached through two callers
+ * Date: 16/10/2026
+ *
+ * The backward search from the free in release() reaches the same nodes of
+ * main() through caller1() and through caller2(), and starts a forward
+ * search from them with the same node and context but a different call site
+ * freeing p (the call of caller1 or the call of caller2). The use *p = 1 is
+ * only reachable from the call of caller1, a value-flow summary of the
+ * forward search (-uaf-summary) must not be shared by the two call sites.
+ *
+ * Expected with -uaf, with and without -uaf-summary (checked by testuaf.sh):
+ *   one use after free, *p = 1 in main() (freed through caller1)
+ * UAF_REPORTS: 1
+ */
+
+#include "aliascheck.h"
+
+void release(int *q) {
+	free(q);
+}
+
+void caller1(int *p) {
+	release(p);
+}
+
+void caller2(int *p) {
+	release(p);
+}
+
+int main(int argc, char **argv) {
+	int *p = (int *) malloc(sizeof(int));
+	if (argc > 1) {
+		caller2(p);
+		return 0;
+	}
+	caller1(p);
+	*p = 1;
+	return 0;
+}
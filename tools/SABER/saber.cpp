@@ -63,6 +63,12 @@ static cl::opt<bool> DFREECHECKER("dfree", cl::init(false),
 static cl::opt<bool> UAFCHECKER("uaf", cl::init(false),
                                  cl::desc("Use After Free Detection"));
 
+static cl::opt<bool> ALLCHECKERS("all", cl::init(false),
+                                 cl::desc("Run all the checkers, several checkers share one pre-analysis"));
+
+static cl::opt<unsigned> TOPSOURCES("top-sources", cl::init(10),
+                                    cl::desc("Number of the most expensive sources to print"));
+
 Profiler *globalprofiler = nullptr;
 
 extern unsigned Index;
@@ -72,6 +78,8 @@ void timeout(int x) {
     outs() << "\n\n";
     globalprofiler->print_snapshot_result("Total");
     globalprofiler->print_peak_memory();
+    globalprofiler->print_counters();
+    globalprofiler->print_top_costs(TOPSOURCES);
     outs() << "\n Report " << Index << " bugs!\n";
     outs() << "\n[!!!] Exit because of timeout > 12 hours!\n";
     exit(0);
@@ -134,14 +142,33 @@ int main(int argc, char ** argv) {
         return 1;
     }
 
-    if(LEAKCHECKER)
-        Passes.add(new LeakChecker());
-    else if(FILECHECKER)
-        Passes.add(new FileChecker());
-    else if(DFREECHECKER)
-        Passes.add(new DoubleFreeChecker());
-    else if(UAFCHECKER)
-        Passes.add(new UseAfterFreeChecker());
+    std::vector<std::pair<const char*, ModulePass*> > Checkers;
+    if(LEAKCHECKER || ALLCHECKERS)
+        Checkers.push_back(std::make_pair("Leak", new LeakChecker()));
+    if(FILECHECKER || ALLCHECKERS)
+        Checkers.push_back(std::make_pair("File", new FileChecker()));
+    if(DFREECHECKER || ALLCHECKERS)
+        Checkers.push_back(std::make_pair("DoubleFree", new DoubleFreeChecker()));
+    if(UAFCHECKER || ALLCHECKERS)
+        Checkers.push_back(std::make_pair("UseAfterFree", new UseAfterFreeChecker()));
+
+    if(Checkers.size() == 1) {
+        Passes.add(Checkers.front().second);
+    }
+    else if(Checkers.size() > 1) {
+        /// The PTA, the SVFG and the branch conditions are built once and shared by the checkers,
+        /// which are run one after another with their own reports and timings
+        SrcSnkDDA::setSharedPreAnalysis(true);
+        for(auto& Checker : Checkers) {
+            outs() << "\n==---------Start " << Checker.first << " Checker---------==\n";
+            Profiler CheckerProfiler(Profiler::TIME | Profiler::MEMORY);
+            legacy::PassManager CheckerPasses;
+            CheckerPasses.add(Checker.second);
+            CheckerPasses.run(*M1.get());
+            CheckerProfiler.create_snapshot();
+            CheckerProfiler.print_snapshot_result(Checker.first);
+        }
+    }
 
     Passes.add(createBitcodeWriterPass(Out->os()));
 
@@ -153,6 +180,10 @@ int main(int argc, char ** argv) {
     outs() << "\n\n";
     globalprofiler->print_snapshot_result("Total");
     globalprofiler->print_peak_memory();
+    globalprofiler->print_counters();
+    globalprofiler->print_top_costs(TOPSOURCES);
+
+    SaberPreAnalysis::releaseSharedPreAnalysis();
 
     return 0;
 